@@ -0,0 +1,133 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    BranchAndBound.hpp
+ *  Created: Oct 16, 2026
+ */
+
+#ifndef BRANCHANDBOUND_HPP_
+#define BRANCHANDBOUND_HPP_
+
+#include <map>
+#include <vector>
+#include <opencv2/core/core.hpp>
+#include "Candidate.hpp"
+#include "DPTensor.hpp"
+#include "DynamicProgram.hpp"
+#include "Parts.hpp"
+#include "ResponseCache.hpp"
+#include "types.hpp"
+
+/*! @class BranchAndBound
+ *  @brief best-first search for the top scoring root locations
+ *
+ *  The search space is the set of (scale, component, root location) triples.
+ *  Regions of root locations are kept in a priority queue ordered by an upper
+ *  bound on the score of any location within them, and the region with the
+ *  best bound is either split in two, or (once small) scored exactly. The
+ *  search stops when no region can beat the k-th best score found, so the
+ *  result is the exact top K of the dense dynamic program.
+ *
+ *  The bound assumes each part is displaced by at most radius cells from its
+ *  anchor, which confines it to a window around the region. Within that case,
+ *  the bound is the sum of the per-region maxima of the part responses and
+ *  the largest deformation score within the radius. Otherwise some part is
+ *  displaced further, and the bound uses the global maxima of the responses
+ *  and the deformation score beyond the radius, from ComponentPart::defw().
+ *
+ *  Small regions are scored by the dynamic program over the window of the
+ *  responses they can reach. A location whose windowed score cannot be
+ *  certified against the bound for parts outside the window falls back to
+ *  the dense dynamic program of its (scale, component)
+ */
+template<typename T>
+class BranchAndBound {
+private:
+	//! the bounds of a component which are independent of the level
+	struct ComponentBound {
+		//! the root bias
+		double bias;
+		//! the best bias of each part, over its own and its parent's mixtures
+		std::vector<double> pbias;
+		//! the best deformation score of each part within the radius
+		std::vector<double> inside;
+		//! the offsets (relative to the root) each part can reach within the radius
+		std::vector<cv::Rect> reach;
+		//! the bound on the sum of deformation scores and biases when some part leaves the radius
+		double escape;
+	};
+	//! the maxima of the responses of a component at a level
+	struct LevelBound {
+		//! the best root response at each location, over the root mixtures
+		cv::Mat root;
+		//! the best response of each part at each location, over its mixtures
+		vectorMat parts;
+		//! the global maximum of each part's response
+		std::vector<double> peak;
+	};
+	//! a region of root locations
+	struct Region {
+		double bound;
+		size_t n, c;
+		cv::Rect rect;
+		Region(double b, size_t nn, size_t cc, const cv::Rect& r) : bound(b), n(nn), c(cc), rect(r) {}
+		bool operator<(const Region& other) const { return bound < other.bound; }
+	};
+	//! the largest displacement of a part from its anchor covered by the windowed bound
+	int radius_;
+	//! regions with at most leaf_*leaf_ locations are scored exactly
+	int leaf_;
+	//! the number of regions scored by windowed and dense dynamic programs in the last search
+	size_t windows_, dense_;
+	std::vector<ComponentBound> components_;
+	std::vector<LevelBound> levels_;
+	//! the tables of the windowed dynamic program, reused across regions
+	DPTensor<T> window_;
+	//! the tables of the dense dynamic programs, by (scale, component)
+	std::map<size_t, DPTensor<T> > dense_dp_;
+	void bindComponent(Parts& parts, size_t c);
+	void bindLevel(Parts& parts, ResponseCache& responses, size_t nc);
+	double bound(const LevelBound& level, const ComponentBound& component, const cv::Rect& rect) const;
+	cv::Rect window(const LevelBound& level, const ComponentBound& component, const cv::Rect& rect) const;
+	void score(Parts& parts, DynamicProgram<T>& dp, ResponseCache& responses, const Region& region, T scale, vectorCandidate& found);
+public:
+	BranchAndBound(int radius = 4, int leaf = 8) : radius_(radius), leaf_(leaf), windows_(0), dense_(0) {}
+	virtual ~BranchAndBound() {}
+	void search(Parts& parts, DynamicProgram<T>& dp, ResponseCache& responses, const vectorf& scales, size_t K, vectorCandidate& candidates);
+	//! the number of regions scored by a windowed dynamic program in the last search
+	size_t windows(void) const { return windows_; }
+	//! the number of dense dynamic programs run as a fallback in the last search
+	size_t dense(void) const { return dense_; }
+};
+
+#endif /* BRANCHANDBOUND_HPP_ */
@@ -39,6 +39,7 @@
 #ifndef CANDIDATE_HPP_
 #define CANDIDATE_HPP_
 #include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <limits>
 #include <opencv2/core/core.hpp>
@@ -77,7 +78,7 @@ public:
 	//! set the candidate component
 	void setComponent(int c) { component_ = c; }
 	//! get the candidate component
-	int component(void) { return component_; }
+	int component(void) const { return component_; }
 	//! rescale the parts
 	void resize(const float factor) {
 		for (size_t n = 0; n < parts_.size(); ++n) {
@@ -87,8 +88,12 @@ public:
 			parts_[n].x      *= factor;
 		}
 	}
+	//! translate the parts
+	void translate(const cv::Point& offset) {
+		for (size_t n = 0; n < parts_.size(); ++n) parts_[n] += offset;
+	}
 	//! descending comparison method for ordering objects of type Candidate
-	static bool descending(Candidate c1, Candidate c2) { return c1.score() > c2.score(); }
+	static bool descending(const Candidate& c1, const Candidate& c2) { return c1.score() > c2.score(); }
 
 	/*! @brief Sort the candidates from best to worst, in place
 	 *
@@ -100,9 +105,10 @@ public:
 
 	/*! @brief create a single bounding box around the detection taken from the part limit
 	 *
-	 * @return a single bounding Rect
+	 * @return a single bounding Rect, empty if the candidate has no parts
 	 */
 	cv::Rect boundingBox(void) const {
+		if (parts_.empty()) return cv::Rect();
 		cv::Rect hull = parts_[0];
 		for (size_t n = 0; n < parts_.size(); ++n) {
 			hull = hull | parts_[n];
@@ -112,21 +118,41 @@ public:
 
 	/*! @brief create a single bounding box around the detection from mean and standard deviation
 	 *
-	 * @return a bounding box
+	 * @return a bounding box, empty if the candidate has no parts
 	 */
 	cv::Rect boundingBoxNorm(void) const {
-		const size_t nparts = parts_.size();
-		cv::Mat_<int> xpts(cv::Size(1,nparts));
-		cv::Mat_<int> ypts(cv::Size(1,nparts));
+		if (parts_.empty()) return cv::Rect();
+		return boundingBoxNorm(&parts_[0], parts_.size());
+	}
+
+	/*! @brief the bounding box of a set of parts from the mean and standard deviation of their centroids
+	 *
+	 * Shared by Candidate and CandidateSet, and computed directly rather
+	 * than through temporary matrices
+	 *
+	 * @param parts the part boxes
+	 * @param nparts the number of parts
+	 * @return a bounding box, empty if there are no parts
+	 */
+	static cv::Rect boundingBoxNorm(const cv::Rect* parts, size_t nparts) {
+		if (nparts == 0) return cv::Rect();
+		double xsum = 0, ysum = 0;
+		for (size_t n = 0; n < nparts; ++n) {
+			const cv::Point centroid = (parts[n].tl() + parts[n].br())*0.5;
+			xsum += centroid.x;
+			ysum += centroid.y;
+		}
+		const double xmean = xsum / nparts;
+		const double ymean = ysum / nparts;
+		double xvar = 0, yvar = 0;
 		for (size_t n = 0; n < nparts; ++n) {
-			const cv::Point centroid = (parts_[n].tl() + parts_[n].br())*0.5;
-			xpts(n) = centroid.x;
-			ypts(n) = centroid.y;
+			const cv::Point centroid = (parts[n].tl() + parts[n].br())*0.5;
+			xvar += (centroid.x - xmean) * (centroid.x - xmean);
+			yvar += (centroid.y - ymean) * (centroid.y - ymean);
 		}
-		cv::Scalar xmean, ymean, xstd, ystd;
-		cv::meanStdDev(xpts, xmean, xstd);
-		cv::meanStdDev(ypts, ymean, ystd);
-		return cv::Rect(xmean(0)-1.5*xstd(0), ymean(0)-1.5*ystd(0), 3*xstd(0), 3*ystd(0));
+		const double xstd = std::sqrt(xvar / nparts);
+		const double ystd = std::sqrt(yvar / nparts);
+		return cv::Rect(xmean-1.5*xstd, ymean-1.5*ystd, 3*xstd, 3*ystd);
 	}
 
 	/*! @brief create a single bounding box in 3D
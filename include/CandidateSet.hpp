@@ -0,0 +1,110 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    CandidateSet.hpp
+ *  Created: Oct 16, 2026
+ */
+
+#ifndef CANDIDATESET_HPP_
+#define CANDIDATESET_HPP_
+#include <vector>
+#include <opencv2/core/core.hpp>
+#include "types.hpp"
+#include "Candidate.hpp"
+
+/*! @class CandidateSet
+ *  @brief compact storage for many detection candidates
+ *
+ * Each Candidate owns its own vectors of part boxes and confidences, so
+ * large sets of them are scattered across the heap and expensive to
+ * copy. A CandidateSet stores the part boxes and confidences of every
+ * candidate in contiguous arrays of a fixed stride (the most parts of any
+ * candidate), along with each candidate's component and number of parts.
+ *
+ * Sorting computes a permutation of the indices and moves each candidate
+ * once, and the bounding boxes are computed in bulk. Visualize and the
+ * non-maxima suppression accept a set directly
+ */
+class CandidateSet {
+private:
+	//! the number of part slots per candidate
+	size_t stride_;
+	//! the part boxes of each candidate, stride_ per candidate
+	std::vector<cv::Rect> parts_;
+	//! the part confidences of each candidate, stride_ per candidate
+	vectorf confidence_;
+	//! the model component of each candidate
+	vectori component_;
+	//! the number of parts of each candidate
+	vectori nparts_;
+	void restride(size_t stride);
+	void permute(const std::vector<size_t>& order);
+public:
+	CandidateSet() : stride_(0) {}
+	explicit CandidateSet(const vectorCandidate& candidates);
+	virtual ~CandidateSet() {}
+	//! the number of candidates
+	size_t size(void) const { return component_.size(); }
+	//! whether the set holds no candidates
+	bool empty(void) const { return component_.empty(); }
+	//! the number of part slots per candidate
+	size_t stride(void) const { return stride_; }
+	//! the number of parts of candidate i
+	size_t nparts(size_t i) const { return nparts_[i]; }
+	//! the part boxes of candidate i (NULL if no candidate has parts)
+	const cv::Rect* parts(size_t i) const { return stride_ ? &parts_[i*stride_] : NULL; }
+	//! the part confidences of candidate i (NULL if no candidate has parts)
+	const float* confidence(size_t i) const { return stride_ ? &confidence_[i*stride_] : NULL; }
+	//! the root score of candidate i
+	float score(size_t i) const { return nparts_[i] ? confidence_[i*stride_] : -std::numeric_limits<float>::infinity(); }
+	//! the model component of candidate i
+	int component(size_t i) const { return component_[i]; }
+	//! remove every candidate
+	void clear(void);
+	//! reserve space for n candidates of up to stride parts
+	void reserve(size_t n, size_t stride);
+	void push_back(const Candidate& candidate);
+	void insert(const vectorCandidate& candidates);
+	Candidate candidate(size_t i) const;
+	void candidates(vectorCandidate& out) const;
+	void order(std::vector<size_t>& order) const;
+	void sort(void);
+	void select(const std::vector<size_t>& keep);
+	void resize(const float factor);
+	void translate(const cv::Point& offset);
+	void boundingBoxes(std::vector<cv::Rect>& boxes) const;
+	void boundingBoxesNorm(std::vector<cv::Rect>& boxes) const;
+	void nonMaximaSuppression(const cv::Mat& im, const float overlap=0.0f);
+};
+
+#endif /* CANDIDATESET_HPP_ */
@@ -0,0 +1,79 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    ConvolutionCalibration.hpp
+ *  Created: Oct 16, 2026
+ */
+
+#ifndef CONVOLUTIONCALIBRATION_HPP_
+#define CONVOLUTIONCALIBRATION_HPP_
+
+#include <iostream>
+#include <vector>
+#include "IConvolutionEngine.hpp"
+#include "types.hpp"
+
+/*! @class ResponseError
+ *  @brief the error of the responses of a single filter against a reference
+ */
+struct ResponseError {
+	//! the largest absolute error over all levels
+	double max_abs;
+	//! the root mean squared error over all levels
+	double rms;
+	//! the range (max - min) of the reference responses
+	double range;
+	ResponseError() : max_abs(0), rms(0), range(0) {}
+	//! the largest absolute error as a fraction of the reference range
+	double relative(void) const { return range > 0 ? max_abs / range : 0; }
+};
+
+/*! @class ConvolutionCalibration
+ *  @brief measures the score error of an approximate convolution engine
+ *
+ *  Approximate engines (quantized, low-rank, sparse) trade accuracy in the
+ *  part responses for speed. ConvolutionCalibration compares their responses
+ *  against those of an exact engine over the same feature pyramid, filter by
+ *  filter, so the trade-off can be judged before the engine is deployed
+ */
+class ConvolutionCalibration {
+private:
+	ConvolutionCalibration() {}
+public:
+	virtual ~ConvolutionCalibration() {}
+	static void compare(const vector2DMat& reference, const vector2DMat& responses, std::vector<ResponseError>& errors);
+	static void report(IConvolutionEngine& reference, IConvolutionEngine& engine, const vectorMat& features, std::ostream& os);
+	static void print(const std::vector<ResponseError>& errors, std::ostream& os);
+};
+
+#endif /* CONVOLUTIONCALIBRATION_HPP_ */
@@ -0,0 +1,119 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    CpuDispatch.hpp
+ *  Created: Oct 16, 2026
+ */
+
+#ifndef CPUDISPATCH_HPP_
+#define CPUDISPATCH_HPP_
+
+#include <stdint.h>
+
+/*! @class CpuDispatch
+ *  @brief runtime selection of the instruction set used by the hot loops
+ *
+ *  The library is compiled for the baseline architecture, and the
+ *  vectorizable kernels (dot products, reductions, gradient orientation
+ *  binning and the 1D distance transforms) are compiled once per tier,
+ *  each in its own translation unit with that tier's instruction set
+ *  enabled. On first use the best tier supported by the CPU is chosen
+ *  and its kernels are installed in a table of function pointers.
+ *
+ *  The tier can be forced (downwards) for benchmarking by setting the
+ *  PBD_CPU_TIER environment variable to one of generic, sse4.1, avx2 or
+ *  avx512 before the first detection.
+ */
+class CpuDispatch {
+public:
+	//! the instruction set tiers, in increasing order of capability
+	enum Tier { GENERIC, SSE41, AVX2, AVX512 };
+	//! the most sequences the exhaustive distance transform accepts
+	enum { MAX_LANES = 16 };
+
+	/*! @brief the table of kernels of a tier
+	 *
+	 *  The quantized dot products require n to be a multiple of 32. All
+	 *  other kernels accept any length.
+	 */
+	struct Kernels {
+		//! 16-bit dot product, accumulated in 32 bits
+		int32_t (*dot16)(const int16_t* a, const int16_t* b, int n);
+		//! unsigned (<= 127) by signed 8-bit dot product, accumulated in 32 bits
+		int32_t (*dot8)(const uint8_t* a, const int8_t* b, int n);
+		//! floating point dot products
+		float  (*dotf)(const float* a, const float* b, int n);
+		double (*dotd)(const double* a, const double* b, int n);
+		//! dst += alpha * src
+		void (*axpyf)(float alpha, const float* src, float* dst, int n);
+		void (*axpyd)(double alpha, const double* src, double* dst, int n);
+		//! running max: where src > maxv, maxv = src and maxi = k
+		void (*maxf)(const float* src, int k, float* maxv, int* maxi, int n);
+		void (*maxd)(const double* src, int k, double* maxv, int* maxi, int n);
+		//! running pick: where idx == k, dst = src
+		void (*picki)(const int* src, int k, const int* idx, int* dst, int n);
+		void (*pickf)(const float* src, int k, const int* idx, float* dst, int n);
+		void (*pickd)(const double* src, int k, const int* idx, double* dst, int n);
+		//! snap gradients (dx,dy) to the closest of 2*half orientations, using best as scratch
+		void (*orientf)(const float* dx, const float* dy, const float* uu, const float* vv, int half, int n, float* best, int* orient);
+		void (*orientd)(const double* dx, const double* dy, const double* uu, const double* vv, int half, int n, double* best, int* orient);
+		//! 1D distance transform under the quadratic penalty a*x^2 + b*x, using v (n) and z (n+1) as scratch
+		void (*dtf)(const float* src, float* dst, int* ptr, int* v, float* z, int n, double a, double b, int os);
+		void (*dtd)(const double* src, double* dst, int* ptr, int* v, double* z, int n, double a, double b, int os);
+		//! the same transform of up to MAX_LANES interleaved sequences by exhaustive search, element i of
+		//! sequence l at i*stride+l. Used instead of dt for sequences of up to brute elements
+		void (*dtbrutef)(const float* src, float* dst, int* ptr, int n, int lanes, int stride, double a, double b, int os);
+		void (*dtbruted)(const double* src, double* dst, int* ptr, int n, int lanes, int stride, double a, double b, int os);
+		//! the number of sequences the tier transforms at once, the width of its vectors of floats
+		int lanes;
+		//! the longest sequences on which dtbrutef (dtbruted) beats dtf (dtd), measured over full
+		//! blocks of lanes by test/benchDistanceTransform (0 if it never does)
+		int brutef, bruted;
+	};
+
+	static const Kernels& kernels(void);
+	static Tier tier(void);
+	static Tier supported(void);
+	static const char* name(Tier tier);
+
+	// tier table fillers, each defined in the translation unit compiled for that tier.
+	// A filler returns false if the compiler could not target its tier
+	static bool fillGeneric(Kernels& k);
+	static bool fillSSE41(Kernels& k);
+	static bool fillAVX2(Kernels& k);
+	static bool fillAVX512(Kernels& k);
+private:
+	CpuDispatch() {}
+};
+
+#endif /* CPUDISPATCH_HPP_ */
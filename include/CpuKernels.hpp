@@ -0,0 +1,222 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    CpuKernels.hpp
+ *  Created: Oct 16, 2026
+ */
+
+#ifndef CPUKERNELS_HPP_
+#define CPUKERNELS_HPP_
+
+#include <cmath>
+#include "CpuDispatch.hpp"
+
+/*! @class PortableKernels
+ *  @brief the portable implementation of the dispatched kernels
+ *
+ *  The loops are written so the compiler can vectorize them for whatever
+ *  instruction set the including translation unit targets. Each tier
+ *  instantiates the kernels with its own Tier argument, so the copies
+ *  compiled for different instruction sets never collide at link time.
+ *  For the same reason, the kernels must not call inline functions
+ *  shared with the rest of the library, including those of the standard
+ *  library such as std::numeric_limits<T>::infinity().
+ */
+template<int Tier>
+struct PortableKernels {
+
+	//! positive infinity, without the inline functions of <limits>
+	template<typename T>
+	static T inf(void) { return (T)HUGE_VAL; }
+
+	static int32_t dot16(const int16_t* a, const int16_t* b, int n) {
+		int32_t sum = 0;
+		for (int i = 0; i < n; ++i) sum += (int32_t)a[i] * b[i];
+		return sum;
+	}
+
+	static int32_t dot8(const uint8_t* a, const int8_t* b, int n) {
+		int32_t sum = 0;
+		for (int i = 0; i < n; ++i) sum += (int32_t)a[i] * b[i];
+		return sum;
+	}
+
+	template<typename T>
+	static T dot(const T* a, const T* b, int n) {
+		// independent partial sums break the dependency chain of the accumulation
+		T s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+		int i = 0;
+		for (; i+4 <= n; i += 4) {
+			s0 += a[i]   * b[i];
+			s1 += a[i+1] * b[i+1];
+			s2 += a[i+2] * b[i+2];
+			s3 += a[i+3] * b[i+3];
+		}
+		for (; i < n; ++i) s0 += a[i] * b[i];
+		return (s0 + s1) + (s2 + s3);
+	}
+
+	template<typename T>
+	static void axpy(T alpha, const T* src, T* dst, int n) {
+		for (int i = 0; i < n; ++i) dst[i] += alpha * src[i];
+	}
+
+	template<typename T>
+	static void max(const T* src, int k, T* maxv, int* maxi, int n) {
+		for (int i = 0; i < n; ++i) {
+			const bool greater = src[i] > maxv[i];
+			maxv[i] = greater ? src[i] : maxv[i];
+			maxi[i] = greater ? k : maxi[i];
+		}
+	}
+
+	template<typename T>
+	static void pick(const T* src, int k, const int* idx, T* dst, int n) {
+		for (int i = 0; i < n; ++i) dst[i] = (idx[i] == k) ? src[i] : dst[i];
+	}
+
+	template<typename T>
+	static void orient(const T* dx, const T* dy, const T* uu, const T* vv, int half, int n, T* best, int* orient) {
+		for (int i = 0; i < n; ++i) { best[i] = 0; orient[i] = 0; }
+		// orientations outermost, so the inner loop runs across pixels
+		for (int o = 0; o < half; ++o) {
+			const T u = uu[o];
+			const T v = vv[o];
+			for (int i = 0; i < n; ++i) {
+				const T dot = u*dx[i] + v*dy[i];
+				const bool pos = dot > best[i];
+				const bool neg = -dot > best[i];
+				best[i]   = pos ? dot : (neg ? -dot : best[i]);
+				orient[i] = pos ? o : (neg ? o+half : orient[i]);
+			}
+		}
+	}
+
+	template<typename T>
+	static void dt(const T* src, T* dst, int* ptr, int* v, T* z, int n, double a, double b, int os) {
+		int k = 0;
+		v[0] = 0;
+		z[0] = -inf<T>();
+		z[1] = +inf<T>();
+		for (int q = 1; q < n; ++q) {
+			T s = intersect(v[k], q, src[v[k]], src[q], a, b);
+			while (s <= z[k] && k > 0) {
+				k--;
+				s = intersect(v[k], q, src[v[k]], src[q], a, b);
+			}
+			k++;
+			v[k]   = q;
+			z[k]   = s;
+			z[k+1] = +inf<T>();
+		}
+
+		k = 0;
+		for (int q = 0; q < n; ++q) {
+			while (z[k+1] < os) k++;
+			const int x = os-v[k];
+			dst[q] = a*(x*x) + b*x + src[v[k]];
+			ptr[q] = v[k];
+			os++;
+		}
+	}
+
+	/*! @brief the 1D transform of several interleaved sequences, by exhaustive search
+	 *
+	 *  Element i of sequence l lies at i*stride+l, so contiguous columns of
+	 *  a matrix are transformed in place, one sequence per vector lane.
+	 *  The search is O(n^2) per sequence, but branch free: the best value
+	 *  and argmax of each lane are kept in local accumulators and updated
+	 *  with a compare and blend. This portable version is the reference:
+	 *  at the optimization level of the library it does not beat the
+	 *  envelope of dt(), so only the tiers with their own vector versions
+	 *  use it (see CpuDispatch::Kernels::brutef)
+	 */
+	template<typename T>
+	static void dtBrute(const T* src, T* dst, int* ptr, int n, int lanes, int stride, double a, double b, int os) {
+		T best[CpuDispatch::MAX_LANES];
+		int arg[CpuDispatch::MAX_LANES];
+		for (int q = 0; q < n; ++q) {
+			for (int l = 0; l < CpuDispatch::MAX_LANES; ++l) {
+				best[l] = -inf<T>();
+				arg[l]  = 0;
+			}
+			for (int u = 0; u < n; ++u) {
+				const int x = os+q-u;
+				const T penalty = a*(x*x) + b*x;
+				const T* su = src + u*stride;
+				for (int l = 0; l < lanes; ++l) {
+					const T value = penalty + su[l];
+					const bool greater = value > best[l];
+					best[l] = greater ? value : best[l];
+					arg[l]  = greater ? u : arg[l];
+				}
+			}
+			T* dq = dst + q*stride;
+			int* pq = ptr + q*stride;
+			for (int l = 0; l < lanes; ++l) {
+				dq[l] = best[l];
+				pq[l] = arg[l];
+			}
+		}
+	}
+
+	//! the intersection of two quadratic penalties, as Quadratic computes it
+	static double intersect(int x0, int x1, double y0, double y1, double a, double b) {
+		return ((y1-y0) - b*(x1-x0) + a*(x1*x1 - x0*x0)) / (2*a*(x1-x0));
+	}
+
+	static void fill(CpuDispatch::Kernels& k) {
+		k.dot16   = dot16;
+		k.dot8    = dot8;
+		k.dotf    = dot<float>;
+		k.dotd    = dot<double>;
+		k.axpyf   = axpy<float>;
+		k.axpyd   = axpy<double>;
+		k.maxf    = max<float>;
+		k.maxd    = max<double>;
+		k.picki   = pick<int>;
+		k.pickf   = pick<float>;
+		k.pickd   = pick<double>;
+		k.orientf = orient<float>;
+		k.orientd = orient<double>;
+		k.dtf     = dt<float>;
+		k.dtd     = dt<double>;
+		k.dtbrutef = dtBrute<float>;
+		k.dtbruted = dtBrute<double>;
+		k.lanes    = (Tier >= CpuDispatch::AVX512) ? 16 : ((Tier >= CpuDispatch::AVX2) ? 8 : 4);
+		k.brutef   = 0;
+		k.bruted   = 0;
+	}
+};
+
+#endif /* CPUKERNELS_HPP_ */
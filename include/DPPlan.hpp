@@ -0,0 +1,151 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    DPPlan.hpp
+ *  Created: Oct 16, 2026
+ */
+
+#ifndef DPPLAN_HPP_
+#define DPPLAN_HPP_
+
+#include <vector>
+#include <opencv2/core/core.hpp>
+#include "Parts.hpp"
+#include "types.hpp"
+
+/*! @class DPPlan
+ *  @brief the part trees of a model, compiled for the dynamic program
+ *
+ *  Parts describes each component through several levels of index vectors,
+ *  which ComponentPart resolves on every access, copying bias and
+ *  deformation vectors by value. The plan resolves every operand the
+ *  dynamic program needs once, when the model is loaded, into flat arrays:
+ *  for each part, its parent and the slot of its tables in a DPTensor, and
+ *  for each mixture, its filter, anchor, quadratic deformation and size.
+ *
+ *  The parts of a component are stored in topological order (every parent
+ *  before its children), so message passing runs the component's parts
+ *  backwards, and backtracking runs them forwards.
+ *
+ *  Components often reuse the filters and deformations of other components.
+ *  Parts whose subtrees send identical messages (the same filters,
+ *  deformations, anchors and biases throughout) are shared: the first such
+ *  part is canonical, and the others are its aliases, whose messages need
+ *  not be computed again when every component is run at the same scale
+ *
+ *  @tparam T the type of the scores
+ */
+template<typename T>
+class DPPlan {
+public:
+	//! a mixture of a part
+	struct Mixture {
+		//! the filter, which indexes the responses
+		size_t filter;
+		//! the anchor of the part relative to its parent
+		cv::Point anchor;
+		//! the quadratic deformation in x (ax*dx^2 + bx*dx) and y
+		T ax, bx, ay, by;
+		//! the size of the filter
+		int xsize, ysize;
+		//! the largest displacement from the anchor in x and y (0 if unbounded)
+		int rx, ry;
+	};
+	//! a part of a component
+	struct Part {
+		//! the component of the part, and its index within the component
+		size_t component, self;
+		//! the parent, within the component (the root is its own parent)
+		size_t parent;
+		//! the part which computes the messages of this part (itself, unless shared)
+		size_t canonical;
+		//! the first alias of a canonical part, and the number of aliases
+		size_t alias, naliases;
+		//! the number of children
+		size_t nchildren;
+		//! the first mixture of the part, and the first of its parent
+		size_t mixture, pmixture;
+		size_t nmixtures, pnmixtures;
+		//! the first bias, indexed by (mixture, parent mixture)
+		size_t bias;
+		//! the first DPTensor slot of the part, indexed by parent mixture
+		size_t slot;
+	};
+	//! a component
+	struct Component {
+		//! the first part and mixture of the component
+		size_t part, mixture;
+		size_t nparts, nmixtures;
+		//! the number of DPTensor slots (parent mixtures over all parts but the root)
+		size_t nslots;
+		//! the bias of the root
+		T bias;
+	};
+private:
+	std::vector<Component> components_;
+	std::vector<Part> parts_;
+	std::vector<Mixture> mixtures_;
+	std::vector<T> biases_;
+	//! the aliases of each canonical part, contiguous per canonical part
+	std::vector<size_t> aliases_;
+	void share(void);
+	static int reach(T a, T b, double margin);
+public:
+	DPPlan() {}
+	explicit DPPlan(Parts& parts) { compile(parts); }
+	virtual ~DPPlan() {}
+	void compile(Parts& parts);
+	void bound(int radius, double margin = 0);
+	//! whether a model has been compiled
+	bool empty(void) const { return components_.empty(); }
+	//! the number of components
+	size_t ncomponents(void) const { return components_.size(); }
+	//! a component
+	const Component& component(size_t c) const { return components_[c]; }
+	//! a part of component c
+	const Part& part(size_t c, size_t p) const { return parts_[components_[c].part + p]; }
+	//! mixture m of a part
+	const Mixture& mixture(const Part& part, size_t m) const { return mixtures_[part.mixture + m]; }
+	//! whether a part's messages are computed by another (canonical) part
+	bool shared(const Part& part) const { return &parts_[part.canonical] != &part; }
+	//! the canonical part of a part
+	const Part& canonical(const Part& part) const { return parts_[part.canonical]; }
+	//! alias a of a canonical part
+	const Part& alias(const Part& part, size_t a) const { return parts_[aliases_[part.alias + a]]; }
+	//! the number of parts whose messages are computed by another part
+	size_t nshared(void) const;
+	//! the bias of mixture m of a part, given mixture pm of its parent
+	T bias(const Part& part, size_t m, size_t pm) const { return biases_[part.bias + m*part.pnmixtures + pm]; }
+};
+
+#endif /* DPPLAN_HPP_ */
@@ -0,0 +1,113 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    DPTensor.hpp
+ *  Created: Oct 16, 2026
+ */
+
+#ifndef DPTENSOR_HPP_
+#define DPTENSOR_HPP_
+
+#include <vector>
+#include <stdint.h>
+#include <opencv2/core/core.hpp>
+#include "DPPlan.hpp"
+#include "types.hpp"
+
+/*! @class DPTensor
+ *  @brief the tables of the dynamic program, in a single reusable arena
+ *
+ *  The dynamic program leaves, for each (scale, component, part, parent
+ *  mixture), the best location (Ix, Iy) and mixture (Ik) of the part at
+ *  each location of its parent, and for each (scale, component) the root
+ *  scores (rootv) and best root mixtures (rooti). Rather than a nested
+ *  vector of matrices, each allocated separately, every table is a view
+ *  into one arena. Locations are stored as int16 and mixtures as uint8,
+ *  and each table starts on a cache line.
+ *
+ *  The tables are laid out by a DPPlan, which must outlive them. The arena only grows: allocating the tables of a frame no larger than
+ *  a previous frame reuses the same memory, without touching the heap.
+ *  The views returned by the accessors are invalidated by the next allocate()
+ *
+ *  @tparam T the type of the root scores
+ */
+template<typename T>
+class DPTensor {
+public:
+	//! the type of a stored location
+	typedef int16_t Index;
+	//! the type of a stored mixture
+	typedef uint8_t Mixture;
+	//! the alignment of each table, in bytes
+	static const size_t ALIGN = 64;
+private:
+	//! the storage of every table
+	cv::Mat arena_;
+	//! the first aligned byte of the arena
+	unsigned char* data_;
+	size_t nscales_, ncomponents_;
+	//! the size of the tables of each (scale, component), empty if not allocated
+	std::vector<cv::Size> sizes_;
+	//! the byte offset of the tables of each (scale, component)
+	std::vector<size_t> offsets_;
+	//! the plan of the tables, which numbers the (part, parent mixture) slots
+	const DPPlan<T>* plan_;
+	static size_t align(size_t bytes) { return (bytes + ALIGN-1) / ALIGN * ALIGN; }
+	void layout(const DPPlan<T>& plan);
+	size_t slot(size_t n, size_t c, size_t p, size_t m) const;
+	cv::Mat view(size_t offset, const cv::Size& size, int type) const;
+public:
+	DPTensor() : data_(NULL), nscales_(0), ncomponents_(0), plan_(NULL) {}
+	virtual ~DPTensor() {}
+	void allocate(const DPPlan<T>& plan, const std::vector<cv::Size>& sizes);
+	void allocate(const DPPlan<T>& plan, const cv::Size& size, size_t c);
+	//! the number of scales
+	size_t nscales(void) const { return nscales_; }
+	//! the number of components
+	size_t ncomponents(void) const { return ncomponents_; }
+	//! whether any tables are allocated
+	bool empty(void) const { return sizes_.empty(); }
+	//! the size of the tables of a (scale, component)
+	cv::Size size(size_t n, size_t c) const { return sizes_[n*ncomponents_ + c]; }
+	//! the number of bytes held by the arena
+	size_t capacity(void) const { return arena_.total(); }
+	void release(void);
+	cv::Mat Ix(size_t n, size_t c, size_t p, size_t m) const;
+	cv::Mat Iy(size_t n, size_t c, size_t p, size_t m) const;
+	cv::Mat Ik(size_t n, size_t c, size_t p, size_t m) const;
+	cv::Mat rootv(size_t n, size_t c) const;
+	cv::Mat rooti(size_t n, size_t c) const;
+	static size_t cellBytes(const DPPlan<T>& plan);
+};
+
+#endif /* DPTENSOR_HPP_ */
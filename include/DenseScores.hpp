@@ -0,0 +1,94 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    DenseScores.hpp
+ *  Created: Oct 16, 2026
+ */
+
+#ifndef DENSESCORES_HPP_
+#define DENSESCORES_HPP_
+#include <vector>
+#include <opencv2/core/core.hpp>
+
+/*! @class DenseScores
+ *  @brief the root score maps of a detection, for fusion with other evidence
+ *
+ * Rather than discrete candidates, PartsBasedDetector::detectDense() returns
+ * the root score of every location at every scale and component: the score
+ * of the best configuration of parts rooted there. The maps are stored
+ * one after another in a single contiguous buffer, and each is described by
+ * its level, component, size and placement in the image. The score of cell
+ * (x, y) of a map belongs to the image location offset + (x, y)*scale
+ */
+class DenseScores {
+public:
+	//! the placement of a single score map
+	struct Map {
+		//! the level of the pyramid and the component of the model
+		size_t level, component;
+		//! the number of image pixels per cell
+		float scale;
+		//! the image location of cell (0, 0): the centre of the root box anchored there
+		cv::Point2f offset;
+		//! the size of the map, in cells
+		cv::Size size;
+		//! the index of the map's first score in the buffer
+		size_t begin;
+	};
+private:
+	//! every score map, one after another
+	cv::Mat buffer_;
+	//! the placement of each map
+	std::vector<Map> maps_;
+public:
+	DenseScores() {}
+	virtual ~DenseScores() {}
+	//! the number of score maps
+	size_t size(void) const { return maps_.size(); }
+	//! whether there are no score maps
+	bool empty(void) const { return maps_.empty(); }
+	//! the placement of map i
+	const Map& map(size_t i) const { return maps_[i]; }
+	//! every score map, as a single row of the precision of the detector
+	const cv::Mat& buffer(void) const { return buffer_; }
+	//! the scores of map i, a view into the buffer
+	cv::Mat scores(size_t i) const {
+		const Map& m = maps_[i];
+		return cv::Mat(m.size, buffer_.type(), const_cast<unsigned char*>(buffer_.ptr()) + m.begin*buffer_.elemSize());
+	}
+	void allocate(const std::vector<Map>& maps, int type);
+	void project(const cv::Size& imsize, cv::Mat& projection) const;
+	void release(void) { buffer_.release(); maps_.clear(); }
+};
+
+#endif /* DENSESCORES_HPP_ */
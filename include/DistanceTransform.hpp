@@ -39,8 +39,14 @@
 #ifndef DISTANCETRANSFORM_HPP_
 #define DISTANCETRANSFORM_HPP_
 
+#include <algorithm>
+#include <cassert>
+#include <cmath>
 #include <limits>
+#include <vector>
 #include <opencv2/core/core.hpp>
+#include <boost/thread/tss.hpp>
+#include "CpuDispatch.hpp"
 
 // ---------------------------------------------------------------------------
 // SAMPLED FUNCTION INTERFACE
@@ -123,13 +129,58 @@ public:
 template<typename T>
 class DistanceTransform {
 private:
-	inline void computeRow(T const * const src, T * const dst, int * const ptr, const size_t N, const PenaltyFunction& f, int os=0) const;
+	//! the working memory of the transforms, kept by each thread between transforms
+	struct Scratch {
+		std::vector<int> v, ptr, row;
+		std::vector<T> z, src, dst, tmp;
+	};
+	static boost::thread_specific_ptr<Scratch> scratch_;
+	//! the working memory of the calling thread
+	static Scratch& scratch(void) {
+		if (!scratch_.get()) scratch_.reset(new Scratch);
+		return *scratch_;
+	}
+	//! a buffer of at least n elements, grown (never shrunk) as needed
+	template<typename V>
+	static typename V::value_type* reserve(V& buffer, size_t n) {
+		if (buffer.size() < std::max(n, (size_t)1)) buffer.resize(std::max(n, (size_t)1));
+		return &buffer[0];
+	}
+	inline void computeRow(T const * const src, T * const dst, int * const ptr, int * const v, T * const z, const size_t N, const PenaltyFunction& f, int os=0) const;
+	// the 1D transform under a quadratic penalty, dispatched to the selected instruction set
+	static void quadraticRow(const float* src, float* dst, int* ptr, int* v, float* z, const size_t N, const Quadratic& f, int os) {
+		CpuDispatch::kernels().dtf(src, dst, ptr, v, z, N, f.a, f.b, os);
+	}
+	static void quadraticRow(const double* src, double* dst, int* ptr, int* v, double* z, const size_t N, const Quadratic& f, int os) {
+		CpuDispatch::kernels().dtd(src, dst, ptr, v, z, N, f.a, f.b, os);
+	}
+	// the exhaustive transform of short interleaved sequences, dispatched to the selected instruction set
+	static void quadraticBrute(const float* src, float* dst, int* ptr, const size_t N, const size_t lanes, const size_t stride, const Quadratic& f, int os) {
+		CpuDispatch::kernels().dtbrutef(src, dst, ptr, N, lanes, stride, f.a, f.b, os);
+	}
+	static void quadraticBrute(const double* src, double* dst, int* ptr, const size_t N, const size_t lanes, const size_t stride, const Quadratic& f, int os) {
+		CpuDispatch::kernels().dtbruted(src, dst, ptr, N, lanes, stride, f.a, f.b, os);
+	}
+	// the longest sequences quadraticBrute is faster on
+	static int bruteWidth(const float*) { return CpuDispatch::kernels().brutef; }
+	static int bruteWidth(const double*) { return CpuDispatch::kernels().bruted; }
+	void quadratic(const cv::Mat_<T>& score_in, const Quadratic& fx, const Quadratic& fy, const cv::Point os, cv::Mat_<T>& score_out, cv::Mat_<int>& Ix, cv::Mat_<int>& Iy) const;
+	inline void boundedRow(T const * const src, T * const dst, int * const ptr, const size_t N, const size_t step, const T a, const T b, const int os, const int R) const;
+	// the 1D transform of a row, using the dispatched kernel if the penalty is quadratic
+	inline void row(T const * const src, T * const dst, int * const ptr, int * const v, T * const z, const size_t N, const PenaltyFunction& f, const Quadratic* q, int os) const {
+		if (q) quadraticRow(src, dst, ptr, v, z, N, *q, os);
+		else computeRow(src, dst, ptr, v, z, N, f, os);
+	}
 public:
 	DistanceTransform() {}
 	virtual ~DistanceTransform() {}
 	void compute(const cv::Mat_<T>& score_in, const PenaltyFunction& fx, const PenaltyFunction& fy, const cv::Point os, cv::Mat_<T>& score_out, cv::Mat_<int>& Ix, cv::Mat_<int>& Iy) const;
+	void compute(const cv::Mat_<T>& score_in, const Quadratic& fx, const Quadratic& fy, const cv::Point os, const cv::Size radius, cv::Mat_<T>& score_out, cv::Mat_<int>& Ix, cv::Mat_<int>& Iy) const;
 };
 
+template<typename T>
+boost::thread_specific_ptr<typename DistanceTransform<T>::Scratch> DistanceTransform<T>::scratch_;
+
 
 // ---------------------------------------------------------------------------
 // IMPLEMENTATION
@@ -144,15 +195,15 @@ public:
  * @param src pointer to the start of the source data
  * @param dst pointer to the start of the destination data
  * @param ptr pointer to the indices
+ * @param v scratch space for the envelope locations (N elements)
+ * @param z scratch space for the envelope boundaries (N+1 elements)
  * @param N the total number of rows
  * @param f the 1D distance penalty function
  * @param os the anchor offset
  */
 template<typename T>
-inline void DistanceTransform<T>::computeRow(T const * const src, T * const dst, int * const ptr, const size_t N, const PenaltyFunction& f, int os) const {
+inline void DistanceTransform<T>::computeRow(T const * const src, T * const dst, int * const ptr, int * const v, T * const z, const size_t N, const PenaltyFunction& f, int os) const {
 
-	int * const v = new int[N];
-	T   * const z = new T[N+1];
 	int k = 0;
 	v[0] = 0;
 	z[0] = -std::numeric_limits<T>::infinity();
@@ -176,9 +227,74 @@ inline void DistanceTransform<T>::computeRow(T const * const src, T * const dst,
 		ptr[q] = v[k];
 		os++;
 	}
+}
 
-	delete [] v;
-	delete [] z;
+/*! @brief 1D distance transform with a bounded displacement
+ *
+ * Only displacements within [-R, R] are considered, so each output is
+ * the best of at most 2R+1 candidates rather than the lower envelope of
+ * the whole row. The candidates are visited from the displacement of
+ * least penalty outwards, and since a concave penalty only grows from
+ * there, the search stops once the row's maximum plus the penalty still
+ * to come cannot beat the best so far. Where no source lies within R,
+ * the nearest source is taken
+ *
+ * @param src pointer to the first source element
+ * @param dst pointer to the first destination element
+ * @param ptr pointer to the first index
+ * @param N the number of elements
+ * @param step the distance between consecutive elements of src, dst and ptr
+ * @param a the quadratic coefficient of the penalty
+ * @param b the linear coefficient of the penalty
+ * @param os the anchor offset
+ * @param R the largest displacement
+ */
+template<typename T>
+inline void DistanceTransform<T>::boundedRow(T const * const src, T * const dst, int * const ptr, const size_t N, const size_t step, const T a, const T b, const int os, const int R) const {
+
+	const T inf = std::numeric_limits<T>::infinity();
+	const int n = N;
+
+	// no displacement can do better than the row maximum, unpenalized
+	T top = src[0];
+	for (int v = 1; v < n; ++v) top = std::max(top, src[v*step]);
+
+	// the displacement of least penalty, from which the penalty only grows
+	const bool concave = a <= 0;
+	int dstar = 0;
+	if (a < 0) dstar = (int)std::floor(-b / (2*a) + 0.5);
+	else if (a == 0) dstar = (b > 0) ? R : ((b < 0) ? -R : 0);
+	dstar = std::max(-R, std::min(R, dstar));
+
+	for (int q = 0; q < n; ++q) {
+		const int c = q + os;
+		T best = -inf;
+		int arg = -1;
+		for (int k = 0; k <= 2*R; ++k) {
+			bool any = false;
+			T bound = -inf;
+			for (int side = 1; side >= -1; side -= 2) {
+				if (k == 0 && side < 0) break;
+				const int d = dstar + side*k;
+				if (d < -R || d > R) continue;
+				any = true;
+				const T penalty = a*d*d + b*d;
+				bound = std::max(bound, penalty);
+				const int v = c - d;
+				if (v < 0 || v >= n) continue;
+				const T value = src[v*step] + penalty;
+				if (value > best) { best = value; arg = v; }
+			}
+			if (!any || (concave && arg >= 0 && top + bound <= best)) break;
+		}
+		if (arg < 0) {
+			arg = std::max(0, std::min(n-1, c));
+			const int d = c - arg;
+			best = src[arg*step] + a*d*d + b*d;
+		}
+		dst[q*step] = best;
+		ptr[q*step] = arg;
+	}
 }
 
 /*! @brief Generalized distance transform
@@ -189,7 +305,9 @@ inline void DistanceTransform<T>::computeRow(T const * const src, T * const dst,
  *
  * This is used to reduce the complexity of the dynamic program, namely when all
  * of the cost functions are quadratic. The 2D distance transform is broken down
- * into two 1D transforms since the operation is separable
+ * into two 1D transforms since the operation is separable. Quadratic
+ * penalties use the 1D transforms of the instruction set selected by
+ * CpuDispatch, and short columns are transformed several at a time
  *
  * @param score_in the input score
  * @param fx the distance penalty function in the x-dimension
@@ -206,32 +324,43 @@ void DistanceTransform<T>::compute(const cv::Mat_<T>& score_in, const PenaltyFun
 	const size_t M = score_in.rows;
 	const size_t N = score_in.cols;
 
-	// allocate the output and working matrices
-	score_out.create(cv::Size(M, N));
-	Ix.create(cv::Size(N, M));
-	Iy.create(cv::Size(M, N));
-	cv::Mat_<T> score_tmp(cv::Size(N, M));
+	const Quadratic* qx = dynamic_cast<const Quadratic*>(&fx);
+	const Quadratic* qy = dynamic_cast<const Quadratic*>(&fy);
+	if (qx && qy) {
+		// quadratic in both dimensions: the dispatched kernels throughout
+		quadratic(score_in, *qx, *qy, os, score_out, Ix, Iy);
+	} else {
+		// allocate the output and working matrices
+		score_out.create(cv::Size(M, N));
+		Ix.create(cv::Size(N, M));
+		Iy.create(cv::Size(M, N));
+		cv::Mat_<T> score_tmp(cv::Size(N, M));
 
-	// compute the distance transform across the rows
-	for (size_t m = 0; m < M; ++m) {
-		computeRow(score_in[m], score_tmp[m], Ix[m], N, fx, os.x);
-	}
+		// envelope scratch space, shared by every row and column
+		Scratch& s = scratch();
+		int * const v = reserve(s.v, std::max(M, N));
+		T * const z   = reserve(s.z, std::max(M, N)+1);
 
-	// transpose the intermediate matrices
-	transpose(score_tmp, score_tmp);
+		// compute the distance transform across the rows
+		for (size_t m = 0; m < M; ++m) {
+			row(score_in[m], score_tmp[m], Ix[m], v, z, N, fx, qx, os.x);
+		}
 
-	// compute the distance transform down the columns
-	for (size_t n = 0; n < N; ++n) {
-		computeRow(score_tmp[n], score_out[n], Iy[n], M, fy, os.y);
-	}
+		// transpose the intermediate matrices
+		transpose(score_tmp, score_tmp);
 
-	// transpose back to the original layout
-	transpose(score_out, score_out);
-	transpose(Iy, Iy);
+		// compute the distance transform down the columns
+		for (size_t n = 0; n < N; ++n) {
+			row(score_tmp[n], score_out[n], Iy[n], v, z, M, fy, qy, os.y);
+		}
+
+		// transpose back to the original layout
+		transpose(score_out, score_out);
+		transpose(Iy, Iy);
+	}
 
 	// get argmins
-	cv::Mat_<int> row(cv::Size(N, 1));
-	int * const row_ptr = row[0];
+	int * const row_ptr = reserve(scratch().row, N);
 	for (size_t m = 0; m < M; ++m) {
 		int * const Iy_ptr = Iy[m];
 		int * const Ix_ptr = Ix[m];
@@ -244,4 +373,120 @@ void DistanceTransform<T>::compute(const cv::Mat_<T>& score_in, const PenaltyFun
 	}
 }
 
+/*! @brief Quadratic distance transform, with the dispatched kernels
+ *
+ * The rows are contiguous, and each is transformed by the envelope of
+ * the 1D kernel. Columns short enough that the exhaustive search of the
+ * selected instruction set beats the envelope (CpuDispatch::Kernels::brutef)
+ * are transformed in place, as many contiguous columns at a time as it
+ * has lanes. Longer columns are transposed, so that each is contiguous
+ * for the envelope, and transposed back
+ *
+ * @param score_in the input score
+ * @param fx the distance penalty function in the x-dimension
+ * @param fy the distance penalty function in the y-dimension
+ * @param os the anchor offset of the child from the parent
+ * @param score_out the distance transformed score
+ * @param Ix the distances in the x direction
+ * @param Iy the distances in the y direction, before the argmins are resolved
+ */
+template<typename T>
+void DistanceTransform<T>::quadratic(const cv::Mat_<T>& score_in, const Quadratic& fx, const Quadratic& fy, const cv::Point os, cv::Mat_<T>& score_out, cv::Mat_<int>& Ix, cv::Mat_<int>& Iy) const {
+
+	const size_t M = score_in.rows;
+	const size_t N = score_in.cols;
+
+	// allocate the output and working matrices
+	score_out.create(cv::Size(N, M));
+	Ix.create(cv::Size(N, M));
+	Iy.create(cv::Size(N, M));
+	Scratch& s = scratch();
+	cv::Mat_<T> score_tmp(M, N, reserve(s.tmp, M*N));
+
+	// envelope scratch space, shared by every row and column
+	int * const v = reserve(s.v, std::max(M, N));
+	T * const z   = reserve(s.z, std::max(M, N)+1);
+
+	// the distance transform across the rows
+	for (size_t m = 0; m < M; ++m) {
+		quadraticRow(score_in[m], score_tmp[m], Ix[m], v, z, N, fx, os.x);
+	}
+
+	// the distance transform down short columns, a block of contiguous columns at a time
+	if (M <= (size_t)bruteWidth((T*)NULL)) {
+		const size_t L = CpuDispatch::kernels().lanes;
+		const size_t step = score_tmp.step / sizeof(T);
+		assert(score_out.step / sizeof(T) == step && Iy.step / sizeof(int) == step);
+		for (size_t n0 = 0; n0 < N; n0 += L) {
+			quadraticBrute(score_tmp[0] + n0, score_out[0] + n0, Iy[0] + n0, M, std::min(L, N-n0), step, fy, os.y);
+		}
+		return;
+	}
+
+	// the distance transform down long columns, each made contiguous by a transpose
+	cv::Mat_<T> tmp_t(N, M, reserve(s.src, M*N));
+	cv::Mat_<T> out_t(N, M, reserve(s.dst, M*N));
+	cv::Mat_<int> Iy_t(N, M, reserve(s.ptr, M*N));
+	transpose(score_tmp, tmp_t);
+	for (size_t n = 0; n < N; ++n) {
+		quadraticRow(tmp_t[n], out_t[n], Iy_t[n], v, z, M, fy, os.y);
+	}
+	transpose(out_t, score_out);
+	transpose(Iy_t, Iy);
+}
+
+/*! @brief Distance transform with a bounded displacement
+ *
+ * Real parts are rarely displaced more than a few cells from their
+ * anchors, so on wide levels most of the lower envelope computed by the
+ * unbounded transform is wasted. This transform only considers
+ * displacements of up to radius.width cells in x and radius.height cells
+ * in y, and matches the unbounded transform wherever the unbounded
+ * argmax lies within the radius. The columns are transformed in place,
+ * without transposing
+ *
+ * @param score_in the input score
+ * @param fx the distance penalty function in the x-dimension
+ * @param fy the distance penalty function in the y-dimension
+ * @param os the anchor offset of the child from the parent
+ * @param radius the largest displacement in x and y
+ * @param score_out the distance transformed score
+ * @param Ix the distances in the x direction
+ * @param Iy the distances in the y direction
+ */
+template<typename T>
+void DistanceTransform<T>::compute(const cv::Mat_<T>& score_in, const Quadratic& fx, const Quadratic& fy, const cv::Point os, const cv::Size radius, cv::Mat_<T>& score_out, cv::Mat_<int>& Ix, cv::Mat_<int>& Iy) const {
+
+	const size_t M = score_in.rows;
+	const size_t N = score_in.cols;
+
+	// allocate the output and working matrices
+	score_out.create(cv::Size(N, M));
+	Ix.create(cv::Size(N, M));
+	Iy.create(cv::Size(N, M));
+	Scratch& s = scratch();
+	cv::Mat_<T> score_tmp(M, N, reserve(s.tmp, M*N));
+
+	// the distance transform across the rows
+	for (size_t m = 0; m < M; ++m) {
+		boundedRow(score_in[m], score_tmp[m], Ix[m], N, 1, fx.a, fx.b, os.x, radius.width);
+	}
+
+	// the distance transform down the columns, striding over the rows
+	const size_t step = score_tmp.step / sizeof(T);
+	assert(score_out.step / sizeof(T) == step && Iy.step / sizeof(int) == step);
+	for (size_t n = 0; n < N; ++n) {
+		boundedRow(score_tmp[0] + n, score_out[0] + n, Iy[0] + n, M, step, fy.a, fy.b, os.y, radius.height);
+	}
+
+	// get argmins, as the unbounded transform does
+	int * const row = reserve(s.row, N);
+	for (size_t m = 0; m < M; ++m) {
+		int * const Iy_ptr = Iy[m];
+		int * const Ix_ptr = Ix[m];
+		for (size_t n = 0; n < N; ++n) row[n] = Iy_ptr[Ix_ptr[n]];
+		for (size_t n = 0; n < N; ++n) Iy_ptr[n] = row[n];
+	}
+}
+
 #endif /* DISTANCETRANSFORM_HPP_ */
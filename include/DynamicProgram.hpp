@@ -40,10 +40,16 @@
 #define DYNAMICPROGRAM_HPP_
 #include <vector>
 #include <opencv2/core/core.hpp>
+#include <boost/shared_array.hpp>
+#include <boost/thread/mutex.hpp>
 #include "Candidate.hpp"
 #include "DistanceTransform.hpp"
+#include "DPPlan.hpp"
+#include "DPTensor.hpp"
 #include "Model.hpp"
 #include "Parts.hpp"
+#include "ResponseCache.hpp"
+#include "TaskScheduler.hpp"
 #include "types.hpp"
 
 
@@ -61,18 +67,70 @@
 template<typename T>
 class DynamicProgram {
 private:
+	//! the message passing state of a (scale, component)
+	struct Messages {
+		ResponseCache* scores;
+		DPTensor<T>* tables;
+		TaskGroup* group;
+		//! the level of the scores, and the scale and component of the tables
+		size_t level, n, c;
+		//! the accumulated score of each mixture of the component, once its children have passed their messages
+		vectorMat ncscores;
+		//! the distance transform of each mixture, and its argmax
+		vectorMat scoresp, Ixp, Iyp;
+		//! for each part, the messages it awaits, transforms in flight and messages left to send
+		std::vector<long> inputs, transforms, reductions;
+		//! a lock on the score of each part
+		boost::shared_array<boost::mutex> locks;
+		size_t nlocks;
+		//! the messages of every component at this scale, if they run together, else NULL
+		Messages* siblings;
+		Messages() : nlocks(0) {}
+		void init(const DPPlan<T>& plan, ResponseCache& scores, DPTensor<T>& tables, TaskGroup& group, size_t n, size_t c, size_t level = -1);
+	};
+	//! a root location over threshold, to be traced back down its tree
+	struct Hit {
+		size_t n, c;
+		cv::Point at;
+		//! the level coordinates of the tables' origin, if they cover a window of the level
+		cv::Point origin;
+		T score;
+		T scale;
+	};
 	//! the threshold for a positive detection
 	double thresh_;
 	DistanceTransform<T> dt_;
+	//! the part trees of the model, compiled
+	DPPlan<T> plan_;
+	//! the message passing state of min(), reused across frames
+	std::vector<Messages> messages_;
 	void distanceTransform1D(const T* src, T* dst, int* ptr, size_t n, T a, T b, int os);
 	void distanceTransform1DMat(const cv::Mat_<T>& src, cv::Mat_<T>& dst, cv::Mat_<int>& ptr, size_t N, T a, T b, int os);
+	void threshold(const cv::Mat& rootv, size_t n, size_t c, T scale, const cv::Point& origin, std::vector<Hit>& hits) const;
+	void backtrack(const DPTensor<T>& tables, const std::vector<Hit>& hits, vectorCandidate& candidates);
+	void backtrackBand(const DPTensor<T>& tables, const std::vector<Hit>& hits, const std::vector<size_t>& bounds, std::vector<vectorCandidate>& found, size_t b) const;
+	void seed(Messages& msg, std::vector<Task>& tasks, std::vector<double>& costs);
+	void transform(Messages* msg, size_t p, size_t m);
+	void reduce(Messages* msg, size_t p, size_t pm);
+	void deliver(Messages* msg, size_t p, size_t pm, const cv::Mat& maxv);
+	void root(Messages* msg);
+	static void pick(const vectorMat& Ixp, const vectorMat& Iyp, const cv::Mat& maxi, cv::Mat Ix, cv::Mat Iy, cv::Mat Ik);
 public:
 	DynamicProgram() {}
-	DynamicProgram(double thresh) : thresh_(thresh) {}
+	DynamicProgram(double thresh, Parts& parts) : thresh_(thresh), plan_(parts) {}
 	virtual ~DynamicProgram() {}
 	// public methods
-	void min(Parts& parts, vector2DMat& scores, vector4DMat& Ix, vector4DMat& Iy, vector4DMat& Ik, vector2DMat& rootv, vector2DMat& rooti);
-	void argmin(Parts& parts, const vector2DMat& rootv, const vector2DMat& rooti, const vectorf scales, const vector4DMat& Ix, const vector4DMat& Iy, const vector4DMat& Ik, vectorCandidate& candidates);
+	void min(vector2DMat& scores, DPTensor<T>& tables);
+	void min(ResponseCache& scores, DPTensor<T>& tables);
+	void minComponent(ResponseCache& scores, size_t m, DPTensor<T>& tables, size_t n, size_t c);
+	void argmin(const DPTensor<T>& tables, const vectorf scales, vectorCandidate& candidates);
+	void argminComponent(const DPTensor<T>& tables, const cv::Mat& rootv, size_t n, size_t c, T scale, vectorCandidate& candidates, const cv::Point& origin = cv::Point());
+	//! the threshold for a positive detection
+	double thresh(void) const { return thresh_; }
+	//! the part trees of the model, compiled when the program was constructed
+	const DPPlan<T>& plan(void) const { return plan_; }
+	//! bound the displacement of the parts (see DPPlan::bound())
+	void setDisplacement(int radius, double margin = 0) { plan_.bound(radius, margin); }
 	void distanceTransform(const cv::Mat& score_in, const vectorf w, cv::Point os, cv::Mat& score_out, cv::Mat& Ix, cv::Mat& Iy);
 };
 
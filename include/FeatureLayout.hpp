@@ -0,0 +1,201 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    FeatureLayout.hpp
+ *  Created: Oct 16, 2026
+ */
+
+#ifndef FEATURELAYOUT_HPP_
+#define FEATURELAYOUT_HPP_
+
+#include <vector>
+#include <opencv2/core/core.hpp>
+#include "types.hpp"
+
+/*! @class FeatureFormat
+ *  @brief the memory layout of the levels of a feature pyramid
+ *
+ *  INTERLEAVED levels are (rows, cols*flen) matrices, with the features of
+ *  each cell contiguous. PLANAR levels are (flen*(rows+2*pad.height),
+ *  cols+2*pad.width) matrices: flen channel planes stacked vertically, each
+ *  padded by pad, with zeros in every channel but the last (occlusion)
+ *  channel, which is padded with ones. The convolution engine states the
+ *  format it prefers, and the detector configures both the features and
+ *  the engine with it
+ */
+struct FeatureFormat {
+	enum Layout { INTERLEAVED, PLANAR };
+	//! the layout of each level
+	Layout layout;
+	//! the padding around each plane, in cells (PLANAR only)
+	cv::Size pad;
+	FeatureFormat(Layout l = INTERLEAVED, const cv::Size& p = cv::Size()) : layout(l), pad(p) {}
+};
+
+/*! @class FeatureLayout
+ *  @brief channel loops over the feature layouts, shared by the convolution engines
+ *
+ *  Levels are either INTERLEAVED or PLANAR (see FeatureFormat). The
+ *  padding and splitting loops read INTERLEAVED levels and write padded
+ *  planes, planes() views the planes of a PLANAR level in place, and
+ *  cells() and crop() handle either layout. The channel loops are
+ *  templates over the feature length, so the standard HOG configuration
+ *  (kStandardFlen features per cell) gets a fully unrolled loop with a
+ *  fixed stride. A length of 0 selects the generic path, where the
+ *  feature length is taken at runtime
+ */
+class FeatureLayout {
+private:
+	FeatureLayout() {}
+public:
+	//! the feature length of the standard HOG configuration (18 orientations)
+	static const int kStandardFlen = 32;
+
+	/*! @brief fill the padding of the last (occlusion) channel of a padded feature
+	 *
+	 * @param padded the padded feature
+	 * @param interior the unpadded region, in cells
+	 * @param cols the number of padded cells in each row
+	 * @param flen the length of the feature at each cell
+	 * @param value the value of the padding (one, or its quantized equivalent)
+	 */
+	template<typename T, int FLEN>
+	static void fillOcclusion(cv::Mat& padded, const cv::Rect& interior, int cols, int flen, T value) {
+		const int stride = FLEN ? FLEN : flen;
+		for (int y = 0; y < padded.rows; ++y) {
+			T* row = padded.ptr<T>(y) + stride-1;
+			if (y >= interior.y && y < interior.y + interior.height) {
+				for (int x = 0; x < interior.x; ++x) row[x*stride] = value;
+				for (int x = interior.x + interior.width; x < cols; ++x) row[x*stride] = value;
+			} else {
+				for (int x = 0; x < cols; ++x) row[x*stride] = value;
+			}
+		}
+	}
+
+	template<typename T>
+	static void fillOcclusion(cv::Mat& padded, const cv::Rect& interior, int cols, int flen, T value) {
+		if (flen == kStandardFlen) fillOcclusion<T, kStandardFlen>(padded, interior, cols, flen, value);
+		else fillOcclusion<T, 0>(padded, interior, cols, flen, value);
+	}
+
+	/*! @brief split an interleaved feature into padded channel planes
+	 *
+	 * The planes are de-interleaved and padded in a single pass. The
+	 * first flen-1 channels are zero-padded, the last channel is one-padded
+	 *
+	 * @param feature the interleaved feature
+	 * @param flen the length of the feature at each cell
+	 * @param pad the padding on each side, in cells
+	 * @param planes the output planes
+	 */
+	template<typename T, int FLEN>
+	static void splitPadded(const cv::Mat& feature, int flen, const cv::Size& pad, vectorMat& planes) {
+		const int L = FLEN ? FLEN : flen;
+		const int rows = feature.rows;
+		const int cols = feature.cols / L;
+		planes.resize(L);
+		std::vector<T*> dst(L);
+		for (int c = 0; c < L; ++c) {
+			planes[c].create(rows + 2*pad.height, cols + 2*pad.width, cv::DataType<T>::type);
+			planes[c].setTo(cv::Scalar::all(c == L-1 ? 1 : 0));
+		}
+		for (int y = 0; y < rows; ++y) {
+			const T* src = feature.ptr<T>(y);
+			for (int c = 0; c < L; ++c) dst[c] = planes[c].ptr<T>(y + pad.height) + pad.width;
+			for (int x = 0; x < cols; ++x, src += L) {
+				for (int c = 0; c < L; ++c) dst[c][x] = src[c];
+			}
+		}
+	}
+
+	template<typename T>
+	static void splitPadded(const cv::Mat& feature, int flen, const cv::Size& pad, vectorMat& planes) {
+		if (flen == kStandardFlen) splitPadded<T, kStandardFlen>(feature, flen, pad, planes);
+		else splitPadded<T, 0>(feature, flen, pad, planes);
+	}
+
+	/*! @brief the channel planes of a PLANAR level, as views into the level
+	 *
+	 * @param planar the level
+	 * @param flen the length of the feature at each cell
+	 * @param planes the output planes, including their padding
+	 */
+	static void planes(const cv::Mat& planar, int flen, vectorMat& planes) {
+		const int rows = planar.rows / flen;
+		planes.resize(flen);
+		for (int c = 0; c < flen; ++c) planes[c] = planar.rowRange(c*rows, (c+1)*rows);
+	}
+
+	/*! @brief the size of a level in cells, excluding any padding
+	 *
+	 * @param feature the level
+	 * @param flen the length of the feature at each cell
+	 * @param format the format of the level
+	 */
+	static cv::Size cells(const cv::Mat& feature, int flen, const FeatureFormat& format) {
+		if (format.layout == FeatureFormat::INTERLEAVED) return cv::Size(feature.cols / flen, feature.rows);
+		return cv::Size(feature.cols - 2*format.pad.width, feature.rows / flen - 2*format.pad.height);
+	}
+
+	/*! @brief copy a region of a level into a new level of the same format
+	 *
+	 * A PLANAR crop is padded as the level was, with zeros in every
+	 * channel but the last, which is padded with ones
+	 *
+	 * @param feature the level
+	 * @param flen the length of the feature at each cell
+	 * @param format the format of the level
+	 * @param region the region to copy, in (unpadded) cells
+	 * @param cropped the output level
+	 */
+	static void crop(const cv::Mat& feature, int flen, const FeatureFormat& format, const cv::Rect& region, cv::Mat& cropped) {
+		if (format.layout == FeatureFormat::INTERLEAVED) {
+			feature(cv::Rect(region.x*flen, region.y, region.width*flen, region.height)).copyTo(cropped);
+			return;
+		}
+		const cv::Size& pad = format.pad;
+		cropped.create(flen * (region.height + 2*pad.height), region.width + 2*pad.width, feature.type());
+		vectorMat src, dst;
+		planes(feature, flen, src);
+		planes(cropped, flen, dst);
+		const cv::Rect interior(pad.width, pad.height, region.width, region.height);
+		for (int c = 0; c < flen; ++c) {
+			dst[c].setTo(cv::Scalar::all(c == flen-1 ? 1 : 0));
+			cv::Mat out = dst[c](interior);
+			src[c](region + cv::Point(pad.width, pad.height)).copyTo(out);
+		}
+	}
+};
+
+#endif /* FEATURELAYOUT_HPP_ */
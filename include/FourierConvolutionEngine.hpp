@@ -51,12 +51,25 @@ private:
 	size_t flen_;
 	//! the internal representation of the filters
   vector2DMat filters_;
+	//! the format of the features
+	FeatureFormat format_;
+	//! the pyramid bound for on-demand responses
+	const vectorMat* bound_;
   void convolve(const cv::Mat& feature, vectorMat& filter, cv::Mat& pdf, const size_t channels);
+  void compute(const vectorMat& features, vector2DMat& responses, size_t mn);
 public:
 	FourierConvolutionEngine(const cv::Size& size, int type, size_t flen);
 	virtual ~FourierConvolutionEngine();
 	virtual void setFilters(const vectorMat& filters);
 	virtual void pdf(const vectorMat& features, vector2DMat& responses);
+	virtual FeatureFormat preferredFormat(void) const;
+	virtual void setFormat(const FeatureFormat& format);
+	virtual size_t nfilters(void) const { return filters_.size(); }
+	virtual void bind(const vectorMat& features);
+	virtual void prepare(size_t m);
+	virtual void response(size_t m, size_t n, cv::Mat& response);
+	virtual cv::Size responseSize(size_t m) const;
+	virtual void release(void);
 };
 
 #endif /* FOURIER_CONVOLUTION_ENGINE_HPP_ */
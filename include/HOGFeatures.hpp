@@ -65,10 +65,18 @@ private:
 	float sfactor_;
 	//! the interval between half resolution scales
 	size_t interval_;
+	//! the memory layout of the levels
+	FeatureFormat format_;
 
 	// private methods
 	void boundaryOcclusionFeature(cv::Mat& feature, const int flen, const int padsize);
+	void scaleChain(const cv::Mat& im, size_t i, const vectori& slot, vectorMat& pyraimages, PyramidChains* chains);
+	void levelFeatures(int depth, const vectorMat& pyraimages, vectorMat& pyrafeatures, size_t n) const;
 	template<typename IT> void features(const cv::Mat& im, cv::Mat& feature) const;
+	template<typename IT, int SBIN, int NORIENT> void features(const cv::Mat& im, cv::Mat& feature) const;
+	template<typename IT, int SBIN, int NORIENT> void histogramBand(const cv::Mat& im, cv::Mat& hist, cv::Mat& norm, const std::vector<size_t>& bounds, size_t b) const;
+	template<int NORIENT> void normalizeBand(const cv::Mat& hist, const cv::Mat& norm, cv::Mat& feature, const std::vector<size_t>& bounds, size_t b) const;
+	static void blockNorms(const T* norm, size_t normstride, size_t y, size_t N, double eps, T* dst);
 public:
 	HOGFeatures() {}
 	HOGFeatures(size_t binsize, size_t nscales, size_t flen, size_t norient) :
@@ -84,7 +92,11 @@ public:
 	size_t binsize(void) const { return binsize_; }
 	size_t nscales(void) const { return nscales_; }
 	vectorf scales(void) const { return scales_; }
+	vectorf scales(const cv::Size& imsize) const;
 	void pyramid(const cv::Mat& im, vectorMat& pyrafeatures);
+	void pyramid(const cv::Mat& im, const vectori& levels, vectorMat& pyrafeatures);
+	void pyramid(const cv::Mat& im, const vectori& levels, vectorMat& pyrafeatures, PyramidChains& chains);
+	void setFormat(const FeatureFormat& format) { format_ = format; }
 };
 
 #endif /* HOGFEATURES_HPP_ */
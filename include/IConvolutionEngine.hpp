@@ -40,6 +40,7 @@
 #define ICONVOLUTIONENGINE_HPP_
 
 #include "types.hpp"
+#include "FeatureLayout.hpp"
 
 class IConvolutionEngine {
 public:
@@ -65,6 +66,79 @@ public:
 	 * @param filters the vector of filters
 	 */
 	virtual void setFilters(const vectorMat& filters) = 0;
+
+	/*! @brief the feature format the engine would prefer to consume
+	 *
+	 * The detector negotiates the format once the filters are set: the
+	 * features are produced in the preferred format, and the engine is
+	 * told of it through setFormat(). Engines which read channel planes
+	 * can then take their planes straight from the features, rather than
+	 * de-interleaving each level themselves
+	 *
+	 * @return the preferred format
+	 */
+	virtual FeatureFormat preferredFormat(void) const = 0;
+
+	/*! @brief set the format of the features which will be passed to pdf()
+	 *
+	 * Every engine accepts INTERLEAVED features. Other formats may only
+	 * be set if the engine prefers them (or is documented to accept them)
+	 *
+	 * @param format the format of the features
+	 */
+	virtual void setFormat(const FeatureFormat& format) = 0;
+
+	//! the number of filters set by setFilters()
+	virtual size_t nfilters(void) const = 0;
+
+	/*! @brief bind a pyramid of features for on-demand responses
+	 *
+	 * Rather than computing every response up front with pdf(), the
+	 * responses of a bound pyramid are computed one at a time, as a
+	 * ResponseCache requests them, through prepare() and response().
+	 * The features must outlive the binding
+	 *
+	 * @param features the input pyramid of features
+	 */
+	virtual void bind(const vectorMat& features) = 0;
+
+	/*! @brief prepare a level of the bound pyramid
+	 *
+	 * Performs any per-level work shared by the filters (padding,
+	 * quantization, etc). Called once per level, before the first
+	 * response() at that level. Distinct levels may be prepared concurrently.
+	 * The caller holds the level's lock, so any parallel work must be
+	 * waited on with TaskScheduler::waitIsolated()
+	 *
+	 * @param m the level
+	 */
+	virtual void prepare(size_t m) = 0;
+
+	/*! @brief compute the response of a single filter at a prepared level
+	 *
+	 * May be called concurrently for distinct (level, filter) pairs. The
+	 * caller holds a lock while the response is computed, so the engine
+	 * must not wait on other tasks
+	 *
+	 * @param m the level
+	 * @param n the filter
+	 * @param response the response to return
+	 */
+	virtual void response(size_t m, size_t n, cv::Mat& response) = 0;
+
+	/*! @brief the size of the responses at a level of the bound pyramid
+	 *
+	 * Every filter produces a response of the same size at a given level,
+	 * so callers can allocate storage which depends on the response size
+	 * before any response has been computed
+	 *
+	 * @param m the level
+	 * @return the size of each response at level m
+	 */
+	virtual cv::Size responseSize(size_t m) const = 0;
+
+	//! release the bound pyramid and any per-level state
+	virtual void release(void) = 0;
 };
 
 
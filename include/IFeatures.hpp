@@ -41,6 +41,21 @@
 #include <vector>
 #include <opencv2/core/core.hpp>
 #include "types.hpp"
+#include "FeatureLayout.hpp"
+
+/*! @brief the state of a pyramid computed a few levels at a time
+ *
+ * A pyramid is built from chains of images, each the input image resized
+ * once and then repeatedly halved. Between batches of levels, the last
+ * image of each chain is kept here, so the next batch continues down the
+ * chain rather than resizing the input image again
+ */
+struct PyramidChains {
+	//! the last image computed on each chain
+	vectorMat images;
+	//! the level of each image, or -1 if the chain has not been started
+	vectori levels;
+};
 
 /*! @class Feature interface
  *  @brief Interface for creating and comparing image features
@@ -63,6 +78,14 @@ public:
 	 */
 	virtual vectorf scales(void) const = 0;
 
+	/*! @brief the vector of scales for an image of a given size
+	 *
+	 * the scales that pyramid() produces for an image of the given size,
+	 * computed without building the pyramid
+	 * @param imsize the size of the input image
+	 */
+	virtual vectorf scales(const cv::Size& imsize) const = 0;
+
 	/*! @brief a pyramid of features
 	 *
 	 * features calculated of a number of scales
@@ -70,6 +93,35 @@ public:
 	 * @param pyrafeatures an output vector of matrices of features, one matrix for each scale
 	 */
 	virtual void pyramid(const cv::Mat& im, vectorMat& pyrafeatures) = 0;
+
+	/*! @brief a subset of the levels of a pyramid of features
+	 *
+	 * features calculated at the requested levels of the pyramid only, so
+	 * that a large pyramid can be processed a few levels at a time
+	 * @param im the input image to calculate features for
+	 * @param levels the indices of the levels to compute, into scales(im.size())
+	 * @param pyrafeatures an output vector of matrices of features, one matrix for each requested level
+	 */
+	virtual void pyramid(const cv::Mat& im, const vectori& levels, vectorMat& pyrafeatures) = 0;
+
+	/*! @brief a subset of the levels of a pyramid of features, continuing from an earlier subset
+	 *
+	 * As pyramid(im, levels, pyrafeatures), but each chain of the pyramid
+	 * starts from the image left in chains by the previous call, if that
+	 * image lies above the requested levels. Batches of levels requested
+	 * fine to coarse therefore resize the input image once per chain
+	 * @param im the input image to calculate features for (the same image for every batch)
+	 * @param levels the indices of the levels to compute, into scales(im.size())
+	 * @param pyrafeatures an output vector of matrices of features, one matrix for each requested level
+	 * @param chains the state of the chains, empty before the first batch
+	 */
+	virtual void pyramid(const cv::Mat& im, const vectori& levels, vectorMat& pyrafeatures, PyramidChains& chains) = 0;
+
+	/*! @brief set the memory layout of the levels produced by pyramid()
+	 *
+	 * @param format the format negotiated with the convolution engine
+	 */
+	virtual void setFormat(const FeatureFormat& format) = 0;
 };
 
 //IFeatures::~IFeatures() {}
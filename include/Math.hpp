@@ -44,12 +44,39 @@
 #include <opencv2/core/core.hpp>
 #include <iostream>
 #include "types.hpp"
+#include "CpuDispatch.hpp"
 /*
  *
  */
 class Math {
 private:
 	Math() {}
+
+	// row kernels of the reductions. The types with vectorized kernels
+	// are dispatched to the instruction set selected by CpuDispatch
+	template<typename T>
+	static void maxRow(const T* src, int k, T* maxv, int* maxi, int n) {
+		for (int i = 0; i < n; ++i) if (src[i] > maxv[i]) { maxv[i] = src[i]; maxi[i] = k; }
+	}
+	static void maxRow(const float* src, int k, float* maxv, int* maxi, int n) {
+		CpuDispatch::kernels().maxf(src, k, maxv, maxi, n);
+	}
+	static void maxRow(const double* src, int k, double* maxv, int* maxi, int n) {
+		CpuDispatch::kernels().maxd(src, k, maxv, maxi, n);
+	}
+	template<typename T>
+	static void pickRow(const T* src, int k, const int* idx, T* dst, int n) {
+		for (int i = 0; i < n; ++i) if (idx[i] == k) dst[i] = src[i];
+	}
+	static void pickRow(const int* src, int k, const int* idx, int* dst, int n) {
+		CpuDispatch::kernels().picki(src, k, idx, dst, n);
+	}
+	static void pickRow(const float* src, int k, const int* idx, float* dst, int n) {
+		CpuDispatch::kernels().pickf(src, k, idx, dst, n);
+	}
+	static void pickRow(const double* src, int k, const int* idx, double* dst, int n) {
+		CpuDispatch::kernels().pickd(src, k, idx, dst, n);
+	}
 public:
 	virtual ~Math() {}
 
@@ -121,15 +148,12 @@ public:
 		// perform the indexing
 		size_t M = in[0].rows;
 		size_t N = in[0].cols;
-		std::vector<const T*> in_ptr(K);
-		if (in[0].isContinuous()) { N = M*N; M = 1; }
+		// select from one input at a time, so each pass is a contiguous blend
+		if (in[0].isContinuous() && idx.isContinuous()) { N = M*N; M = 1; }
 		for (size_t m = 0; m < M; ++m) {
 			T* out_ptr = out.ptr<T>(m);
-			const int*   idx_ptr = idx.ptr<int>(m);
-			for (size_t k = 0; k < K; ++k) in_ptr[k] = in[k].ptr<T>(m);
-			for (size_t n = 0; n < N; ++n) {
-				out_ptr[n] = in_ptr[idx_ptr[n]][n];
-			}
+			const int* idx_ptr = idx.ptr<int>(m);
+			for (size_t k = 0; k < K; ++k) pickRow(in[k].ptr<T>(m), k, idx_ptr, out_ptr, N);
 		}
 	}
 
@@ -167,19 +191,14 @@ public:
 		size_t M = in[0].rows;
 		size_t N = in[0].cols;
 
-		std::vector<const T*> in_ptr(K);
+		// accumulate one input at a time, so each pass is a contiguous running max
 		if (in[0].isContinuous()) { N = M*N; M = 1; }
 		for (size_t m = 0; m < M; ++m) {
 			T* maxv_ptr = maxv.ptr<T>(m);
 			int* maxi_ptr = maxi.ptr<int>(m);
-			for (size_t k = 0; k < K; ++k) in_ptr[k] = in[k].ptr<T>(m);
-			for (size_t n = 0; n < N; ++n) {
-				T v = -std::numeric_limits<T>::infinity();
-				int i = 0;
-				for (size_t k = 0; k < K; ++k) if (in_ptr[k][n] > v) { i = k; v = in_ptr[k][n]; }
-				maxi_ptr[n] = i;
-				maxv_ptr[n] = v;
-			}
+			const T* first = in[0].ptr<T>(m);
+			for (size_t n = 0; n < N; ++n) { maxv_ptr[n] = first[n]; maxi_ptr[n] = 0; }
+			for (size_t k = 1; k < K; ++k) maxRow(in[k].ptr<T>(m), k, maxv_ptr, maxi_ptr, N);
 		}
 	}
 
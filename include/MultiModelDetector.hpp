@@ -0,0 +1,150 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    MultiModelDetector.hpp
+ *  Created: Oct 16, 2026
+ */
+
+#ifndef MULTIMODELDETECTOR_HPP_
+#define MULTIMODELDETECTOR_HPP_
+
+#include <map>
+#include <string>
+#include <vector>
+#include <opencv2/core/core.hpp>
+#include <boost/shared_ptr.hpp>
+#include "Parts.hpp"
+#include "Model.hpp"
+#include "Candidate.hpp"
+#include "IFeatures.hpp"
+#include "IConvolutionEngine.hpp"
+#include "DynamicProgram.hpp"
+#include "PartsBasedDetector.hpp"
+#include "ResponseCache.hpp"
+#include "types.hpp"
+
+/*! @class MultiModelDetector
+ *  @brief detects several models in an image, sharing work between them
+ *
+ *  Models which share a feature configuration (binsize, interval, feature length
+ *  and number of orientations) are grouped. For each group the feature pyramid is
+ *  computed once, and the filters of all its models are concatenated into a single
+ *  convolution engine, so the pyramid is traversed once per group rather than once
+ *  per model. The engine is configured once, before the first detection after a
+ *  model is added, so a SPARSELET engine learns a single dictionary shared by every
+ *  model of the group. Each model then runs its own dynamic program, reading its
+ *  window of the group's responses, which are computed lazily on first read.
+ *
+ *  @code
+ *  MultiModelDetector<float> detector;
+ *  detector.setConvolutionType(PartsBasedDetector<float>::SEPARABLE);
+ *  detector.addModel(face_model);
+ *  detector.addModel(person_model);
+ *  std::map<std::string, vectorCandidate> candidates;
+ *  detector.detect(im, candidates);
+ *  @endcode
+ *
+ *  @tparam T the detector precision. Should be one of float or double
+ */
+template<typename T>
+class MultiModelDetector {
+public:
+	typedef typename PartsBasedDetector<T>::ConvolutionType ConvolutionType;
+private:
+	//! a set of models which share a feature configuration
+	struct FeatureGroup {
+		int binsize, nscales, flen, norient;
+		//! computes the feature pyramid of the group
+		boost::shared_ptr<IFeatures> features;
+		//! convolves the pyramid with the filters of every model of the group
+		boost::shared_ptr<IConvolutionEngine> engine;
+		//! the concatenated filters of the models
+		vectorMat filters;
+		//! the models of the group
+		vectori models;
+		//! whether the engine holds the current filters
+		bool ready;
+	};
+	//! a single model
+	struct ModelEntry {
+		std::string name;
+		Parts parts;
+		DynamicProgram<T> dp;
+		//! the tables of the dynamic program, reused across images
+		DPTensor<T> tables;
+		//! the feature group of the model
+		size_t group;
+		//! the range of the model's filters within the group's filters
+		size_t offset, nfilters;
+	};
+	std::vector<FeatureGroup> groups_;
+	std::vector<ModelEntry> models_;
+	//! the convolution engine of each group
+	ConvolutionType convolution_type_;
+	//! the energy threshold of the SEPARABLE convolution engine
+	double separable_energy_;
+	//! the dictionary of the SPARSELET convolution engine (empty to learn one)
+	std::string sparselet_dictionary_;
+	void prepare(FeatureGroup& group);
+	void invalidate(void);
+public:
+	MultiModelDetector() : convolution_type_(PartsBasedDetector<T>::SPATIAL), separable_energy_(0.9) {}
+	virtual ~MultiModelDetector() {}
+	void addModel(Model& model);
+	/*! @brief select the convolution engine of every group
+	 *
+	 * Takes effect at the next call to detect()
+	 * @param type the convolution engine
+	 */
+	void setConvolutionType(ConvolutionType type) { convolution_type_ = type; invalidate(); }
+	/*! @brief set the energy threshold of the SEPARABLE convolution engine
+	 *
+	 * Takes effect at the next call to detect()
+	 * @param energy the fraction of energy to retain, in (0, 1]
+	 */
+	void setSeparableEnergy(double energy) { separable_energy_ = energy; invalidate(); }
+	/*! @brief set the dictionary of the SPARSELET convolution engine
+	 *
+	 * The dictionary is loaded at the next call to detect(), which throws if
+	 * it cannot be loaded. If no dictionary is set, one is learned per group
+	 * @param filename a dictionary saved by SparseletConvolutionEngine::save()
+	 */
+	void setSparseletDictionary(const std::string& filename) { sparselet_dictionary_ = filename; invalidate(); }
+	void detect(const cv::Mat& im, std::map<std::string, vectorCandidate>& candidates);
+	//! the number of models
+	size_t nmodels(void) const { return models_.size(); }
+	//! the number of distinct feature pyramids computed per image
+	size_t ngroups(void) const { return groups_.size(); }
+};
+
+#endif /* MULTIMODELDETECTOR_HPP_ */
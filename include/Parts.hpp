@@ -166,6 +166,19 @@ public:
 		assert((*filterid_)[self_].size() > mixture);
 		return scores[(*filterid_)[self_][mixture]];
 	}
+	/*! @brief the part score, from any level of scores indexed by filter
+	 *
+	 * @param scores the scores, such as a ResponseCache::Level
+	 * @param mixture the part mixture to retrieve
+	 * @return the associated score for this part's mixture
+	 */
+	template<typename Scores>
+	const cv::Mat& score(const Scores& scores, size_t mixture = 0) const {
+		assert((*filterid_)[self_].size() > mixture);
+		return scores[(*filterid_)[self_][mixture]];
+	}
+	//! the index of the part's filter into filtersw_, and into scores
+	size_t filterid(size_t mixture = 0) const { return (*filterid_)[self_][mixture]; }
 	//! the part's filter index
 	int filteri(size_t mixture = 0) const { return (*filtersi_)[(*filterid_)[self_][mixture]]; }
 	//! the part's bias
@@ -38,6 +38,8 @@
 
 #ifndef PARTSBASEDDETECTOR_HPP_
 #define PARTSBASEDDETECTOR_HPP_
+#include <iostream>
+#include <limits>
 #include <string>
 #include <vector>
 #include <opencv2/core/core.hpp>
@@ -45,10 +47,15 @@
 #include "Parts.hpp"
 #include "Model.hpp"
 #include "Candidate.hpp"
+#include "DenseScores.hpp"
 #include "IFeatures.hpp"
 #include "IConvolutionEngine.hpp"
 #include "DynamicProgram.hpp"
+#include "BranchAndBound.hpp"
 #include "SearchSpacePruning.hpp"
+#include "Profiler.hpp"
+#include "ResponseCache.hpp"
+#include "TaskScheduler.hpp"
 
 /*! @mainpage PartsBasedDetector
  *
@@ -151,6 +158,20 @@
  */
 template<typename T>
 class PartsBasedDetector {
+public:
+	//! the convolution engines which distributeModel() can create
+	enum ConvolutionType {
+		//! exact floating point convolution
+		SPATIAL,
+		//! 16-bit fixed point convolution
+		QUANTIZED_INT16,
+		//! 8-bit fixed point convolution
+		QUANTIZED_INT8,
+		//! low-rank separable approximation of the filters
+		SEPARABLE,
+		//! sparse combinations of a shared dictionary of basis filters
+		SPARSELET
+	};
 private:
 	//! the name of the Part detector
 	std::string name_;
@@ -160,18 +181,158 @@ private:
 	boost::scoped_ptr<IConvolutionEngine> convolution_engine_;
 	//! dynamic program to predict part positions and candidate likelihoods from raw scores
 	DynamicProgram<T> dp_;
+	//! the tables of the dynamic program, reused across frames
+	DPTensor<T> tables_;
 	//! the tree of Parts
 	Parts parts_;
 	//! the search space pruner
 	SearchSpacePruning<T> ssp_;
+	//! best-first search for the top scoring detections
+	BranchAndBound<T> bb_;
+	//! per-stage timing and hardware counter instrumentation
+	Profiler profiler_;
+	//! the maximum working memory of the levels in flight (0 for unbounded)
+	size_t memory_budget_;
+	//! the approximate working memory per feature cell of a single level
+	size_t cell_bytes_;
+	//! the preferred scales of the anytime detector, searched first
+	vectorf priority_;
+	//! the time per byte of working memory last measured by the anytime detector
+	double anytime_rate_;
+	//! the convolution engine to create in distributeModel()
+	ConvolutionType convolution_type_;
+	//! the length of the feature at each cell
+	size_t flen_;
+	//! the fraction of filter energy retained by the separable approximation
+	double separable_energy_;
+	//! the file of the shared sparselet dictionary
+	std::string sparselet_dictionary_;
+	//! the root score a region must exceed to be searched by detectCoarseToFine()
+	double root_thresh_;
+	//! the size of the tiles of the screening grid, in cells
+	size_t screen_tile_;
+	//! the furthest extent of any part from the root, in cells
+	int reach_;
+	//! the bound on part displacements (see setMaxDisplacement())
+	int displacement_;
+	double displacement_margin_;
+	size_t levelBytes(const cv::Mat& im, float scale) const;
+	void detectLevels(const cv::Mat& im, const vectori& levels, const vectorf& scales, PyramidChains& chains, std::vector<Candidate>& candidates);
+	void search(vectorMat& pyramid, const vectorf& scales, const std::vector<cv::Point>& offsets, std::vector<Candidate>& candidates);
+	void screen(ResponseCache& roots, size_t n, std::vector<std::vector<cv::Rect> >& regions);
 public:
-	PartsBasedDetector() {}
+	PartsBasedDetector() : memory_budget_(0), cell_bytes_(0), anytime_rate_(0), convolution_type_(SPATIAL), flen_(0), separable_energy_(0.9),
+			root_thresh_(-std::numeric_limits<double>::infinity()), screen_tile_(8), reach_(0),
+			displacement_(0), displacement_margin_(0) {}
 	virtual ~PartsBasedDetector() {}
 	// public methods
 	const std::string& name(void) const { return name_; }
 	void detect(const cv::Mat& im, std::vector<Candidate>& candidates);
 	void detect(const cv::Mat& im, const cv::Mat& depth, std::vector<Candidate>& candidates);
+	void detect(const cv::Mat& im, double deadline, std::vector<Candidate>& candidates, std::vector<bool>& covered);
+	void detect(const cv::Mat& im, const std::vector<cv::Rect>& rois, std::vector<Candidate>& candidates);
+	void detectCoarseToFine(const cv::Mat& im, std::vector<Candidate>& candidates);
+	void detectTopK(const cv::Mat& im, size_t K, std::vector<Candidate>& candidates);
+	void detectDense(const cv::Mat& im, DenseScores& scores, cv::Mat* projection = NULL);
 	void distributeModel(Model& model);
+	static IConvolutionEngine* createEngine(ConvolutionType type, size_t flen, double separable_energy, const std::string& sparselet_dictionary);
+	void calibrate(const cv::Mat& im, std::ostream& os);
+	/*! @brief select the convolution engine
+	 *
+	 * Takes effect at the next call to distributeModel()
+	 * @param type the convolution engine
+	 */
+	void setConvolutionType(ConvolutionType type) { convolution_type_ = type; }
+	/*! @brief set the energy threshold of the SEPARABLE convolution engine
+	 *
+	 * Each filter is approximated by the fewest separable terms which retain
+	 * this fraction of its energy. Takes effect at the next call to distributeModel()
+	 * @param energy the fraction of energy to retain, in (0, 1]
+	 */
+	void setSeparableEnergy(double energy) { separable_energy_ = energy; }
+	/*! @brief set the dictionary of the SPARSELET convolution engine
+	 *
+	 * The dictionary is loaded at the next call to distributeModel(), which
+	 * throws if it cannot be loaded (or was saved for another feature length).
+	 * If no dictionary is set, one is learned from the filters of the model
+	 * @param filename a dictionary saved by SparseletConvolutionEngine::save()
+	 */
+	void setSparseletDictionary(const std::string& filename) { sparselet_dictionary_ = filename; }
+	/*! @brief enable per-stage profiling of detect()
+	 *
+	 * @param enabled collect per-stage wall time
+	 * @param hardware_counters also collect cycles, instructions, LLC and branch misses
+	 * via perf_event_open() where supported
+	 */
+	void enableProfiling(bool enabled, bool hardware_counters = true) { profiler_.enable(enabled, hardware_counters); }
+	/*! @brief set the number of threads used by detect()
+	 *
+	 * @param nthreads the number of threads (0 for the number of cores)
+	 * @param affinity pin each worker thread to a core
+	 */
+	void setNumThreads(size_t nthreads, bool affinity = false) {
+		TaskScheduler::global().configure(nthreads, affinity);
+		if (profiler_.enabled()) profiler_.enable(true, profiler_.hardwareCounters());
+	}
+	/*! @brief bound the memory used by detect()
+	 *
+	 * By default detect() materializes the whole feature pyramid, every
+	 * response and every dynamic program table before backtracking. With a
+	 * budget, the pyramid is instead processed a few levels at a time, with
+	 * as many levels in flight as fit in the budget (but always at least one)
+	 *
+	 * @param bytes the approximate peak working memory, or 0 for unbounded
+	 */
+	void setMemoryBudget(size_t bytes) { memory_budget_ = bytes; }
+	/*! @brief set the order in which the anytime detector searches scales
+	 *
+	 * Levels of the pyramid are searched in order of their distance (in log scale)
+	 * to the nearest preferred scale. With no preferred scales, the pyramid is
+	 * searched coarse to fine, since the coarse levels are the cheapest
+	 *
+	 * @param scales the preferred scales, in the units of scales()
+	 */
+	void setScalePriority(const vectorf& scales) { priority_ = scales; }
+	/*! @brief configure the screening of detectCoarseToFine()
+	 *
+	 * Each level is divided into tiles, and a tile is searched with the full
+	 * model only if the root filter alone (plus its bias) scores above the
+	 * threshold somewhere within it. The threshold trades recall for speed:
+	 * it should sit below the model threshold by the largest contribution
+	 * the parts are expected to make
+	 *
+	 * @param root_thresh the root score a tile must exceed
+	 * @param tile the size of the tiles, in cells
+	 */
+	void setCoarseToFine(double root_thresh, size_t tile = 8) { root_thresh_ = root_thresh; screen_tile_ = std::max(tile, (size_t)1); }
+	/*! @brief configure the branch and bound search of detectTopK()
+	 *
+	 * A larger radius tightens the bound on parts displaced beyond it, but
+	 * loosens the bound within it and enlarges the windows scored exactly
+	 *
+	 * @param radius the displacement of a part from its anchor covered by the windowed bound, in cells
+	 * @param leaf the side of the regions scored exactly, in cells
+	 */
+	void setBranchAndBound(int radius, int leaf = 8) { bb_ = BranchAndBound<T>(radius, std::max(leaf, 1)); }
+	/*! @brief bound the displacement of the parts from their anchors
+	 *
+	 * The distance transforms then only search displacements within the
+	 * bound, which is much cheaper on wide levels. Detections are unchanged
+	 * wherever the best displacement of every part lies within the bound
+	 *
+	 * @param radius the largest displacement in cells, for every part (0 to derive it from the margin)
+	 * @param margin derive each part's bound from its deformation weights: the
+	 * displacement beyond which the deformation costs more than margin (0 for unbounded)
+	 */
+	void setMaxDisplacement(int radius, double margin = 0) {
+		displacement_ = std::max(radius, 0);
+		displacement_margin_ = margin;
+		dp_.setDisplacement(displacement_, displacement_margin_);
+	}
+	//! the scales of the pyramid searched for an image of the given size
+	vectorf scales(const cv::Size& imsize) const { return features_->scales(imsize); }
+	//! the per-stage statistics of the most recent call to detect()
+	const DetectorStats& stats(void) const { return profiler_.stats(); }
 };
 
 #endif /* PARTSBASEDDETECTOR_HPP_ */
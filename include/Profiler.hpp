@@ -0,0 +1,172 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    Profiler.hpp
+ *  Created: Oct 16, 2026
+ */
+
+#ifndef PROFILER_HPP_
+#define PROFILER_HPP_
+
+#include <iostream>
+#include <vector>
+#include <stdint.h>
+#include <boost/thread/mutex.hpp>
+
+/*! @class HardwareCounters
+ *  @brief a set of hardware performance counters, one group per thread
+ *
+ *  HardwareCounters wraps the Linux perf_event_open() interface to count cycles,
+ *  instructions, last-level cache misses and branch misses. Counters are opened
+ *  per thread, since a counter bound to a thread only sees the work executed by
+ *  that thread. Each thread which participates in detection registers itself by
+ *  calling attach() from within that thread.
+ *
+ *  When the library is built without WITH_PERF_EVENTS, or the kernel refuses to
+ *  open a counter (no PMU in a VM, perf_event_paranoid too strict, seccomp, etc)
+ *  the counter is simply marked as unavailable and reads as zero
+ */
+class HardwareCounters {
+public:
+	//! the counted hardware events
+	enum Event { CYCLES = 0, INSTRUCTIONS, LLC_MISSES, BRANCH_MISSES, NEVENTS };
+	//! a snapshot of the counter values
+	struct Values {
+		uint64_t count[NEVENTS];
+		Values() { for (int e = 0; e < NEVENTS; ++e) count[e] = 0; }
+	};
+private:
+	//! the file descriptors of each attached thread, NEVENTS per thread
+	std::vector<int> fds_;
+	//! whether each event could be opened on at least one thread
+	bool available_[NEVENTS];
+	//! serializes attach() calls from concurrent threads
+	boost::mutex mutex_;
+	HardwareCounters(const HardwareCounters&);
+	HardwareCounters& operator=(const HardwareCounters&);
+public:
+	HardwareCounters();
+	virtual ~HardwareCounters();
+	void attach(void);
+	void read(Values& values) const;
+	void close(void);
+	//! true if the given event is counted on at least one thread
+	bool available(Event e) const { return available_[e]; }
+	//! true if any event is counted
+	bool available(void) const;
+	//! the number of attached threads
+	size_t nthreads(void) const { return fds_.size() / NEVENTS; }
+};
+
+/*! @class StageStats
+ *  @brief the cost of a single stage of the detection pipeline for one frame
+ */
+struct StageStats {
+	//! the wall time spent in the stage (seconds)
+	double seconds;
+	//! the hardware counter deltas, summed over all attached threads
+	HardwareCounters::Values counters;
+	//! which of the counters are valid
+	bool valid[HardwareCounters::NEVENTS];
+	StageStats() : seconds(0) { for (int e = 0; e < HardwareCounters::NEVENTS; ++e) valid[e] = false; }
+	//! instructions per cycle, or 0 if unavailable
+	double ipc(void) const;
+	//! misses per thousand instructions, or 0 if unavailable
+	double mpki(HardwareCounters::Event e) const;
+};
+
+/*! @class DetectorStats
+ *  @brief per-frame timing and hardware counter statistics, broken down by stage
+ */
+class DetectorStats {
+public:
+	//! the instrumented stages of PartsBasedDetector::detect(). CONVOLUTION includes the responses computed on demand within DP_MIN
+	enum Stage { PYRAMID = 0, CONVOLUTION, DP_MIN, ARGMIN, NSTAGES };
+	//! the stages
+	StageStats stages[NSTAGES];
+	//! reset the statistics before a new frame
+	void clear(void) { for (int s = 0; s < NSTAGES; ++s) stages[s] = StageStats(); }
+	//! the total wall time of the frame (seconds)
+	double seconds(void) const;
+	//! a human readable name of a stage
+	static const char* name(Stage stage);
+	void print(std::ostream& os) const;
+};
+
+/*! @class Profiler
+ *  @brief measures the stages of the detection pipeline
+ *
+ *  Profiler brackets each stage with start() and stop(), recording the wall time
+ *  and, if enabled, hardware counters. When disabled, start() and stop() cost
+ *  little more than a function call
+ *
+ *  @code
+ *  profiler.start();
+ *  features_->pyramid(im, pyramid);
+ *  profiler.stop(DetectorStats::PYRAMID);
+ *  @endcode
+ */
+class Profiler {
+private:
+	//! whether profiling is enabled
+	bool enabled_;
+	//! whether hardware counters were requested
+	bool hardware_counters_;
+	//! the hardware counters
+	HardwareCounters counters_;
+	//! the counters at the start of the current stage
+	HardwareCounters::Values start_counters_;
+	//! the tick count at the start of the current stage
+	int64_t start_ticks_;
+	//! the accumulated statistics of the current frame
+	DetectorStats stats_;
+public:
+	Profiler() : enabled_(false), hardware_counters_(false), start_ticks_(0) {}
+	virtual ~Profiler() {}
+	void enable(bool enabled, bool hardware_counters = true);
+	//! is profiling enabled
+	bool enabled(void) const { return enabled_; }
+	//! were hardware counters requested
+	bool hardwareCounters(void) const { return hardware_counters_; }
+	//! the hardware counters, so that additional threads can attach()
+	HardwareCounters& counters(void) { return counters_; }
+	//! reset the per-frame statistics
+	void clear(void) { stats_.clear(); }
+	void start(void);
+	void stop(DetectorStats::Stage stage);
+	void transfer(DetectorStats::Stage from, DetectorStats::Stage to, double thread_seconds);
+	//! the statistics of the most recent frame
+	const DetectorStats& stats(void) const { return stats_; }
+};
+
+#endif /* PROFILER_HPP_ */
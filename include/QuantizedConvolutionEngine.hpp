@@ -0,0 +1,103 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    QuantizedConvolutionEngine.hpp
+ *  Created: Oct 16, 2026
+ */
+
+#ifndef QUANTIZED_CONVOLUTION_ENGINE_HPP_
+#define QUANTIZED_CONVOLUTION_ENGINE_HPP_
+
+#include <cassert>
+#include "IConvolutionEngine.hpp"
+
+/*! @class QuantizedConvolutionEngine
+ *  @brief fixed-point convolution of features with filters
+ *
+ *  HOG features are bounded (each orientation is truncated at 0.2, and the
+ *  occlusion channel is 0 or 1), and filter weights have a modest dynamic
+ *  range, so both quantize well. Each level of the pyramid is quantized with
+ *  its own scale, as is each filter, and the responses are accumulated as
+ *  32-bit integer dot products of whole filter rows with the interleaved
+ *  feature rows, then dequantized to the floating point type of the filters.
+ *
+ *  With 16-bit quantization, the scales are chosen so that the largest
+ *  possible sum cannot overflow the accumulator. With 8-bit quantization,
+ *  features are unsigned and filters signed, which maps onto the
+ *  unsigned-by-signed multiply-add of SSSE3 and AVX2.
+ *
+ *  The score error against the floating point engine can be measured with
+ *  ConvolutionCalibration
+ */
+class QuantizedConvolutionEngine: public IConvolutionEngine {
+private:
+	//! the floating point type of the responses, taken from the filter type
+	int type_;
+	//! the number of layers to each filter
+	size_t flen_;
+	//! the number of bits per quantized value (8 or 16)
+	int bits_;
+	//! the largest quantized feature and filter magnitudes
+	double fmax_, wmax_;
+	//! the quantized filters, each row zero-padded to a multiple of the vector width
+	vectorMat filters_;
+	//! the spatial size of each filter
+	std::vector<cv::Size> fsize_;
+	//! the quantization scale of each filter
+	std::vector<double> wscale_;
+	//! the padding required around each feature by the largest filter
+	cv::Size pad_;
+	//! the pyramid bound for on-demand responses
+	const vectorMat* bound_;
+	//! the quantized levels of the bound pyramid, and their scales
+	vectorMat quantized_;
+	std::vector<double> fscale_;
+	void quantize(const vectorMat& features, vectorMat& quantized, std::vector<double>& fscale, size_t m);
+	void convolve(const cv::Mat& feature, double fscale, size_t n, cv::Mat& pdf, size_t y0, size_t y1);
+public:
+	QuantizedConvolutionEngine(int type, size_t flen, int bits = 16);
+	virtual ~QuantizedConvolutionEngine();
+	virtual void setFilters(const vectorMat& filters);
+	virtual void pdf(const vectorMat& features, vector2DMat& responses);
+	//! the engine reads interleaved features only
+	virtual FeatureFormat preferredFormat(void) const { return FeatureFormat(); }
+	virtual void setFormat(const FeatureFormat& format) { assert(format.layout == FeatureFormat::INTERLEAVED); }
+	virtual size_t nfilters(void) const { return filters_.size(); }
+	virtual void bind(const vectorMat& features);
+	virtual void prepare(size_t m);
+	virtual void response(size_t m, size_t n, cv::Mat& response);
+	virtual cv::Size responseSize(size_t m) const;
+	virtual void release(void);
+};
+
+#endif /* QUANTIZED_CONVOLUTION_ENGINE_HPP_ */
@@ -0,0 +1,133 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    ResponseCache.hpp
+ *  Created: Oct 16, 2026
+ */
+
+#ifndef RESPONSE_CACHE_HPP_
+#define RESPONSE_CACHE_HPP_
+
+#include <vector>
+#include <stdint.h>
+#include <opencv2/core/core.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/thread/mutex.hpp>
+#include "IConvolutionEngine.hpp"
+#include "types.hpp"
+
+/*! @class ResponseCache
+ *  @brief filter responses, computed on first access and memoized
+ *
+ *  The cache presents the same (level, filter) indexing as the vector2DMat
+ *  returned by IConvolutionEngine::pdf(), but when bound to an engine, a
+ *  response is only computed the first time it is read, and each level is
+ *  only prepared (padded, quantized, etc) the first time one of its
+ *  responses is read. Stages which skip levels or parts of the model (scale
+ *  bands, anytime search, cascades) therefore also skip their convolutions.
+ *
+ *  Responses may be read concurrently. Each response is computed exactly
+ *  once, under its own lock, by the first thread to read it.
+ *
+ *  A cache can also be filled with precomputed responses, in which case
+ *  reads are plain lookups.
+ *
+ *  Reads can be restricted to a window of consecutive filters, so that
+ *  several models whose filters were concatenated into one engine can
+ *  each read their own filters, indexed from zero, from a shared cache.
+ *
+ *  The time spent preparing levels and computing responses is accumulated
+ *  over all reading threads, so the convolutions can be accounted to their
+ *  own stage although they run inside the tasks of the stage which reads them
+ */
+class ResponseCache {
+public:
+	/*! @class Level
+	 *  @brief the responses of every filter at a single level, indexed by filter
+	 */
+	class Level {
+	private:
+		ResponseCache* cache_;
+		size_t m_;
+	public:
+		Level(ResponseCache& cache, size_t m) : cache_(&cache), m_(m) {}
+		//! the number of filters
+		size_t size(void) const { return cache_->nfilters(); }
+		//! the response of filter n, computed if necessary
+		const cv::Mat& operator[](size_t n) const { return cache_->at(m_, n); }
+	};
+private:
+	//! the engine which computes responses on demand, or NULL if they were precomputed
+	IConvolutionEngine* engine_;
+	//! the bound pyramid of features
+	const vectorMat* features_;
+	//! the number of filters
+	size_t nfilters_;
+	//! the window of filters read through at(): its first filter and size
+	size_t offset_, window_;
+	//! the responses computed so far, by level then filter
+	vector2DMat responses_;
+	//! whether each level has been prepared
+	std::vector<char> prepared_;
+	//! whether each response has been computed
+	std::vector<char> computed_;
+	//! a lock for each level, and for each response
+	boost::scoped_array<boost::mutex> level_mutex_;
+	boost::scoped_array<boost::mutex> response_mutex_;
+	//! the ticks spent computing responses, summed over threads
+	volatile int64_t ticks_;
+	void prepare(size_t m);
+	ResponseCache(const ResponseCache&);
+	ResponseCache& operator=(const ResponseCache&);
+public:
+	ResponseCache() : engine_(NULL), features_(NULL), nfilters_(0), offset_(0), window_(0), ticks_(0) {}
+	explicit ResponseCache(const vector2DMat& responses);
+	virtual ~ResponseCache() { clear(); }
+	void bind(IConvolutionEngine& engine, const vectorMat& features);
+	void assign(const vector2DMat& responses);
+	void clear(void);
+	const cv::Mat& at(size_t m, size_t n);
+	void setWindow(size_t offset, size_t nfilters);
+	double cost(size_t m) const;
+	cv::Size levelSize(size_t m) const;
+	size_t ncomputed(void) const;
+	double seconds(void) const;
+	//! the number of levels
+	size_t size(void) const { return responses_.size(); }
+	//! the number of filters at each level, within the window
+	size_t nfilters(void) const { return window_; }
+	//! the responses of level m
+	Level operator[](size_t m) { return Level(*this, m); }
+};
+
+#endif /* RESPONSE_CACHE_HPP_ */
@@ -0,0 +1,110 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    SeparableConvolutionEngine.hpp
+ *  Created: Oct 16, 2026
+ */
+
+#ifndef SEPARABLE_CONVOLUTION_ENGINE_HPP_
+#define SEPARABLE_CONVOLUTION_ENGINE_HPP_
+
+#include <cassert>
+#include <iostream>
+#include "IConvolutionEngine.hpp"
+
+/*! @class SeparableConvolutionEngine
+ *  @brief convolution with low-rank separable approximations of the filters
+ *
+ *  Each filter of size fh x fw x flen is reshaped into a fh x (fw*flen) matrix
+ *  and factored by SVD into a sum of rank-1 terms, each the outer product of a
+ *  column filter of length fh and a multichannel row filter of length fw*flen.
+ *  The smallest rank which retains the requested fraction of the filter's
+ *  energy (sum of squared singular values) is kept.
+ *
+ *  A rank r filter is applied as r row passes over the interleaved feature
+ *  rows, followed by r column passes, costing r*(fw*flen + fh) multiply-adds
+ *  per response rather than fh*fw*flen. Since the row filters span every
+ *  channel, this only saves work while r is well below fh, so a filter whose
+ *  approximation would cost as much as the filter itself is applied directly
+ */
+class SeparableConvolutionEngine: public IConvolutionEngine {
+private:
+	//! the internally supported convolution type, taken from the filter type
+	int type_;
+	//! the number of layers to each filter
+	size_t flen_;
+	//! the fraction of each filter's energy to retain
+	double energy_;
+	//! the row filters of each filter, one rank-1 term per row
+	vectorMat rowf_;
+	//! the column filters of each filter, one rank-1 term per column
+	vectorMat colf_;
+	//! the filters applied directly, where no approximation saves work (empty otherwise)
+	vectorMat fullf_;
+	//! the spatial size of each filter
+	std::vector<cv::Size> fsize_;
+	//! the rank chosen for each filter
+	vectori ranks_;
+	//! the relative Frobenius norm of the residual of each filter
+	std::vector<double> residual_;
+	//! the padding required around each feature by the largest filter
+	cv::Size pad_;
+	//! the pyramid bound for on-demand responses
+	const vectorMat* bound_;
+	//! the padded levels of the bound pyramid
+	vectorMat padded_;
+	void pad(const vectorMat& features, vectorMat& padded, size_t m);
+	void convolve(const cv::Mat& feature, size_t n, cv::Mat& pdf, size_t y0, size_t y1);
+	double cost(size_t n) const;
+public:
+	SeparableConvolutionEngine(int type, size_t flen, double energy = 0.9);
+	virtual ~SeparableConvolutionEngine();
+	virtual void setFilters(const vectorMat& filters);
+	virtual void pdf(const vectorMat& features, vector2DMat& responses);
+	//! the engine reads interleaved features only
+	virtual FeatureFormat preferredFormat(void) const { return FeatureFormat(); }
+	virtual void setFormat(const FeatureFormat& format) { assert(format.layout == FeatureFormat::INTERLEAVED); }
+	virtual size_t nfilters(void) const { return rowf_.size(); }
+	virtual void bind(const vectorMat& features);
+	virtual void prepare(size_t m);
+	virtual void response(size_t m, size_t n, cv::Mat& response);
+	virtual cv::Size responseSize(size_t m) const;
+	virtual void release(void);
+	//! the rank chosen for each filter, or 0 if it is applied directly
+	const vectori& ranks(void) const { return ranks_; }
+	//! the relative Frobenius norm of the approximation error of each filter
+	const std::vector<double>& residuals(void) const { return residual_; }
+	void report(std::ostream& os) const;
+};
+
+#endif /* SEPARABLE_CONVOLUTION_ENGINE_HPP_ */
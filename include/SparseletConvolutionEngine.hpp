@@ -0,0 +1,134 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    SparseletConvolutionEngine.hpp
+ *  Created: Oct 16, 2026
+ */
+
+#ifndef SPARSELET_CONVOLUTION_ENGINE_HPP_
+#define SPARSELET_CONVOLUTION_ENGINE_HPP_
+
+#include <cassert>
+#include <string>
+#include <vector>
+#include "IConvolutionEngine.hpp"
+
+/*! @class SparseletConvolutionEngine
+ *  @brief convolution through a shared dictionary of small basis filters
+ *
+ *  Each part filter is divided into blocks of block x block cells, and each
+ *  block is represented as a sparse linear combination of the atoms of a
+ *  dictionary (sparselets). Each level of the pyramid is convolved with every
+ *  atom exactly once, and the response of each part filter is reconstructed
+ *  as a sum of shifted, weighted atom responses.
+ *
+ *  Since the dictionary is shared, the cost of adding filters (more parts,
+ *  components, or whole models) grows with the number of nonzeros in their
+ *  codes, rather than with their size.
+ *
+ *  A dictionary can be learned from a bank of filters with learn(), which
+ *  alternates orthogonal matching pursuit and the method of optimal directions,
+ *  and stored with save() for reuse across models
+ */
+class SparseletConvolutionEngine: public IConvolutionEngine {
+private:
+	//! a single term of a filter's sparse code
+	struct Term {
+		//! the atom
+		int atom;
+		//! the offset of the block within the filter, in cells
+		int dy, dx;
+		//! the weight of the atom
+		double alpha;
+		Term(int a, int y, int x, double w) : atom(a), dy(y), dx(x), alpha(w) {}
+	};
+	//! the internally supported convolution type, taken from the filter type
+	int type_;
+	//! the number of layers to each filter
+	size_t flen_;
+	//! the spatial size of each block (and atom)
+	size_t block_;
+	//! the maximum number of atoms used to represent each block
+	size_t sparsity_;
+	//! the dictionary, one unit-norm atom of block*block*flen per row
+	cv::Mat dictionary_;
+	//! the dictionary, converted to the convolution type
+	cv::Mat typed_;
+	//! the sparse code of each filter
+	std::vector<std::vector<Term> > codes_;
+	//! the spatial size of each filter
+	std::vector<cv::Size> fsize_;
+	//! the relative Frobenius norm of the residual of each filter
+	std::vector<double> residual_;
+	//! the padding required around each feature by the largest (block-aligned) filter
+	cv::Size pad_;
+	//! the pyramid bound for on-demand responses
+	const vectorMat* bound_;
+	//! the atom responses of each prepared level of the bound pyramid
+	vector2DMat atomr_;
+	void blocks(const cv::Mat& filter, cv::Mat& samples, std::vector<cv::Point>& offsets) const;
+	void pad(const cv::Mat& feature, cv::Mat& padded) const;
+	void padLevel(const vectorMat& features, vectorMat& padded, size_t m) const;
+	void atoms(const cv::Mat& feature, vectorMat& responses, size_t y0, size_t y1) const;
+	void atomsBand(const cv::Mat& feature, vectorMat& responses, const std::vector<size_t>& bounds, size_t b) const;
+	void combine(const vectorMat& atoms, const cv::Mat& feature, size_t n, cv::Mat& response);
+	void reconstruct(const vector2DMat& atoms, vector2DMat& responses, const vectorMat& features, size_t mn);
+public:
+	SparseletConvolutionEngine(int type, size_t flen, size_t block = 3, size_t sparsity = 4);
+	virtual ~SparseletConvolutionEngine();
+	virtual void setFilters(const vectorMat& filters);
+	virtual void pdf(const vectorMat& features, vector2DMat& responses);
+	//! the engine reads interleaved features only
+	virtual FeatureFormat preferredFormat(void) const { return FeatureFormat(); }
+	virtual void setFormat(const FeatureFormat& format) { assert(format.layout == FeatureFormat::INTERLEAVED); }
+	virtual size_t nfilters(void) const { return codes_.size(); }
+	virtual void bind(const vectorMat& features);
+	virtual void prepare(size_t m);
+	virtual void response(size_t m, size_t n, cv::Mat& response);
+	virtual cv::Size responseSize(size_t m) const;
+	virtual void release(void);
+	void learn(const vectorMat& filters, size_t natoms, size_t iterations = 10);
+	//! set the dictionary (one atom per row). Must precede setFilters()
+	void setDictionary(const cv::Mat& dictionary);
+	//! the dictionary, one atom per row
+	const cv::Mat& dictionary(void) const { return dictionary_; }
+	bool save(const std::string& filename) const;
+	bool load(const std::string& filename);
+	//! the relative Frobenius norm of the approximation error of each filter
+	const std::vector<double>& residuals(void) const { return residual_; }
+	//! the average number of terms per filter
+	double termsPerFilter(void) const;
+	static void code(const cv::Mat& dictionary, const cv::Mat& sample, size_t sparsity, vectori& support, cv::Mat& coefficients);
+};
+
+#endif /* SPARSELET_CONVOLUTION_ENGINE_HPP_ */
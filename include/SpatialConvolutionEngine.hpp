@@ -47,14 +47,31 @@ private:
 	int type_;
 	//! the number of layers to each filter
 	size_t flen_;
-	//! the internal representation of the filters
-	vector2DFilterEngine filters_;
-	void convolve(const cv::Mat& feature, vectorFilterEngine& filter, cv::Mat& pdf, const size_t stride);
+	//! the internal representation of the filters, split into channel planes
+	vector2DMat filters_;
+	//! the padding required around each feature plane by the largest filter
+	cv::Size pad_;
+	//! the format of the features
+	FeatureFormat format_;
+	//! the pyramid bound for on-demand responses
+	const vectorMat* bound_;
+	//! the padded planes of each prepared level of the bound pyramid
+	vector2DMat planes_;
+	void split(const vectorMat& features, vector2DMat& planes, size_t m);
+	void convolve(const vectorMat& planes, size_t n, cv::Mat& pdf, size_t y0, size_t y1);
 public:
 	SpatialConvolutionEngine(int type, size_t flen);
 	virtual ~SpatialConvolutionEngine();
 	virtual void setFilters(const vectorMat& filters);
 	virtual void pdf(const vectorMat& features, vector2DMat& responses);
+	virtual FeatureFormat preferredFormat(void) const;
+	virtual void setFormat(const FeatureFormat& format);
+	virtual size_t nfilters(void) const { return filters_.size(); }
+	virtual void bind(const vectorMat& features);
+	virtual void prepare(size_t m);
+	virtual void response(size_t m, size_t n, cv::Mat& response);
+	virtual cv::Size responseSize(size_t m) const;
+	virtual void release(void);
 };
 
 #endif /* SPATIAL_CONVOLUTION_ENGINE_HPP_ */
@@ -0,0 +1,155 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    TaskScheduler.hpp
+ *  Created: Oct 16, 2026
+ */
+
+#ifndef TASKSCHEDULER_HPP_
+#define TASKSCHEDULER_HPP_
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <boost/function.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/thread.hpp>
+
+//! a unit of work
+typedef boost::function<void (void)> Task;
+//! the body of a parallel loop, called with the iteration index
+typedef boost::function<void (size_t)> LoopBody;
+
+/*! @class TaskGroup
+ *  @brief a set of tasks which can be waited on as a whole
+ *
+ *  Tasks are added to a group with TaskScheduler::run(), and the group
+ *  is joined with TaskScheduler::wait(). Groups may be nested: a task
+ *  can create its own group, spawn subtasks into it and wait on them
+ */
+class TaskGroup {
+private:
+	friend class TaskScheduler;
+	//! the number of tasks which have not yet finished
+	volatile long pending_;
+	//! the first error raised by a task of the group
+	std::string error_;
+	boost::mutex mutex_;
+	boost::condition_variable finished_;
+	TaskGroup(const TaskGroup&);
+	TaskGroup& operator=(const TaskGroup&);
+public:
+	TaskGroup() : pending_(0) {}
+	virtual ~TaskGroup() {}
+};
+
+/*! @class TaskScheduler
+ *  @brief a small work-stealing thread pool
+ *
+ *  Each worker owns a deque of tasks. A worker pops tasks from the front of
+ *  its own deque, and when it runs dry steals from the back of the other
+ *  workers' deques. Batches of tasks submitted with a cost estimate are
+ *  dealt out largest-first, so the big pyramid levels start first and the
+ *  small ones fill in the tail.
+ *
+ *  The thread that waits on a group executes tasks while it waits, so a
+ *  scheduler configured with N threads spawns N-1 workers, and nested
+ *  parallelism never deadlocks. With a single thread, tasks run inline.
+ *
+ *  The detector stages share the global() scheduler, which is configured
+ *  through PartsBasedDetector::setNumThreads()
+ */
+class TaskScheduler {
+private:
+	//! an entry in a worker's deque
+	struct Job {
+		Task task;
+		TaskGroup* group;
+		//! pinned jobs must run on the worker they were queued on
+		bool pinned;
+		Job() : group(NULL), pinned(false) {}
+		Job(const Task& t, TaskGroup* g, bool p = false) : task(t), group(g), pinned(p) {}
+	};
+	//! a worker's deque of jobs
+	struct Worker {
+		std::deque<Job> jobs;
+		boost::mutex mutex;
+	};
+	//! the workers (one less than the number of threads)
+	std::vector<Worker*> workers_;
+	std::vector<boost::thread*> threads_;
+	//! the number of jobs queued but not yet started
+	volatile long queued_;
+	//! round-robin counter for jobs submitted from outside the pool
+	volatile long next_;
+	//! set when the workers should exit
+	volatile bool stop_;
+	//! whether workers are pinned to cores
+	bool affinity_;
+	boost::mutex sleep_mutex_;
+	boost::condition_variable wakeup_;
+
+	void start(size_t nthreads, bool affinity);
+	void shutdown(void);
+	void workerLoop(size_t self);
+	void push(size_t worker, const Job& job, bool front);
+	bool pop(size_t self, Job& job);
+	bool steal(size_t self, Job& job);
+	bool acquire(Job& job);
+	bool claim(TaskGroup& group, Job& job);
+	void join(TaskGroup& group, bool isolated);
+	void execute(Job& job);
+	TaskScheduler(const TaskScheduler&);
+	TaskScheduler& operator=(const TaskScheduler&);
+public:
+	TaskScheduler(size_t nthreads = 0, bool affinity = false);
+	virtual ~TaskScheduler();
+	static TaskScheduler& global(void);
+	void configure(size_t nthreads, bool affinity = false);
+	//! the number of threads which execute tasks (including the waiting thread)
+	size_t nthreads(void) const { return workers_.size() + 1; }
+	//! whether workers are pinned to cores
+	bool affinity(void) const { return affinity_; }
+	void run(TaskGroup& group, const Task& task);
+	void run(TaskGroup& group, const std::vector<Task>& tasks, const std::vector<double>& costs);
+	void wait(TaskGroup& group);
+	void waitIsolated(TaskGroup& group);
+	void parallelFor(size_t N, const LoopBody& body);
+	void parallelFor(size_t N, const LoopBody& body, const std::vector<double>& costs);
+	void onEachThread(const Task& task);
+	static void bands(size_t rows, size_t min_rows, size_t nbands, std::vector<size_t>& bounds);
+};
+
+#endif /* TASKSCHEDULER_HPP_ */
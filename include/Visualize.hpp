@@ -43,6 +43,7 @@
 #include <string>
 #include <vector>
 #include "Candidate.hpp"
+#include "CandidateSet.hpp"
 #include "types.hpp"
 
 /*! @class Visualize
@@ -64,6 +65,8 @@ public:
 	void candidates(const cv::Mat& im, const vectorCandidate& candidates, cv::Mat& canvas, bool display_confidence = false) const;
 	void candidates(const cv::Mat& im, const vectorCandidate& candidates, size_t N, cv::Mat& canvas, bool display_confidence = false) const;
 	void candidates(const cv::Mat& im, const Candidate& candidate, cv::Mat& canvas, bool display_confidence = true) const;
+	void candidates(const cv::Mat& im, const CandidateSet& candidates, cv::Mat& canvas, bool display_confidence = false) const;
+	void candidates(const cv::Mat& im, const CandidateSet& candidates, size_t N, cv::Mat& canvas, bool display_confidence = false) const;
 	void image(const cv::Mat& im) const;
 };
 
@@ -0,0 +1,364 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    BranchAndBound.cpp
+ *  Created: Oct 16, 2026
+ */
+
+#include <cmath>
+#include <queue>
+#include <limits>
+#include <algorithm>
+#include <boost/bind.hpp>
+#include "BranchAndBound.hpp"
+#include "TaskScheduler.hpp"
+using namespace cv;
+using namespace std;
+
+//! the deformation score -(a*d^2 + b*d) of a displacement d, as in the distance transform
+static inline double deformation(double a, double b, int d) {
+	return -(a*d*d + b*d);
+}
+
+//! the largest deformation score over all displacements
+static double peakDeformation(double a, double b) {
+	if (a > 0) return b*b / (4*a);
+	if (a == 0 && b == 0) return 0;
+	return numeric_limits<double>::infinity();
+}
+
+//! the largest deformation score over displacements within the radius
+static double insideDeformation(double a, double b, int r) {
+	double best = -numeric_limits<double>::infinity();
+	for (int d = -r; d <= r; ++d) best = std::max(best, deformation(a, b, d));
+	return best;
+}
+
+//! the largest deformation score over displacements beyond the radius
+static double outsideDeformation(double a, double b, int r) {
+	if (a <= 0 || fabs(b / (2*a)) > r) return peakDeformation(a, b);
+	return std::max(deformation(a, b, r+1), deformation(a, b, -r-1));
+}
+
+/*! @brief compute the level independent bounds of a component
+ *
+ * @param parts the tree of parts
+ * @param c the component
+ */
+template<typename T>
+void BranchAndBound<T>::bindComponent(Parts& parts, size_t c) {
+
+	const double inf = numeric_limits<double>::infinity();
+	const size_t P = parts.nparts(c);
+	ComponentBound& component = components_[c];
+	component.bias = parts.component(c).bias(0)[0];
+	component.pbias.assign(P, 0);
+	component.inside.assign(P, 0);
+	component.reach.assign(P, Rect(0, 0, 1, 1));
+
+	// parts are sorted from the root to the leaves, so each parent's reach is known before its children's
+	double peaks = 0, excess = inf;
+	for (size_t p = 1; p < P; ++p) {
+		ComponentPart part = parts.component(c, p);
+		const size_t pnmixtures = part.parent().nmixtures();
+		double pbias = -inf, inside = -inf, peak = -inf, outside = -inf;
+		Point amin(numeric_limits<int>::max(), numeric_limits<int>::max());
+		Point amax(numeric_limits<int>::min(), numeric_limits<int>::min());
+		for (size_t mm = 0; mm < part.nmixtures(); ++mm) {
+			const vectorf bias = part.bias(mm);
+			for (size_t m = 0; m < pnmixtures; ++m) pbias = std::max(pbias, (double)bias[m]);
+			const vectorf w = part.defw(mm);
+			const double px = peakDeformation(w[0], w[1]);
+			const double py = peakDeformation(w[2], w[3]);
+			inside  = std::max(inside, insideDeformation(w[0], w[1], radius_) + insideDeformation(w[2], w[3], radius_));
+			peak    = std::max(peak, px + py);
+			outside = std::max(outside, std::max(outsideDeformation(w[0], w[1], radius_) + py, px + outsideDeformation(w[2], w[3], radius_)));
+			const Point a = part.anchor(mm);
+			amin.x = std::min(amin.x, a.x);
+			amin.y = std::min(amin.y, a.y);
+			amax.x = std::max(amax.x, a.x);
+			amax.y = std::max(amax.y, a.y);
+		}
+		component.pbias[p]  = pbias;
+		component.inside[p] = inside;
+		peaks += pbias + peak;
+		if (peak < inf) excess = std::min(excess, peak - outside);
+
+		// the part lies at its parent plus its anchor, less its displacement
+		const Rect& parent = component.reach[part.parent().self()];
+		component.reach[p] = Rect(parent.x + amin.x - radius_, parent.y + amin.y - radius_,
+				parent.width + amax.x - amin.x + 2*radius_, parent.height + amax.y - amin.y + 2*radius_);
+	}
+
+	// when some part leaves the radius, its deformation score is at most its
+	// score beyond the radius, and every other part's is at most its peak
+	if (P == 1)           component.escape = -inf;
+	else if (peaks < inf) component.escape = peaks - excess;
+	else                  component.escape = inf;
+}
+
+/*! @brief compute the response maxima of a component at a level
+ *
+ * @param parts the tree of parts
+ * @param responses the responses of the pyramid
+ * @param nc the index of the (level, component) pair
+ */
+template<typename T>
+void BranchAndBound<T>::bindLevel(Parts& parts, ResponseCache& responses, size_t nc) {
+
+	const size_t C = parts.ncomponents();
+	const size_t n = nc / C;
+	const size_t c = nc % C;
+	const size_t P = parts.nparts(c);
+	LevelBound& level = levels_[nc];
+	ResponseCache::Level scores = responses[n];
+	level.parts.resize(P);
+	level.peak.assign(P, 0);
+	for (size_t p = 0; p < P; ++p) {
+		ComponentPart part = parts.component(c, p);
+		Mat best;
+		for (size_t m = 0; m < part.nmixtures(); ++m) {
+			const Mat& score = part.score(scores, m);
+			if (best.empty()) score.copyTo(best);
+			else cv::max(best, score, best);
+		}
+		if (part.isRoot()) {
+			level.root = best;
+		} else {
+			level.parts[p] = best;
+			minMaxLoc(best, NULL, &level.peak[p]);
+		}
+	}
+}
+
+/*! @brief the window of the responses the parts can reach from a region within the radius
+ *
+ * @param level the response maxima of the level
+ * @param component the bounds of the component
+ * @param rect the region of root locations
+ * @return the window, clipped to the level
+ */
+template<typename T>
+Rect BranchAndBound<T>::window(const LevelBound& level, const ComponentBound& component, const Rect& rect) const {
+	Rect window = rect;
+	for (size_t p = 1; p < component.reach.size(); ++p) {
+		const Rect& reach = component.reach[p];
+		window = window | Rect(rect.x + reach.x, rect.y + reach.y, rect.width + reach.width - 1, rect.height + reach.height - 1);
+	}
+	return window & Rect(0, 0, level.root.cols, level.root.rows);
+}
+
+/*! @brief an upper bound on the score of any root location in a region
+ *
+ * @param level the response maxima of the level
+ * @param component the bounds of the component
+ * @param rect the region of root locations
+ * @return the bound
+ */
+template<typename T>
+double BranchAndBound<T>::bound(const LevelBound& level, const ComponentBound& component, const Rect& rect) const {
+
+	const double inf = numeric_limits<double>::infinity();
+	const Rect bounds(0, 0, level.root.cols, level.root.rows);
+	double root;
+	minMaxLoc(level.root(rect), NULL, &root);
+
+	// every part within the radius: the best response it can reach from the region
+	double inside = 0, outside = component.escape;
+	for (size_t p = 1; p < component.reach.size(); ++p) {
+		const Rect& reach = component.reach[p];
+		const Rect reachable = Rect(rect.x + reach.x, rect.y + reach.y, rect.width + reach.width - 1, rect.height + reach.height - 1) & bounds;
+		if (reachable.area() == 0) {
+			inside = -inf;
+		} else if (inside > -inf) {
+			double best;
+			minMaxLoc(level.parts[p](reachable), NULL, &best);
+			inside += best + component.pbias[p] + component.inside[p];
+		}
+		outside += level.peak[p];
+	}
+	return root + component.bias + std::max(inside, outside);
+}
+
+/*! @brief score the root locations of a region exactly
+ *
+ * The dynamic program is run over the window of responses the parts can
+ * reach from the region within the radius. Where the windowed score cannot
+ * be certified (a part beyond the radius might do better), the dense
+ * dynamic program of the level and component is used instead
+ *
+ * @param parts the tree of parts
+ * @param dp the dynamic program
+ * @param responses the responses of the pyramid
+ * @param region the region
+ * @param scale the scale of the region's level
+ * @param found the candidates of the region above the threshold
+ */
+template<typename T>
+void BranchAndBound<T>::score(Parts& parts, DynamicProgram<T>& dp, ResponseCache& responses, const Region& region, T scale, vectorCandidate& found) {
+
+	const size_t nc = region.n * parts.ncomponents() + region.c;
+	const LevelBound& level = levels_[nc];
+	const ComponentBound& component = components_[region.c];
+	const Rect win = window(level, component, region.rect);
+
+	// the windows of the component's responses
+	vector2DMat views(1, vectorMat(responses.nfilters()));
+	ResponseCache::Level scores = responses[region.n];
+	for (size_t p = 0; p < parts.nparts(region.c); ++p) {
+		ComponentPart part = parts.component(region.c, p);
+		for (size_t m = 0; m < part.nmixtures(); ++m) part.score(views[0], m) = part.score(scores, m)(win);
+	}
+	ResponseCache windowed(views);
+	window_.allocate(dp.plan(), win.size(), region.c);
+	dp.minComponent(windowed, 0, window_, 0, region.c);
+	const Mat rootv = window_.rootv(0, region.c);
+	++windows_;
+
+	// certify each location against the best score with a part beyond the radius
+	double escape = component.bias + component.escape;
+	for (size_t p = 1; p < level.peak.size(); ++p) escape += level.peak[p];
+	const Mat& root = level.root;
+	bool certified = true;
+	for (int y = region.rect.y; certified && y < region.rect.y + region.rect.height; ++y) {
+		for (int x = region.rect.x; x < region.rect.x + region.rect.width; ++x) {
+			if (rootv.at<T>(y - win.y, x - win.x) < root.at<T>(y, x) + escape) { certified = false; break; }
+		}
+	}
+
+	// backtrack from the region's locations only
+	const T inf = numeric_limits<T>::infinity();
+	if (certified) {
+		const Rect local(region.rect.x - win.x, region.rect.y - win.y, region.rect.width, region.rect.height);
+		Mat masked(rootv.size(), rootv.type(), Scalar::all(-inf));
+		Mat out = masked(local);
+		rootv(local).copyTo(out);
+		dp.argminComponent(window_, masked, 0, region.c, scale, found, win.tl());
+	} else {
+		DPTensor<T>& dense = dense_dp_[nc];
+		if (dense.empty()) {
+			dense.allocate(dp.plan(), responses.levelSize(region.n), region.c);
+			dp.minComponent(responses, region.n, dense, 0, region.c);
+			++dense_;
+		}
+		const Mat rootv = dense.rootv(0, region.c);
+		Mat masked(rootv.size(), rootv.type(), Scalar::all(-inf));
+		Mat out = masked(region.rect);
+		rootv(region.rect).copyTo(out);
+		dp.argminComponent(dense, masked, 0, region.c, scale, found);
+	}
+}
+
+/*! @brief find the K best scoring root locations over all scales and components
+ *
+ * @param parts the tree of parts
+ * @param dp the dynamic program, which also sets the threshold
+ * @param responses the responses of the pyramid, typically computed on demand
+ * @param scales the scale of each level of the pyramid
+ * @param K the number of candidates to find
+ * @param candidates the vector to append the (at most K) best candidates above the threshold to, best first
+ */
+template<typename T>
+void BranchAndBound<T>::search(Parts& parts, DynamicProgram<T>& dp, ResponseCache& responses, const vectorf& scales, size_t K, vectorCandidate& candidates) {
+
+	windows_ = 0;
+	dense_ = 0;
+	if (K == 0) return;
+
+	// the bounds of each component, and the response maxima of each (level, component)
+	const size_t M = responses.size();
+	const size_t C = parts.ncomponents();
+	components_.resize(C);
+	for (size_t c = 0; c < C; ++c) bindComponent(parts, c);
+	levels_.clear();
+	levels_.resize(M*C);
+	vector<double> costs(M*C);
+	for (size_t nc = 0; nc < M*C; ++nc) costs[nc] = responses.cost(nc / C) * parts.nparts(nc % C);
+	TaskScheduler::global().parallelFor(M*C, boost::bind(&BranchAndBound<T>::bindLevel, this, boost::ref(parts), boost::ref(responses), _1), costs);
+
+	// seed the queue with every (level, component)
+	const double thresh = dp.thresh();
+	priority_queue<Region> queue;
+	for (size_t nc = 0; nc < M*C; ++nc) {
+		const LevelBound& level = levels_[nc];
+		if (level.root.empty()) continue;
+		const Rect all(0, 0, level.root.cols, level.root.rows);
+		const double b = bound(level, components_[nc % C], all);
+		if (b > thresh) queue.push(Region(b, nc / C, nc % C, all));
+	}
+
+	// expand the most promising region until none can beat the k-th best
+	vectorCandidate best;
+	while (!queue.empty()) {
+		const Region region = queue.top();
+		queue.pop();
+		const double kth = (best.size() >= K) ? best[K-1].score() : thresh;
+		if (region.bound <= kth) break;
+
+		if (region.rect.area() <= leaf_*leaf_) {
+			vectorCandidate found;
+			score(parts, dp, responses, region, scales[region.n], found);
+			best.insert(best.end(), found.begin(), found.end());
+			Candidate::sort(best);
+			if (best.size() > K) best.resize(K);
+			continue;
+		}
+
+		// split the region across its longer side
+		Rect first = region.rect, second = region.rect;
+		if (first.width >= first.height) {
+			first.width /= 2;
+			second.x += first.width;
+			second.width -= first.width;
+		} else {
+			first.height /= 2;
+			second.y += first.height;
+			second.height -= first.height;
+		}
+		const LevelBound& level = levels_[region.n * C + region.c];
+		const ComponentBound& component = components_[region.c];
+		const double b1 = bound(level, component, first);
+		const double b2 = bound(level, component, second);
+		if (b1 > kth) queue.push(Region(b1, region.n, region.c, first));
+		if (b2 > kth) queue.push(Region(b2, region.n, region.c, second));
+	}
+	candidates.insert(candidates.end(), best.begin(), best.end());
+
+	// release the maxima and any dense programs
+	levels_.clear();
+	dense_dp_.clear();
+}
+
+// declare all specializations of the template (this must be the last declaration in the file)
+template class BranchAndBound<float>;
+template class BranchAndBound<double>;
@@ -0,0 +1,274 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    CandidateSet.cpp
+ *  Created: Oct 16, 2026
+ */
+
+#include <algorithm>
+#include "CandidateSet.hpp"
+using namespace cv;
+using namespace std;
+
+// order candidate indices by descending score
+struct DescendingScore {
+	const CandidateSet& set;
+	DescendingScore(const CandidateSet& s) : set(s) {}
+	bool operator()(size_t a, size_t b) const { return set.score(a) > set.score(b); }
+};
+
+/*! @brief copy a vector of candidates into a set
+ *
+ * @param candidates the candidates, in the order they will be stored
+ */
+CandidateSet::CandidateSet(const vectorCandidate& candidates) : stride_(0) {
+	insert(candidates);
+}
+
+/*! @brief remove every candidate, keeping the storage and stride
+ */
+void CandidateSet::clear(void) {
+	parts_.clear();
+	confidence_.clear();
+	component_.clear();
+	nparts_.clear();
+}
+
+/*! @brief reserve space for a number of candidates
+ *
+ * @param n the number of candidates
+ * @param stride the most parts of any of the candidates
+ */
+void CandidateSet::reserve(size_t n, size_t stride) {
+	if (stride > stride_) restride(stride);
+	parts_.reserve(n*stride_);
+	confidence_.reserve(n*stride_);
+	component_.reserve(n);
+	nparts_.reserve(n);
+}
+
+/*! @brief widen the part slots of every candidate
+ *
+ * @param stride the new number of slots per candidate
+ */
+void CandidateSet::restride(size_t stride) {
+	const size_t N = size();
+	vector<Rect> parts(N*stride);
+	vectorf confidence(N*stride, 0.0f);
+	for (size_t i = 0; i < N; ++i) {
+		std::copy(parts_.begin() + i*stride_, parts_.begin() + i*stride_ + nparts_[i], parts.begin() + i*stride);
+		std::copy(confidence_.begin() + i*stride_, confidence_.begin() + i*stride_ + nparts_[i], confidence.begin() + i*stride);
+	}
+	parts_.swap(parts);
+	confidence_.swap(confidence);
+	stride_ = stride;
+}
+
+/*! @brief append a candidate to the set
+ *
+ * @param candidate the candidate
+ */
+void CandidateSet::push_back(const Candidate& candidate) {
+	const size_t nparts = candidate.parts().size();
+	if (nparts > stride_) restride(nparts);
+	const size_t offset = parts_.size();
+	parts_.resize(offset + stride_);
+	confidence_.resize(offset + stride_, 0.0f);
+	std::copy(candidate.parts().begin(), candidate.parts().end(), parts_.begin() + offset);
+	std::copy(candidate.confidence().begin(), candidate.confidence().end(), confidence_.begin() + offset);
+	component_.push_back(candidate.component());
+	nparts_.push_back(nparts);
+}
+
+/*! @brief append a vector of candidates to the set
+ *
+ * @param candidates the candidates
+ */
+void CandidateSet::insert(const vectorCandidate& candidates) {
+	size_t stride = stride_;
+	for (size_t i = 0; i < candidates.size(); ++i) stride = std::max(stride, candidates[i].parts().size());
+	reserve(size() + candidates.size(), stride);
+	for (size_t i = 0; i < candidates.size(); ++i) push_back(candidates[i]);
+}
+
+/*! @brief a copy of a single candidate
+ *
+ * @param i the index of the candidate
+ * @return the candidate
+ */
+Candidate CandidateSet::candidate(size_t i) const {
+	Candidate candidate;
+	candidate.setComponent(component_[i]);
+	const Rect* parts = this->parts(i);
+	const float* confidence = this->confidence(i);
+	for (size_t p = 0; p < nparts_[i]; ++p) candidate.addPart(parts[p], confidence[p]);
+	return candidate;
+}
+
+/*! @brief copy the set out to a vector of candidates
+ *
+ * @param out the vector to append the candidates to, in order
+ */
+void CandidateSet::candidates(vectorCandidate& out) const {
+	out.reserve(out.size() + size());
+	for (size_t i = 0; i < size(); ++i) out.push_back(candidate(i));
+}
+
+/*! @brief the order of the candidates from best to worst
+ *
+ * Candidates of equal score keep their relative order
+ *
+ * @param order the permutation, order[k] is the index of the k-th best candidate
+ */
+void CandidateSet::order(vector<size_t>& order) const {
+	order.resize(size());
+	for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+	std::stable_sort(order.begin(), order.end(), DescendingScore(*this));
+}
+
+/*! @brief sort the candidates from best to worst, in place
+ *
+ * The comparisons only touch the scores, and each candidate is then
+ * moved once, when the permutation is applied
+ */
+void CandidateSet::sort(void) {
+	vector<size_t> order;
+	this->order(order);
+	permute(order);
+}
+
+/*! @brief keep a subset of the candidates
+ *
+ * @param keep the indices of the candidates to keep, in their new order
+ */
+void CandidateSet::select(const vector<size_t>& keep) {
+	permute(keep);
+}
+
+/*! @brief gather the candidates into a new order
+ *
+ * @param order the indices of the candidates, in their new order
+ */
+void CandidateSet::permute(const vector<size_t>& order) {
+	const size_t N = order.size();
+	vector<Rect> parts(N*stride_);
+	vectorf confidence(N*stride_);
+	vectori component(N);
+	vectori nparts(N);
+	for (size_t k = 0; k < N; ++k) {
+		const size_t i = order[k];
+		std::copy(parts_.begin() + i*stride_, parts_.begin() + (i+1)*stride_, parts.begin() + k*stride_);
+		std::copy(confidence_.begin() + i*stride_, confidence_.begin() + (i+1)*stride_, confidence.begin() + k*stride_);
+		component[k] = component_[i];
+		nparts[k]    = nparts_[i];
+	}
+	parts_.swap(parts);
+	confidence_.swap(confidence);
+	component_.swap(component);
+	nparts_.swap(nparts);
+}
+
+/*! @brief rescale the parts of every candidate
+ *
+ * @param factor the scale factor
+ */
+void CandidateSet::resize(const float factor) {
+	for (size_t n = 0; n < parts_.size(); ++n) {
+		parts_[n].height *= factor;
+		parts_[n].width  *= factor;
+		parts_[n].y      *= factor;
+		parts_[n].x      *= factor;
+	}
+}
+
+/*! @brief translate the parts of every candidate
+ *
+ * @param offset the translation
+ */
+void CandidateSet::translate(const Point& offset) {
+	for (size_t n = 0; n < parts_.size(); ++n) parts_[n] += offset;
+}
+
+/*! @brief the bounding box of the parts of every candidate
+ *
+ * @param boxes the boxes, one per candidate. Empty for a candidate without parts
+ */
+void CandidateSet::boundingBoxes(vector<Rect>& boxes) const {
+	boxes.resize(size());
+	for (size_t i = 0; i < size(); ++i) {
+		if (nparts_[i] == 0) {
+			boxes[i] = Rect();
+			continue;
+		}
+		const Rect* parts = this->parts(i);
+		Rect hull = parts[0];
+		for (size_t p = 1; p < nparts_[i]; ++p) hull = hull | parts[p];
+		boxes[i] = hull;
+	}
+}
+
+/*! @brief the bounding box of every candidate from the mean and standard deviation of its parts
+ *
+ * @param boxes the boxes, one per candidate. Empty for a candidate without parts
+ */
+void CandidateSet::boundingBoxesNorm(vector<Rect>& boxes) const {
+	boxes.resize(size());
+	for (size_t i = 0; i < size(); ++i) boxes[i] = Candidate::boundingBoxNorm(parts(i), nparts_[i]);
+}
+
+/*! @brief suppress non-maximal candidates
+ *
+ * As Candidate::nonMaximaSuppression(), on the candidates of the set in
+ * their current order (usually sorted)
+ *
+ * @param im the input image from which the candidates were found
+ * @param overlap the allowable overlap [0.0 1.0)
+ */
+void CandidateSet::nonMaximaSuppression(const Mat& im, const float overlap) {
+
+	// create a scratch space that we can draw on
+	const Rect bounds = Rect(0,0,0,0) + im.size();
+	Mat scratch = Mat::zeros(im.size(), CV_8U);
+	vector<Rect> boxes;
+	boundingBoxes(boxes);
+
+	vector<size_t> keep;
+	for (size_t n = 0; n < boxes.size(); ++n) {
+		Rect box = boxes[n] & bounds;
+		Scalar boxsum = sum(scratch(box));
+		if (boxsum[0] / box.area() > overlap) continue;
+		scratch(box) = 1;
+		keep.push_back(n);
+	}
+	select(keep);
+}
@@ -0,0 +1,114 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    ConvolutionCalibration.cpp
+ *  Created: Oct 16, 2026
+ */
+
+#include <cmath>
+#include <cassert>
+#include <iomanip>
+#include <opencv2/core/core.hpp>
+#include "ConvolutionCalibration.hpp"
+using namespace std;
+using namespace cv;
+
+/*! @brief compare the responses of an engine against reference responses
+ *
+ * @param reference the reference responses, indexed [level][filter]
+ * @param responses the responses to test, of the same dimensions
+ * @param errors the error of each filter, accumulated over all levels
+ */
+void ConvolutionCalibration::compare(const vector2DMat& reference, const vector2DMat& responses, vector<ResponseError>& errors) {
+
+	assert(reference.size() == responses.size());
+	const size_t M = reference.size();
+	const size_t N = M > 0 ? reference[0].size() : 0;
+	errors.clear();
+	errors.resize(N);
+
+	for (size_t n = 0; n < N; ++n) {
+		double sumsq = 0, count = 0;
+		double lo = 0, hi = 0;
+		for (size_t m = 0; m < M; ++m) {
+			const Mat& ref = reference[m][n];
+			if (ref.empty()) continue;
+			Mat test, diff;
+			responses[m][n].convertTo(test, ref.type());
+			absdiff(ref, test, diff);
+			double minv, maxv;
+			minMaxLoc(ref, &minv, &maxv);
+			lo = (count == 0) ? minv : std::min(lo, minv);
+			hi = (count == 0) ? maxv : std::max(hi, maxv);
+			errors[n].max_abs = std::max(errors[n].max_abs, norm(diff, NORM_INF));
+			sumsq += diff.dot(diff);
+			count += diff.total();
+		}
+		errors[n].rms   = count > 0 ? sqrt(sumsq / count) : 0;
+		errors[n].range = hi - lo;
+	}
+}
+
+/*! @brief print a calibration report of an engine against a reference engine
+ *
+ * Both engines must already have their filters set
+ *
+ * @param reference the exact engine, typically the SpatialConvolutionEngine
+ * @param engine the engine to calibrate
+ * @param features the feature pyramid to calibrate over
+ * @param os the stream to print the report to
+ */
+void ConvolutionCalibration::report(IConvolutionEngine& reference, IConvolutionEngine& engine, const vectorMat& features, ostream& os) {
+	vector2DMat ref, test;
+	reference.pdf(features, ref);
+	engine.pdf(features, test);
+	vector<ResponseError> errors;
+	compare(ref, test, errors);
+	print(errors, os);
+}
+
+/*! @brief print the per-filter errors, and their worst case
+ *
+ * @param errors the errors of each filter
+ * @param os the stream to print to
+ */
+void ConvolutionCalibration::print(const vector<ResponseError>& errors, ostream& os) {
+	ResponseError worst;
+	os << setw(8) << "filter" << setw(12) << "max abs" << setw(12) << "rms" << setw(12) << "range" << setw(12) << "relative" << endl;
+	for (size_t n = 0; n < errors.size(); ++n) {
+		const ResponseError& e = errors[n];
+		os << setw(8) << n << setw(12) << setprecision(4) << e.max_abs << setw(12) << e.rms << setw(12) << e.range << setw(12) << e.relative() << endl;
+		if (e.relative() >= worst.relative()) worst = e;
+	}
+	os << "worst relative error: " << setprecision(4) << worst.relative() << " (" << worst.max_abs << " of " << worst.range << ")" << endl;
+}
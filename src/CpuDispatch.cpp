@@ -0,0 +1,127 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    CpuDispatch.cpp
+ *  Created: Oct 16, 2026
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include "CpuDispatch.hpp"
+#include "CpuKernels.hpp"
+using namespace std;
+
+// the tier names, as accepted by PBD_CPU_TIER
+static const char* const kTierNames[] = { "generic", "sse4.1", "avx2", "avx512" };
+
+/*! @brief the tier and kernels chosen on first use
+ *
+ * The best tier supported by the CPU is chosen, unless the PBD_CPU_TIER
+ * environment variable requests a lower one. If a tier's translation unit
+ * was built without that instruction set, the next lower tier is used
+ */
+struct Selection {
+	CpuDispatch::Tier tier;
+	CpuDispatch::Kernels kernels;
+	Selection() {
+		tier = CpuDispatch::supported();
+		const char* env = getenv("PBD_CPU_TIER");
+		if (env) {
+			int requested = -1;
+			for (int t = CpuDispatch::GENERIC; t <= CpuDispatch::AVX512; ++t) if (strcmp(env, kTierNames[t]) == 0) requested = t;
+			if (requested < 0) {
+				cerr << "PBD_CPU_TIER: unknown tier '" << env << "', using " << CpuDispatch::name(tier) << endl;
+			} else if (requested > tier) {
+				cerr << "PBD_CPU_TIER: " << env << " is not supported by this CPU, using " << CpuDispatch::name(tier) << endl;
+			} else {
+				tier = (CpuDispatch::Tier)requested;
+			}
+		}
+
+		bool filled = false;
+		while (!filled) {
+			switch (tier) {
+				case CpuDispatch::AVX512:  filled = CpuDispatch::fillAVX512(kernels);  break;
+				case CpuDispatch::AVX2:    filled = CpuDispatch::fillAVX2(kernels);    break;
+				case CpuDispatch::SSE41:   filled = CpuDispatch::fillSSE41(kernels);   break;
+				case CpuDispatch::GENERIC: filled = CpuDispatch::fillGeneric(kernels); break;
+			}
+			if (!filled) tier = (CpuDispatch::Tier)(tier-1);
+		}
+	}
+};
+
+static const Selection& selection(void) {
+	static const Selection s;
+	return s;
+}
+
+/*! @brief the kernels of the selected tier
+ *
+ * The tier is selected on the first call, which is thread-safe
+ */
+const CpuDispatch::Kernels& CpuDispatch::kernels(void) {
+	return selection().kernels;
+}
+
+/*! @brief the selected tier
+ */
+CpuDispatch::Tier CpuDispatch::tier(void) {
+	return selection().tier;
+}
+
+/*! @brief the highest tier supported by the CPU and operating system
+ */
+CpuDispatch::Tier CpuDispatch::supported(void) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) return AVX512;
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return AVX2;
+	if (__builtin_cpu_supports("sse4.1")) return SSE41;
+#endif
+	return GENERIC;
+}
+
+/*! @brief the name of a tier, as accepted by PBD_CPU_TIER
+ */
+const char* CpuDispatch::name(Tier tier) {
+	return kTierNames[tier];
+}
+
+/*! @brief fill the table with the portable kernels, compiled for the baseline architecture
+ */
+bool CpuDispatch::fillGeneric(Kernels& k) {
+	PortableKernels<GENERIC>::fill(k);
+	return true;
+}
@@ -0,0 +1,161 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    CpuKernelsAVX2.cpp
+ *  Created: Oct 16, 2026
+ */
+
+#include "CpuDispatch.hpp"
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#include "CpuKernels.hpp"
+
+// ---------------------------------------------------------------------------
+// AVX2 KERNELS
+// This translation unit is compiled with -mavx2 -mfma
+// ---------------------------------------------------------------------------
+
+static inline int32_t hsum(__m256i v) {
+	__m128i s = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+	s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1,0,3,2)));
+	s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2,3,0,1)));
+	return _mm_cvtsi128_si32(s);
+}
+
+static int32_t dot16(const int16_t* a, const int16_t* b, int n) {
+	__m256i sum = _mm256_setzero_si256();
+	for (int i = 0; i < n; i += 16) {
+		__m256i va = _mm256_loadu_si256((const __m256i*)(a+i));
+		__m256i vb = _mm256_loadu_si256((const __m256i*)(b+i));
+		sum = _mm256_add_epi32(sum, _mm256_madd_epi16(va, vb));
+	}
+	return hsum(sum);
+}
+
+static int32_t dot8(const uint8_t* a, const int8_t* b, int n) {
+	const __m256i ones = _mm256_set1_epi16(1);
+	__m256i sum = _mm256_setzero_si256();
+	for (int i = 0; i < n; i += 32) {
+		__m256i va = _mm256_loadu_si256((const __m256i*)(a+i));
+		__m256i vb = _mm256_loadu_si256((const __m256i*)(b+i));
+		sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_maddubs_epi16(va, vb), ones));
+	}
+	return hsum(sum);
+}
+
+static float dotf(const float* a, const float* b, int n) {
+	__m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps();
+	int i = 0;
+	for (; i+16 <= n; i += 16) {
+		s0 = _mm256_fmadd_ps(_mm256_loadu_ps(a+i),   _mm256_loadu_ps(b+i),   s0);
+		s1 = _mm256_fmadd_ps(_mm256_loadu_ps(a+i+8), _mm256_loadu_ps(b+i+8), s1);
+	}
+	s0 = _mm256_add_ps(s0, s1);
+	__m128 s = _mm_add_ps(_mm256_castps256_ps128(s0), _mm256_extractf128_ps(s0, 1));
+	s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+	s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+	float sum = _mm_cvtss_f32(s);
+	for (; i < n; ++i) sum += a[i] * b[i];
+	return sum;
+}
+
+static double dotd(const double* a, const double* b, int n) {
+	__m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+	int i = 0;
+	for (; i+8 <= n; i += 8) {
+		s0 = _mm256_fmadd_pd(_mm256_loadu_pd(a+i),   _mm256_loadu_pd(b+i),   s0);
+		s1 = _mm256_fmadd_pd(_mm256_loadu_pd(a+i+4), _mm256_loadu_pd(b+i+4), s1);
+	}
+	s0 = _mm256_add_pd(s0, s1);
+	__m128d s = _mm_add_pd(_mm256_castpd256_pd128(s0), _mm256_extractf128_pd(s0, 1));
+	double sum = _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+	for (; i < n; ++i) sum += a[i] * b[i];
+	return sum;
+}
+
+static void dtbrutef(const float* src, float* dst, int* ptr, int n, int lanes, int stride, double a, double b, int os) {
+	for (int l = 0; l < lanes; l += 8) {
+		// one sequence per lane, the lanes past the last sequence masked off
+		const __m256i mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(lanes-l), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+		for (int q = 0; q < n; ++q) {
+			__m256 best = _mm256_set1_ps(-HUGE_VALF);
+			__m256 arg  = _mm256_setzero_ps();
+			for (int u = 0; u < n; ++u) {
+				const int x = os+q-u;
+				const __m256 value = _mm256_add_ps(_mm256_set1_ps((float)(a*(x*x) + b*x)), _mm256_maskload_ps(src + u*stride + l, mask));
+				const __m256 greater = _mm256_cmp_ps(value, best, _CMP_GT_OQ);
+				best = _mm256_blendv_ps(best, value, greater);
+				arg  = _mm256_blendv_ps(arg, _mm256_set1_ps((float)u), greater);
+			}
+			_mm256_maskstore_ps(dst + q*stride + l, mask, best);
+			_mm256_maskstore_epi32(ptr + q*stride + l, mask, _mm256_cvtps_epi32(arg));
+		}
+	}
+}
+
+static void dtbruted(const double* src, double* dst, int* ptr, int n, int lanes, int stride, double a, double b, int os) {
+	for (int l = 0; l < lanes; l += 4) {
+		const __m256i mask  = _mm256_cmpgt_epi64(_mm256_set1_epi64x(lanes-l), _mm256_setr_epi64x(0, 1, 2, 3));
+		const __m128i maski = _mm_cmpgt_epi32(_mm_set1_epi32(lanes-l), _mm_setr_epi32(0, 1, 2, 3));
+		for (int q = 0; q < n; ++q) {
+			__m256d best = _mm256_set1_pd(-HUGE_VAL);
+			__m256d arg  = _mm256_setzero_pd();
+			for (int u = 0; u < n; ++u) {
+				const int x = os+q-u;
+				const __m256d value = _mm256_add_pd(_mm256_set1_pd(a*(x*x) + b*x), _mm256_maskload_pd(src + u*stride + l, mask));
+				const __m256d greater = _mm256_cmp_pd(value, best, _CMP_GT_OQ);
+				best = _mm256_blendv_pd(best, value, greater);
+				arg  = _mm256_blendv_pd(arg, _mm256_set1_pd(u), greater);
+			}
+			_mm256_maskstore_pd(dst + q*stride + l, mask, best);
+			_mm_maskstore_epi32(ptr + q*stride + l, maski, _mm256_cvtpd_epi32(arg));
+		}
+	}
+}
+
+bool CpuDispatch::fillAVX2(Kernels& k) {
+	PortableKernels<AVX2>::fill(k);
+	k.dot16 = dot16;
+	k.dot8  = dot8;
+	k.dotf  = dotf;
+	k.dotd  = dotd;
+	k.dtbrutef = dtbrutef;
+	k.dtbruted = dtbruted;
+	k.brutef   = 32;
+	k.bruted   = 8;
+	return true;
+}
+
+#else
+bool CpuDispatch::fillAVX2(Kernels&) { return false; }
+#endif
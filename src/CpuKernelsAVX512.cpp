@@ -0,0 +1,151 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    CpuKernelsAVX512.cpp
+ *  Created: Oct 16, 2026
+ */
+
+#include "CpuDispatch.hpp"
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+#include <immintrin.h>
+#include "CpuKernels.hpp"
+
+// ---------------------------------------------------------------------------
+// AVX-512 KERNELS
+// This translation unit is compiled with -mavx512f -mavx512bw
+// ---------------------------------------------------------------------------
+
+static int32_t dot16(const int16_t* a, const int16_t* b, int n) {
+	// n is a multiple of 32, so a single register covers the whole stride
+	__m512i sum = _mm512_setzero_si512();
+	for (int i = 0; i < n; i += 32) {
+		__m512i va = _mm512_loadu_si512((const void*)(a+i));
+		__m512i vb = _mm512_loadu_si512((const void*)(b+i));
+		sum = _mm512_add_epi32(sum, _mm512_madd_epi16(va, vb));
+	}
+	return _mm512_reduce_add_epi32(sum);
+}
+
+static int32_t dot8(const uint8_t* a, const int8_t* b, int n) {
+	// n is a multiple of 32 but not necessarily 64, so the last stride may be a half register
+	const __m512i ones = _mm512_set1_epi16(1);
+	__m512i sum = _mm512_setzero_si512();
+	int i = 0;
+	for (; i+64 <= n; i += 64) {
+		__m512i va = _mm512_loadu_si512((const void*)(a+i));
+		__m512i vb = _mm512_loadu_si512((const void*)(b+i));
+		sum = _mm512_add_epi32(sum, _mm512_madd_epi16(_mm512_maddubs_epi16(va, vb), ones));
+	}
+	if (i < n) {
+		__m512i va = _mm512_maskz_loadu_epi8(0xFFFFFFFFull, a+i);
+		__m512i vb = _mm512_maskz_loadu_epi8(0xFFFFFFFFull, b+i);
+		sum = _mm512_add_epi32(sum, _mm512_madd_epi16(_mm512_maddubs_epi16(va, vb), ones));
+	}
+	return _mm512_reduce_add_epi32(sum);
+}
+
+static float dotf(const float* a, const float* b, int n) {
+	__m512 sum = _mm512_setzero_ps();
+	int i = 0;
+	for (; i+16 <= n; i += 16) sum = _mm512_fmadd_ps(_mm512_loadu_ps(a+i), _mm512_loadu_ps(b+i), sum);
+	if (i < n) {
+		const __mmask16 tail = (__mmask16)((1u << (n-i)) - 1);
+		sum = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(tail, a+i), _mm512_maskz_loadu_ps(tail, b+i), sum);
+	}
+	return _mm512_reduce_add_ps(sum);
+}
+
+static double dotd(const double* a, const double* b, int n) {
+	__m512d sum = _mm512_setzero_pd();
+	int i = 0;
+	for (; i+8 <= n; i += 8) sum = _mm512_fmadd_pd(_mm512_loadu_pd(a+i), _mm512_loadu_pd(b+i), sum);
+	if (i < n) {
+		const __mmask8 tail = (__mmask8)((1u << (n-i)) - 1);
+		sum = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(tail, a+i), _mm512_maskz_loadu_pd(tail, b+i), sum);
+	}
+	return _mm512_reduce_add_pd(sum);
+}
+
+static void dtbrutef(const float* src, float* dst, int* ptr, int n, int lanes, int stride, double a, double b, int os) {
+	// one sequence per lane, the lanes past the last sequence masked off
+	const __mmask16 mask = (__mmask16)((1u << lanes) - 1);
+	for (int q = 0; q < n; ++q) {
+		__m512 best = _mm512_set1_ps(-HUGE_VALF);
+		__m512i arg = _mm512_setzero_si512();
+		for (int u = 0; u < n; ++u) {
+			const int x = os+q-u;
+			const __m512 value = _mm512_add_ps(_mm512_set1_ps((float)(a*(x*x) + b*x)), _mm512_maskz_loadu_ps(mask, src + u*stride));
+			const __mmask16 greater = _mm512_cmp_ps_mask(value, best, _CMP_GT_OQ);
+			best = _mm512_mask_mov_ps(best, greater, value);
+			arg  = _mm512_mask_mov_epi32(arg, greater, _mm512_set1_epi32(u));
+		}
+		_mm512_mask_storeu_ps(dst + q*stride, mask, best);
+		_mm512_mask_storeu_epi32(ptr + q*stride, mask, arg);
+	}
+}
+
+static void dtbruted(const double* src, double* dst, int* ptr, int n, int lanes, int stride, double a, double b, int os) {
+	for (int q = 0; q < n; ++q) {
+		for (int l = 0; l < lanes; l += 8) {
+			const __mmask8 mask = (__mmask8)((1u << (lanes-l < 8 ? lanes-l : 8)) - 1);
+			__m512d best = _mm512_set1_pd(-HUGE_VAL);
+			__m512i arg  = _mm512_setzero_si512();
+			for (int u = 0; u < n; ++u) {
+				const int x = os+q-u;
+				const __m512d value = _mm512_add_pd(_mm512_set1_pd(a*(x*x) + b*x), _mm512_maskz_loadu_pd(mask, src + u*stride + l));
+				const __mmask8 greater = _mm512_cmp_pd_mask(value, best, _CMP_GT_OQ);
+				best = _mm512_mask_mov_pd(best, greater, value);
+				arg  = _mm512_mask_mov_epi64(arg, greater, _mm512_set1_epi64(u));
+			}
+			_mm512_mask_storeu_pd(dst + q*stride + l, mask, best);
+			_mm512_mask_cvtepi64_storeu_epi32(ptr + q*stride + l, mask, arg);
+		}
+	}
+}
+
+bool CpuDispatch::fillAVX512(Kernels& k) {
+	PortableKernels<AVX512>::fill(k);
+	k.dot16 = dot16;
+	k.dot8  = dot8;
+	k.dotf  = dotf;
+	k.dotd  = dotd;
+	k.dtbrutef = dtbrutef;
+	k.dtbruted = dtbruted;
+	k.brutef   = 32;
+	k.bruted   = 32;
+	return true;
+}
+
+#else
+bool CpuDispatch::fillAVX512(Kernels&) { return false; }
+#endif
@@ -0,0 +1,114 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    CpuKernelsSSE41.cpp
+ *  Created: Oct 16, 2026
+ */
+
+#include "CpuDispatch.hpp"
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#include "CpuKernels.hpp"
+
+// ---------------------------------------------------------------------------
+// SSE4.1 KERNELS
+// This translation unit is compiled with -msse4.1
+// ---------------------------------------------------------------------------
+
+static inline int32_t hsum(__m128i s) {
+	s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1,0,3,2)));
+	s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2,3,0,1)));
+	return _mm_cvtsi128_si32(s);
+}
+
+static int32_t dot16(const int16_t* a, const int16_t* b, int n) {
+	__m128i sum = _mm_setzero_si128();
+	for (int i = 0; i < n; i += 8) {
+		__m128i va = _mm_loadu_si128((const __m128i*)(a+i));
+		__m128i vb = _mm_loadu_si128((const __m128i*)(b+i));
+		sum = _mm_add_epi32(sum, _mm_madd_epi16(va, vb));
+	}
+	return hsum(sum);
+}
+
+static int32_t dot8(const uint8_t* a, const int8_t* b, int n) {
+	const __m128i ones = _mm_set1_epi16(1);
+	__m128i sum = _mm_setzero_si128();
+	for (int i = 0; i < n; i += 16) {
+		__m128i va = _mm_loadu_si128((const __m128i*)(a+i));
+		__m128i vb = _mm_loadu_si128((const __m128i*)(b+i));
+		sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_maddubs_epi16(va, vb), ones));
+	}
+	return hsum(sum);
+}
+
+static float dotf(const float* a, const float* b, int n) {
+	__m128 s0 = _mm_setzero_ps(), s1 = _mm_setzero_ps();
+	int i = 0;
+	for (; i+8 <= n; i += 8) {
+		s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(a+i),   _mm_loadu_ps(b+i)));
+		s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_loadu_ps(a+i+4), _mm_loadu_ps(b+i+4)));
+	}
+	__m128 s = _mm_add_ps(s0, s1);
+	s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+	s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+	float sum = _mm_cvtss_f32(s);
+	for (; i < n; ++i) sum += a[i] * b[i];
+	return sum;
+}
+
+static double dotd(const double* a, const double* b, int n) {
+	__m128d s0 = _mm_setzero_pd(), s1 = _mm_setzero_pd();
+	int i = 0;
+	for (; i+4 <= n; i += 4) {
+		s0 = _mm_add_pd(s0, _mm_mul_pd(_mm_loadu_pd(a+i),   _mm_loadu_pd(b+i)));
+		s1 = _mm_add_pd(s1, _mm_mul_pd(_mm_loadu_pd(a+i+2), _mm_loadu_pd(b+i+2)));
+	}
+	__m128d s = _mm_add_pd(s0, s1);
+	double sum = _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+	for (; i < n; ++i) sum += a[i] * b[i];
+	return sum;
+}
+
+bool CpuDispatch::fillSSE41(Kernels& k) {
+	PortableKernels<SSE41>::fill(k);
+	k.dot16 = dot16;
+	k.dot8  = dot8;
+	k.dotf  = dotf;
+	k.dotd  = dotd;
+	return true;
+}
+
+#else
+bool CpuDispatch::fillSSE41(Kernels&) { return false; }
+#endif
@@ -0,0 +1,226 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    DPPlan.cpp
+ *  Created: Oct 16, 2026
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include "DPPlan.hpp"
+using namespace cv;
+using namespace std;
+
+/*! @brief compile the part trees of a model
+ *
+ * @param parts the tree of parts, whose parts are sorted from the root to the leaves
+ */
+template<typename T>
+void DPPlan<T>::compile(Parts& parts) {
+
+	components_.clear();
+	parts_.clear();
+	mixtures_.clear();
+	biases_.clear();
+
+	for (size_t c = 0; c < parts.ncomponents(); ++c) {
+		Component component;
+		component.part      = parts_.size();
+		component.mixture   = mixtures_.size();
+		component.nparts    = parts.nparts(c);
+		component.nslots    = 0;
+		component.bias      = parts.component(c).bias(0)[0];
+
+		for (size_t p = 0; p < component.nparts; ++p) {
+			ComponentPart cpart  = parts.component(c, p);
+			ComponentPart parent = cpart.parent();
+			assert(cpart.isRoot() || (size_t)parent.self() < p);
+			Part part;
+			part.component  = c;
+			part.self       = p;
+			part.parent     = cpart.isRoot() ? 0 : parent.self();
+			part.canonical  = parts_.size();
+			part.alias      = 0;
+			part.naliases   = 0;
+			part.nchildren  = 0;
+			part.mixture    = mixtures_.size();
+			part.pmixture   = cpart.isRoot() ? part.mixture : parts_[component.part + part.parent].mixture;
+			part.nmixtures  = cpart.nmixtures();
+			part.pnmixtures = cpart.isRoot() ? 0 : parent.nmixtures();
+			part.bias       = biases_.size();
+			part.slot       = component.nslots;
+			component.nslots += part.pnmixtures;
+			assert(part.nmixtures <= 256);
+
+			for (size_t m = 0; m < part.nmixtures; ++m) {
+				Mixture mixture;
+				mixture.filter = cpart.filterid(m);
+				mixture.xsize  = cpart.xsize(m);
+				mixture.ysize  = cpart.ysize(m);
+				mixture.anchor = Point(0,0);
+				mixture.ax = mixture.bx = mixture.ay = mixture.by = 0;
+				mixture.rx = mixture.ry = 0;
+				if (!cpart.isRoot()) {
+					// the root is never deformed
+					const vectorf w = cpart.defw(m);
+					mixture.anchor = cpart.anchor(m);
+					mixture.ax     = -w[0];
+					mixture.bx     = -w[1];
+					mixture.ay     = -w[2];
+					mixture.by     = -w[3];
+
+					// the bias of this mixture given each mixture of the parent
+					const vectorf bias = cpart.bias(m);
+					for (size_t pm = 0; pm < part.pnmixtures; ++pm) biases_.push_back(bias[pm]);
+				}
+				mixtures_.push_back(mixture);
+			}
+			parts_.push_back(part);
+			if (!cpart.isRoot()) parts_[component.part + part.parent].nchildren++;
+		}
+		component.nmixtures = mixtures_.size() - component.mixture;
+		components_.push_back(component);
+	}
+	share();
+}
+
+/*! @brief find the parts whose subtrees send identical messages
+ *
+ * The message of a part depends on the filters, deformations and anchors
+ * of its mixtures, its biases given each parent mixture, and the messages
+ * of its children. Each part is keyed on these, with its children
+ * standing in by their canonical part, so a single pass from the leaves
+ * up finds identical subtrees. The first part with each key (in component
+ * order) is canonical. The roots are never shared
+ */
+template<typename T>
+void DPPlan<T>::share(void) {
+
+	map<vector<double>, size_t> keys;
+	vector<vectori> children(parts_.size());
+	for (size_t c = 0; c < components_.size(); ++c) {
+		const Component& component = components_[c];
+		for (size_t p = component.nparts-1; p > 0; --p) {
+			Part& part = parts_[component.part + p];
+
+			// key the part on its operands and its children's canonical parts
+			vector<double> key;
+			key.push_back(part.nmixtures);
+			key.push_back(part.pnmixtures);
+			for (size_t m = 0; m < part.nmixtures; ++m) {
+				const Mixture& mixture = mixtures_[part.mixture + m];
+				const double operands[] = { (double)mixture.filter, mixture.ax, mixture.bx, mixture.ay, mixture.by,
+						(double)mixture.anchor.x, (double)mixture.anchor.y };
+				key.insert(key.end(), operands, operands + 7);
+				for (size_t pm = 0; pm < part.pnmixtures; ++pm) key.push_back(bias(part, m, pm));
+			}
+			vectori& ids = children[component.part + p];
+			std::sort(ids.begin(), ids.end());
+			key.insert(key.end(), ids.begin(), ids.end());
+
+			// the first part with this key is canonical
+			const size_t self = component.part + p;
+			map<vector<double>, size_t>::const_iterator it = keys.find(key);
+			part.canonical = (it == keys.end()) ? self : it->second;
+			if (it == keys.end()) keys[key] = self;
+			children[component.part + part.parent].push_back(part.canonical);
+		}
+	}
+
+	// list the aliases of each canonical part contiguously
+	aliases_.clear();
+	for (size_t i = 0; i < parts_.size(); ++i) {
+		Part& canonical = parts_[i];
+		if (canonical.canonical != i) continue;
+		canonical.alias = aliases_.size();
+		for (size_t j = i+1; j < parts_.size(); ++j) {
+			if (parts_[j].canonical == i) aliases_.push_back(j);
+		}
+		canonical.naliases = aliases_.size() - canonical.alias;
+	}
+}
+
+/*! @brief bound the displacement of every part from its anchor
+ *
+ * With a radius, every part is bounded by it. Otherwise, with a margin,
+ * each part is bounded by the displacement beyond which its deformation
+ * costs more than the margin, so the bound only changes a detection if a
+ * part's response can exceed its response at the anchor by more than the
+ * margin. With neither, the displacements are unbounded
+ *
+ * @param radius the largest displacement in cells, or 0
+ * @param margin the largest gain in score a displacement can buy, or 0
+ */
+template<typename T>
+void DPPlan<T>::bound(int radius, double margin) {
+	for (size_t c = 0; c < components_.size(); ++c) {
+		const Component& component = components_[c];
+		for (size_t p = 1; p < component.nparts; ++p) {
+			const Part& part = parts_[component.part + p];
+			for (size_t m = 0; m < part.nmixtures; ++m) {
+				Mixture& mixture = mixtures_[part.mixture + m];
+				mixture.rx = (radius > 0) ? radius : reach(mixture.ax, mixture.bx, margin);
+				mixture.ry = (radius > 0) ? radius : reach(mixture.ay, mixture.by, margin);
+			}
+		}
+	}
+}
+
+/*! @brief the displacement beyond which a quadratic penalty exceeds a margin
+ *
+ * @param a the quadratic coefficient of the penalty (negative)
+ * @param b the linear coefficient of the penalty
+ * @param margin the margin
+ * @return the displacement, or 0 (unbounded) if there is no margin or the penalty is not concave
+ */
+template<typename T>
+int DPPlan<T>::reach(T a, T b, double margin) {
+	if (margin <= 0 || a >= 0) return 0;
+	// solve -a*d^2 - |b|*d = margin for d > 0
+	const double A = -a, B = std::abs((double)b);
+	return std::max(1, (int)std::ceil((B + std::sqrt(B*B + 4*A*margin)) / (2*A)));
+}
+
+//! the number of parts whose messages are shared
+template<typename T>
+size_t DPPlan<T>::nshared(void) const {
+	size_t count = 0;
+	for (size_t i = 0; i < parts_.size(); ++i) count += (parts_[i].canonical != i);
+	return count;
+}
+
+// declare all specializations of the template (this must be the last declaration in the file)
+template class DPPlan<float>;
+template class DPPlan<double>;
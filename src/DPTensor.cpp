@@ -0,0 +1,193 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    DPTensor.cpp
+ *  Created: Oct 16, 2026
+ */
+
+
+#include <cassert>
+#include "DPTensor.hpp"
+using namespace cv;
+using namespace std;
+
+/*! @brief allocate the tables of every component at each scale
+ *
+ * @param plan the compiled part trees
+ * @param sizes the size of the responses at each scale
+ */
+template<typename T>
+void DPTensor<T>::allocate(const DPPlan<T>& plan, const vector<Size>& sizes) {
+	const size_t C = plan.ncomponents();
+	sizes_.resize(sizes.size() * C);
+	for (size_t n = 0; n < sizes.size(); ++n) {
+		for (size_t c = 0; c < C; ++c) sizes_[n*C + c] = sizes[n];
+	}
+	layout(plan);
+}
+
+/*! @brief allocate the tables of a single component at a single scale
+ *
+ * The tables are addressed as scale 0. The tables of every other
+ * component are empty
+ *
+ * @param plan the compiled part trees
+ * @param size the size of the responses
+ * @param c the component
+ */
+template<typename T>
+void DPTensor<T>::allocate(const DPPlan<T>& plan, const Size& size, size_t c) {
+	sizes_.assign(plan.ncomponents(), Size());
+	sizes_[c] = size;
+	layout(plan);
+}
+
+/*! @brief lay the tables out in the arena, growing it if necessary
+ *
+ * The tables of each (scale, component) are contiguous: the root scores
+ * and mixtures, followed by the (Ix, Iy, Ik) slot of each (part, parent
+ * mixture) in part order
+ *
+ * @param plan the compiled part trees, given the size of the tables of each
+ * (scale, component) in sizes_
+ */
+template<typename T>
+void DPTensor<T>::layout(const DPPlan<T>& plan) {
+
+	plan_ = &plan;
+	ncomponents_ = plan.ncomponents();
+	nscales_ = sizes_.size() / ncomponents_;
+
+	// offset the tables of each (scale, component)
+	size_t bytes = 0;
+	offsets_.resize(sizes_.size());
+	for (size_t nc = 0; nc < sizes_.size(); ++nc) {
+		const size_t area = sizes_[nc].area();
+		offsets_[nc] = bytes;
+		if (area == 0) continue;
+		assert(sizes_[nc].width <= 32767 && sizes_[nc].height <= 32767);
+		bytes += align(sizeof(T) * area) + align(area);
+		bytes += plan.component(nc % ncomponents_).nslots * (2*align(sizeof(Index) * area) + align(area));
+	}
+
+	// grow the arena only if this layout does not fit
+	if (arena_.total() < bytes + ALIGN) arena_.create(1, bytes + ALIGN, CV_8U);
+	const size_t misalign = (size_t)arena_.data % ALIGN;
+	data_ = arena_.data + (misalign ? ALIGN - misalign : 0);
+}
+
+/*! @brief the byte offset of the Ix table of a (part, parent mixture)
+ */
+template<typename T>
+size_t DPTensor<T>::slot(size_t n, size_t c, size_t p, size_t m) const {
+	const size_t nc = n*ncomponents_ + c;
+	const size_t area = sizes_[nc].area();
+	assert(p > 0 && p < plan_->component(c).nparts);
+	return offsets_[nc] + align(sizeof(T) * area) + align(area) + (plan_->part(c, p).slot + m) * (2*align(sizeof(Index) * area) + align(area));
+}
+
+//! a matrix header over a table of the arena
+template<typename T>
+Mat DPTensor<T>::view(size_t offset, const Size& size, int type) const {
+	return Mat(size, type, data_ + offset);
+}
+
+//! release the arena and every table
+template<typename T>
+void DPTensor<T>::release(void) {
+	arena_.release();
+	data_ = NULL;
+	nscales_ = ncomponents_ = 0;
+	sizes_.clear();
+	offsets_.clear();
+	plan_ = NULL;
+}
+
+/*! @brief the x location of part p at each location of its parent, for parent mixture m
+ *
+ * @param n the scale
+ * @param c the component
+ * @param p the part (not the root)
+ * @param m the mixture of the parent
+ * @return a CV_16S view into the arena
+ */
+template<typename T>
+Mat DPTensor<T>::Ix(size_t n, size_t c, size_t p, size_t m) const {
+	return view(slot(n, c, p, m), size(n, c), CV_16S);
+}
+
+//! the y location of part p at each location of its parent, for parent mixture m (CV_16S)
+template<typename T>
+Mat DPTensor<T>::Iy(size_t n, size_t c, size_t p, size_t m) const {
+	const size_t area = size(n, c).area();
+	return view(slot(n, c, p, m) + align(sizeof(Index) * area), size(n, c), CV_16S);
+}
+
+//! the mixture of part p at each location of its parent, for parent mixture m (CV_8U)
+template<typename T>
+Mat DPTensor<T>::Ik(size_t n, size_t c, size_t p, size_t m) const {
+	const size_t area = size(n, c).area();
+	return view(slot(n, c, p, m) + 2*align(sizeof(Index) * area), size(n, c), CV_8U);
+}
+
+//! the root scores of a (scale, component)
+template<typename T>
+Mat DPTensor<T>::rootv(size_t n, size_t c) const {
+	return view(offsets_[n*ncomponents_ + c], size(n, c), DataType<T>::type);
+}
+
+//! the best root mixture at each location of a (scale, component) (CV_8U)
+template<typename T>
+Mat DPTensor<T>::rooti(size_t n, size_t c) const {
+	return view(offsets_[n*ncomponents_ + c] + align(sizeof(T) * size(n, c).area()), size(n, c), CV_8U);
+}
+
+/*! @brief the bytes of tables per location of a scale, over every component
+ *
+ * Ignores the alignment padding, which is negligible for all but tiny levels
+ *
+ * @param plan the compiled part trees
+ * @return the number of bytes
+ */
+template<typename T>
+size_t DPTensor<T>::cellBytes(const DPPlan<T>& plan) {
+	size_t bytes = 0;
+	for (size_t c = 0; c < plan.ncomponents(); ++c) {
+		bytes += sizeof(T) + sizeof(Mixture) + plan.component(c).nslots * (2*sizeof(Index) + sizeof(Mixture));
+	}
+	return bytes;
+}
+
+// declare all specializations of the template (this must be the last declaration in the file)
+template class DPTensor<float>;
+template class DPTensor<double>;
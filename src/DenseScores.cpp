@@ -0,0 +1,94 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    DenseScores.cpp
+ *  Created: Oct 16, 2026
+ */
+
+#include <cmath>
+#include <limits>
+#include <opencv2/imgproc/imgproc.hpp>
+#include "DenseScores.hpp"
+using namespace cv;
+using namespace std;
+
+/*! @brief lay out the buffer for a set of score maps
+ *
+ * The maps are packed in the order given, and the begin of each is set.
+ * The buffer is reused if it is already large enough
+ *
+ * @param maps the placement of each map
+ * @param type the type of the scores (CV_32F or CV_64F)
+ */
+void DenseScores::allocate(const vector<Map>& maps, int type) {
+	maps_ = maps;
+	size_t total = 0;
+	for (size_t i = 0; i < maps_.size(); ++i) {
+		maps_[i].begin = total;
+		total += maps_[i].size.area();
+	}
+	buffer_.create(1, std::max(total, (size_t)1), type);
+}
+
+/*! @brief project the maximum over scales and components into the image
+ *
+ * Each cell of a map covers a square of scale pixels centred on its image
+ * location. The projection holds, at each pixel, the best score of any
+ * cell covering it, or -infinity where no cell does
+ *
+ * @param imsize the size of the image
+ * @param projection the projection, of imsize and the type of the scores
+ */
+void DenseScores::project(const Size& imsize, Mat& projection) const {
+
+	const int type = buffer_.empty() ? CV_32F : buffer_.type();
+	projection.create(imsize, type);
+	projection.setTo(Scalar::all(-numeric_limits<double>::infinity()));
+
+	const Rect frame(Point(0, 0), imsize);
+	Mat resized;
+	for (size_t i = 0; i < maps_.size(); ++i) {
+		const Map& m = maps_[i];
+		if (m.size.area() == 0) continue;
+
+		// the footprint of the map in the image
+		const Point tl((int)floor(m.offset.x - m.scale/2 + 0.5), (int)floor(m.offset.y - m.scale/2 + 0.5));
+		const Size footprint((int)floor(m.size.width*m.scale + 0.5), (int)floor(m.size.height*m.scale + 0.5));
+		const Rect roi = Rect(tl, footprint) & frame;
+		if (roi.area() == 0) continue;
+
+		resize(scores(i), resized, footprint, 0, 0, INTER_NEAREST);
+		Mat dst = projection(roi);
+		cv::max(dst, resized(Rect(roi.tl() - tl, roi.size())), dst);
+	}
+}
@@ -36,8 +36,10 @@
  *  Created: Jun 21, 2012
  */
 
+#include <boost/bind.hpp>
 #include "Math.hpp"
 #include "DynamicProgram.hpp"
+#include "TaskScheduler.hpp"
 using namespace cv;
 using namespace std;
 
@@ -54,121 +56,353 @@ using namespace std;
  * 		(2) Shift by the anchor position of the part wrt the parent
  * 		(3) Downsample if necessary
  *
- * @param parts the parts tree, referenced by the root
  * @param scores the probability densities (pdfs) of part locations (fine to coarse)
- * @param Ix the detection indices in the x direction
- * @param Iy the detection indices in the y direction
- * @param Ik the best mixture at each pixel
- * @param rootv the root scores, across scale
- * @param rooti the root indices, across scale
+ * @param tables the tables of part locations, mixtures and root scores to fill
  *
  */
 template<typename T>
-void DynamicProgram<T>::min(Parts& parts, vector2DMat& scores, vector4DMat& Ix, vector4DMat& Iy, vector4DMat& Ik, vector2DMat& rootv, vector2DMat& rooti) {
+void DynamicProgram<T>::min(vector2DMat& scores, DPTensor<T>& tables) {
+	ResponseCache cache(scores);
+	min(cache, tables);
+}
+
+/*! @brief Get the min of a dynamic program over lazily computed scores
+ *
+ * Each response is computed the first time a part reads it, so the
+ * convolutions run inside the message passing tasks, and responses which
+ * are never read are never computed.
+ *
+ * Messages are passed as a graph of tasks rather than one task per
+ * (scale, component): each mixture of a part is distance transformed as
+ * soon as every child has passed its message, so sibling subtrees and the
+ * mixtures of a part are processed in parallel, and a single large level
+ * can occupy every thread. Parts which the plan shares between components
+ * are computed once per scale, by their canonical part
+ *
+ * @param scores the pdfs of part locations (fine to coarse), computed on demand
+ * @param tables the tables of part locations, mixtures and root scores to fill.
+ * Its arena is reused if it is large enough
+ */
+template<typename T>
+void DynamicProgram<T>::min(ResponseCache& scores, DPTensor<T>& tables) {
 
-	// initialize the outputs, preallocate vectors to make them thread safe
-	// TODO: better initialisation of Ix, Iy, Ik
+	// lay out the tables up front, so the tasks write to disjoint views
 	const size_t nscales = scores.size();
-	const size_t ncomponents = parts.ncomponents();
-	Ix.resize(nscales, vector3DMat(ncomponents));
-	Iy.resize(nscales, vector3DMat(ncomponents));
-	Ik.resize(nscales, vector3DMat(ncomponents));
-	rootv.resize(nscales, vectorMat(ncomponents));
-	rooti.resize(nscales, vectorMat(ncomponents));
+	const size_t ncomponents = plan_.ncomponents();
+	vector<Size> sizes(nscales);
+	for (size_t n = 0; n < nscales; ++n) sizes[n] = scores.levelSize(n);
+	tables.allocate(plan_, sizes);
 
 	// for each scale, and each component, update the scores through message passing
-	#ifdef _OPENMP
-	#pragma omp parallel for
-	#endif
-	for (size_t nc = 0; nc < nscales*ncomponents; ++nc) {
-
-		// calculate the inner loop variables from the dual variables
-		const size_t n = floor(nc / ncomponents);
-		const size_t c = nc % ncomponents;
-
-		// allocate the inner loop variables
-		Ix[n][c].resize(parts.nparts(c));
-		Iy[n][c].resize(parts.nparts(c));
-		Ik[n][c].resize(parts.nparts(c));
-		vectorMat ncscores(scores[n].size());
-
-		for (int p = parts.nparts(c)-1; p > 0; --p) {
-
-			// get the component part (which may have multiple mixtures associated with it)
-			ComponentPart cpart = parts.component(c, p);
-			const size_t nmixtures  = cpart.nmixtures();
-			const size_t pnmixtures = cpart.parent().nmixtures();
-			Ix[n][c][p].resize(pnmixtures);
-			Iy[n][c][p].resize(pnmixtures);
-			Ik[n][c][p].resize(pnmixtures);
-
-			// intermediate results for mixtures of this part
-			vectorMat scoresp;
-			vectorMat Ixp;
-			vectorMat Iyp;
-
-			for (size_t m = 0; m < nmixtures; ++m) {
-
-				// raw score outputs
-				Mat_<T> score_in, score_dt;
-				Mat_<int> Ix_dt, Iy_dt;
-				if (cpart.score(ncscores, m).empty()) {
-					score_in = cpart.score(scores[n], m);
-				} else {
-					score_in = cpart.score(ncscores, m);
-				}
+	TaskGroup group;
+	if (messages_.size() < nscales*ncomponents) messages_.resize(nscales*ncomponents);
+	vector<Task> tasks;
+	vector<double> costs;
+	for (size_t n = 0; n < nscales; ++n) {
+		for (size_t c = 0; c < ncomponents; ++c) {
+			Messages& msg = messages_[n*ncomponents + c];
+			msg.init(plan_, scores, tables, group, n, c);
+			msg.siblings = &messages_[n*ncomponents];
+		}
+		for (size_t c = 0; c < ncomponents; ++c) seed(messages_[n*ncomponents + c], tasks, costs);
+	}
+	TaskScheduler& scheduler = TaskScheduler::global();
+	scheduler.run(group, tasks, costs);
+	scheduler.wait(group);
+}
 
-				// get the anchor position
-				Point anchor = cpart.anchor(m);
-
-				// compute the distance transform
-				vectorf w = cpart.defw(m);
-				Quadratic fx(-w[0], -w[1]);
-				Quadratic fy(-w[2], -w[3]);
-				dt_.compute(score_in, fx, fy, anchor, score_dt, Ix_dt, Iy_dt);
-				scoresp.push_back(score_dt);
-				Ixp.push_back(Ix_dt);
-				Iyp.push_back(Iy_dt);
-			}
+/*! @brief pass messages up the tree of a single component at a single scale
+ *
+ * @param scores the pdfs of part locations, computed on demand
+ * @param m the level of the scores to read
+ * @param tables the tables to fill, already allocated for (n, c)
+ * @param n the scale of the tables to fill
+ * @param c the component
+ */
+template<typename T>
+void DynamicProgram<T>::minComponent(ResponseCache& scores, size_t m, DPTensor<T>& tables, size_t n, size_t c) {
+	TaskGroup group;
+	Messages msg;
+	msg.init(plan_, scores, tables, group, n, c, m);
+	vector<Task> tasks;
+	vector<double> costs;
+	seed(msg, tasks, costs);
+	TaskScheduler& scheduler = TaskScheduler::global();
+	scheduler.run(group, tasks, costs);
+	scheduler.wait(group);
+}
 
-			for (size_t m = 0; m < pnmixtures; ++m) {
-				vectorMat weighted;
-				// weight each of the child scores
-				// TODO: More elegant way of handling bias
-				for (size_t mm = 0; mm < nmixtures; ++mm) {
-					weighted.push_back(scoresp[mm] + cpart.bias(mm)[m]);
-				}
-				// compute the max over the mixtures
-				Mat maxv, maxi;
-				Math::reduceMax<T>(weighted, maxv, maxi);
-
-				// choose the best indices
-				Mat Ixm, Iym;
-				Math::reducePickIndex<int>(Ixp, maxi, Ixm);
-				Math::reducePickIndex<int>(Iyp, maxi, Iym);
-				Ix[n][c][p][m] = Ixm;
-				Iy[n][c][p][m] = Iym;
-				Ik[n][c][p][m] = maxi;
-
-				// update the parent's score
-				ComponentPart parent = cpart.parent();
-				if (parent.score(ncscores,m).empty()) parent.score(scores[n],m).copyTo(parent.score(ncscores,m));
-				parent.score(ncscores,m) += maxv;
-				if (parent.self() == 0) {
-					ComponentPart root = parts.component(c);
-				}
-			}
+/*! @brief set up the message passing state of a (scale, component)
+ *
+ * @param plan the compiled part trees
+ * @param scores the responses
+ * @param tables the tables to fill, already allocated for (n, c)
+ * @param group the group the message passing tasks join
+ * @param n the scale of the tables
+ * @param c the component
+ * @param level the level of the responses (n by default)
+ */
+template<typename T>
+void DynamicProgram<T>::Messages::init(const DPPlan<T>& plan, ResponseCache& scores, DPTensor<T>& tables, TaskGroup& group, size_t n, size_t c, size_t level) {
+	const typename DPPlan<T>::Component& component = plan.component(c);
+	this->scores = &scores;
+	this->tables = &tables;
+	this->group  = &group;
+	this->siblings = NULL;
+	this->level  = (level == (size_t)-1) ? n : level;
+	this->n = n;
+	this->c = c;
+	ncscores.assign(component.nmixtures, Mat());
+	scoresp.assign(component.nmixtures, Mat());
+	Ixp.assign(component.nmixtures, Mat());
+	Iyp.assign(component.nmixtures, Mat());
+	inputs.resize(component.nparts);
+	transforms.resize(component.nparts);
+	reductions.resize(component.nparts);
+	for (size_t p = 0; p < component.nparts; ++p) {
+		const typename DPPlan<T>::Part& part = plan.part(c, p);
+		inputs[p]     = part.nchildren * part.nmixtures;
+		transforms[p] = part.nmixtures;
+		reductions[p] = part.pnmixtures;
+	}
+	// the locks are kept across frames, unless shared with a copy of the program
+	if (nlocks != component.nparts || !locks.unique()) {
+		locks.reset(new boost::mutex[component.nparts]);
+		nlocks = component.nparts;
+	}
+}
+
+/*! @brief gather the tasks which start the message passing of a (scale, component)
+ *
+ * The leaves are distance transformed straight from their responses. A
+ * component with a lone root goes straight to the root. When every
+ * component runs together, only the canonical leaves are started: the
+ * messages of shared parts arrive from their canonical parts
+ *
+ * @param msg the message passing state
+ * @param tasks the tasks to append to
+ * @param costs the cost of each task
+ */
+template<typename T>
+void DynamicProgram<T>::seed(Messages& msg, vector<Task>& tasks, vector<double>& costs) {
+	const typename DPPlan<T>::Component& component = plan_.component(msg.c);
+	const double cost = msg.scores->cost(msg.level);
+	if (component.nparts == 1) {
+		tasks.push_back(boost::bind(&DynamicProgram<T>::root, this, &msg));
+		costs.push_back(cost);
+		return;
+	}
+	for (size_t p = 1; p < component.nparts; ++p) {
+		const typename DPPlan<T>::Part& part = plan_.part(msg.c, p);
+		if (part.nchildren > 0 || (msg.siblings && plan_.shared(part))) continue;
+		for (size_t m = 0; m < part.nmixtures; ++m) {
+			tasks.push_back(boost::bind(&DynamicProgram<T>::transform, this, &msg, p, m));
+			costs.push_back(cost);
 		}
-		// add bias to the root score and find the best mixture
-		ComponentPart root = parts.component(c);
-		Mat rncscore = root.score(ncscores,0);
-		T bias = root.bias(0)[0];
-		vectorMat weighted;
-		// weight each of the child scores
-		for (size_t m = 0; m < root.nmixtures(); ++m) {
-			weighted.push_back(root.score(ncscores,m) + bias);
+	}
+}
+
+/*! @brief distance transform a mixture of a part, once its children have passed their messages
+ *
+ * The last mixture of the part to finish passes the part's messages to its parent
+ *
+ * @param msg the message passing state
+ * @param p the part
+ * @param m the mixture
+ */
+template<typename T>
+void DynamicProgram<T>::transform(Messages* msg, size_t p, size_t m) {
+
+	const typename DPPlan<T>::Component& component = plan_.component(msg->c);
+	const typename DPPlan<T>::Part& part = plan_.part(msg->c, p);
+	const typename DPPlan<T>::Mixture& mixture = plan_.mixture(part, m);
+	const size_t k = part.mixture - component.mixture + m;
+
+	// the raw response of a leaf, or the accumulated score of an inner part
+	Mat& ncscore = msg->ncscores[k];
+	Mat_<T> score_in = ncscore.empty() ? msg->scores->at(msg->level, mixture.filter) : ncscore;
+
+	// compute the distance transform
+	Mat_<T> score_dt;
+	Mat_<int> Ix_dt, Iy_dt;
+	const Quadratic fx(mixture.ax, mixture.bx), fy(mixture.ay, mixture.by);
+	if (mixture.rx > 0 && mixture.ry > 0) {
+		dt_.compute(score_in, fx, fy, mixture.anchor, Size(mixture.rx, mixture.ry), score_dt, Ix_dt, Iy_dt);
+	} else {
+		dt_.compute(score_in, fx, fy, mixture.anchor, score_dt, Ix_dt, Iy_dt);
+	}
+	msg->scoresp[k] = score_dt;
+	msg->Ixp[k] = Ix_dt;
+	msg->Iyp[k] = Iy_dt;
+	ncscore.release();
+
+	// the last mixture to finish sends a message for each mixture of the parent
+	if (__sync_sub_and_fetch(&msg->transforms[p], 1) > 0) return;
+	TaskScheduler& scheduler = TaskScheduler::global();
+	for (size_t pm = 0; pm < part.pnmixtures; ++pm) {
+		scheduler.run(*msg->group, boost::bind(&DynamicProgram<T>::reduce, this, msg, p, pm));
+	}
+}
+
+/*! @brief pass the message of a part to a mixture of its parent
+ *
+ * Chooses the best mixture of the part at each location, records its
+ * location in the tables and adds its score to the parent's. The last
+ * message into the parent starts the parent's distance transforms
+ *
+ * @param msg the message passing state
+ * @param p the part
+ * @param pm the mixture of the parent
+ */
+template<typename T>
+void DynamicProgram<T>::reduce(Messages* msg, size_t p, size_t pm) {
+
+	const typename DPPlan<T>::Component& component = plan_.component(msg->c);
+	const typename DPPlan<T>::Part& part = plan_.part(msg->c, p);
+	const typename DPPlan<T>::Part& parent = plan_.part(msg->c, part.parent);
+	const size_t first = part.mixture - component.mixture;
+	const size_t n = msg->n, c = msg->c;
+
+	// weight each of the child scores
+	vectorMat weighted(part.nmixtures);
+	vectorMat Ixp(part.nmixtures), Iyp(part.nmixtures);
+	for (size_t m = 0; m < part.nmixtures; ++m) {
+		add(msg->scoresp[first + m], Scalar::all(plan_.bias(part, m, pm)), weighted[m]);
+		Ixp[m] = msg->Ixp[first + m];
+		Iyp[m] = msg->Iyp[first + m];
+	}
+
+	// compute the max over the mixtures
+	Mat maxv, maxi;
+	Math::reduceMax<T>(weighted, maxv, maxi);
+
+	// choose the best indices, straight into the tables
+	Mat Ix = msg->tables->Ix(n, c, p, pm), Iy = msg->tables->Iy(n, c, p, pm), Ik = msg->tables->Ik(n, c, p, pm);
+	pick(Ixp, Iyp, maxi, Ix, Iy, Ik);
+
+	// the last message of the part releases its transforms
+	if (__sync_sub_and_fetch(&msg->reductions[p], 1) == 0) {
+		for (size_t m = 0; m < part.nmixtures; ++m) {
+			msg->scoresp[first + m].release();
+			msg->Ixp[first + m].release();
+			msg->Iyp[first + m].release();
+		}
+	}
+
+	// a component run alone computes all of its own messages
+	if (!msg->siblings) {
+		deliver(msg, p, pm, maxv);
+		return;
+	}
+
+	// otherwise the message is also the message of each alias of the part.
+	// Each takes a copy of the tables, and the parts whose parents are not
+	// themselves shared pass the message on
+	if (!plan_.shared(parent)) deliver(msg, p, pm, maxv);
+	for (size_t a = 0; a < part.naliases; ++a) {
+		const typename DPPlan<T>::Part& alias = plan_.alias(part, a);
+		Messages* other = &msg->siblings[alias.component];
+		Mat aIx = other->tables->Ix(n, alias.component, alias.self, pm);
+		Mat aIy = other->tables->Iy(n, alias.component, alias.self, pm);
+		Mat aIk = other->tables->Ik(n, alias.component, alias.self, pm);
+		Ix.copyTo(aIx);
+		Iy.copyTo(aIy);
+		Ik.copyTo(aIk);
+		if (!plan_.shared(plan_.part(alias.component, alias.parent))) deliver(other, alias.self, pm, maxv);
+	}
+}
+
+/*! @brief add the message of a part into a mixture of its parent
+ *
+ * Siblings add into the parent concurrently. The last message into the
+ * parent starts the parent's distance transforms (or the root)
+ *
+ * @param msg the message passing state of the part's component
+ * @param p the part
+ * @param pm the mixture of the parent
+ * @param maxv the message
+ */
+template<typename T>
+void DynamicProgram<T>::deliver(Messages* msg, size_t p, size_t pm, const Mat& maxv) {
+
+	const typename DPPlan<T>::Component& component = plan_.component(msg->c);
+	const typename DPPlan<T>::Part& part = plan_.part(msg->c, p);
+	const typename DPPlan<T>::Part& parent = plan_.part(msg->c, part.parent);
+
+	// update the parent's score
+	{
+		const size_t k = part.pmixture - component.mixture + pm;
+		boost::unique_lock<boost::mutex> lock(msg->locks[part.parent]);
+		Mat& pscore = msg->ncscores[k];
+		if (pscore.empty()) msg->scores->at(msg->level, plan_.mixture(parent, pm).filter).copyTo(pscore);
+		pscore += maxv;
+	}
+
+	// the last message into the parent starts the parent
+	if (__sync_sub_and_fetch(&msg->inputs[part.parent], 1) > 0) return;
+	TaskScheduler& scheduler = TaskScheduler::global();
+	if (part.parent == 0) {
+		scheduler.run(*msg->group, boost::bind(&DynamicProgram<T>::root, this, msg));
+	} else {
+		for (size_t m = 0; m < parent.nmixtures; ++m) {
+			scheduler.run(*msg->group, boost::bind(&DynamicProgram<T>::transform, this, msg, part.parent, m));
+		}
+	}
+}
+
+/*! @brief add bias to the root score and find the best mixture
+ *
+ * @param msg the message passing state
+ */
+template<typename T>
+void DynamicProgram<T>::root(Messages* msg) {
+
+	const typename DPPlan<T>::Component& component = plan_.component(msg->c);
+	const typename DPPlan<T>::Part& root = plan_.part(msg->c, 0);
+	vectorMat weighted(root.nmixtures);
+	for (size_t m = 0; m < root.nmixtures; ++m) {
+		const Mat& ncscore = msg->ncscores[root.mixture - component.mixture + m];
+		const Mat& score = ncscore.empty() ? msg->scores->at(msg->level, plan_.mixture(root, m).filter) : ncscore;
+		add(score, Scalar::all(component.bias), weighted[m]);
+	}
+	Mat maxv, maxi;
+	Math::reduceMax<T>(weighted, maxv, maxi);
+	Mat rootv = msg->tables->rootv(msg->n, msg->c), rooti = msg->tables->rooti(msg->n, msg->c);
+	maxv.copyTo(rootv);
+	maxi.convertTo(rooti, rooti.type());
+	for (size_t m = 0; m < root.nmixtures; ++m) msg->ncscores[root.mixture - component.mixture + m].release();
+}
+
+/*! @brief pick the locations of the best mixture at each location, narrowing them into the tables
+ *
+ * @param Ixp the x locations of each mixture
+ * @param Iyp the y locations of each mixture
+ * @param maxi the best mixture at each location
+ * @param Ix the x locations of the best mixture (CV_16S)
+ * @param Iy the y locations of the best mixture (CV_16S)
+ * @param Ik the best mixture (CV_8U)
+ */
+template<typename T>
+void DynamicProgram<T>::pick(const vectorMat& Ixp, const vectorMat& Iyp, const Mat& maxi, Mat Ix, Mat Iy, Mat Ik) {
+
+	typedef typename DPTensor<T>::Index Index;
+	typedef typename DPTensor<T>::Mixture Mixture;
+	const size_t K = Ixp.size();
+	vector<const int*> xrows(K), yrows(K);
+	for (int y = 0; y < maxi.rows; ++y) {
+		for (size_t k = 0; k < K; ++k) {
+			xrows[k] = Ixp[k].ptr<int>(y);
+			yrows[k] = Iyp[k].ptr<int>(y);
+		}
+		const int* k = maxi.ptr<int>(y);
+		Index* ix = Ix.ptr<Index>(y);
+		Index* iy = Iy.ptr<Index>(y);
+		Mixture* ik = Ik.ptr<Mixture>(y);
+		for (int x = 0; x < maxi.cols; ++x) {
+			ix[x] = xrows[k[x]][x];
+			iy[x] = yrows[k[x]][x];
+			ik[x] = k[x];
 		}
-		Math::reduceMax<T>(weighted, rootv[n][c], rooti[n][c]);
 	}
 }
 
@@ -176,81 +410,186 @@ void DynamicProgram<T>::min(Parts& parts, vector2DMat& scores, vector4DMat& Ix,
 /*! @brief get the argmin of a dynamic program
  *
  * Get the minimum argument of a dynamic program by traversing down the tree of
- * a dynamic program, returning the locations of the best nodes
- * @param parts the tree of parts, referenced by the root
- * @param rootv the root scores, across scale
- * @param rooti the root indices, across scale
+ * a dynamic program, returning the locations of the best nodes.
+ *
+ * The root locations over threshold at every scale and component are
+ * gathered into a single list first, since one fine scale often holds
+ * almost all of them. The list is then split into even bands, one per
+ * thread, and each band is traced into its own buffer. The buffers are
+ * concatenated in order, so the candidates come out in the order of the
+ * list (by scale, component, then location) whatever the number of threads
+ * @param tables the tables filled by min()
  * @param scales the scales (used to calculate bounding box size)
- * @param Ix the detection indices in the x direction
- * @param Iy the detection indices in the y direction
- * @param Ik the best mixture at each pixel
  * @param candidates
  */
 template<typename T>
-void DynamicProgram<T>::argmin(Parts& parts, const vector2DMat& rootv, const vector2DMat& rooti, const vectorf scales, const vector4DMat& Ix, const vector4DMat& Iy, const vector4DMat& Ik, vectorCandidate& candidates) {
+void DynamicProgram<T>::argmin(const DPTensor<T>& tables, const vectorf scales, vectorCandidate& candidates) {
 
-	// for each scale, and each component, traverse back down the tree to retrieve the part positions
-	const size_t nscales = scales.size();
-	#ifdef _OPENMP
-	#pragma omp parallel for
-	#endif
-	for (size_t n = 0; n < nscales; ++n) {
-		T scale = scales[n];
-		for (size_t c = 0; c < parts.ncomponents(); ++c) {
-
-			// get the scores and indices for this tree of parts
-			const vector2DMat& Iknc = Ik[n][c];
-			const vector2DMat& Ixnc = Ix[n][c];
-			const vector2DMat& Iync = Iy[n][c];
-			const size_t nparts = parts.nparts(c);
-
-			// threshold the root score
-			Mat over_thresh = rootv[n][c] > thresh_;
-			Mat rootmix     = rooti[n][c];
-			vectorPoint inds;
-			Math::find(over_thresh, inds);
-
-			for (size_t i = 0; i < inds.size(); ++i) {
-				Candidate candidate;
-				candidate.setComponent(c);
-				vectori     xv(nparts);
-				vectori     yv(nparts);
-				vectori     mv(nparts);
-				for (size_t p = 0; p < nparts; ++p) {
-					ComponentPart part = parts.component(c, p);
-					// calculate the child's points from the parent's points
-					size_t x, y, m;
-					if (part.isRoot()) {
-						x = xv[0] = inds[i].x;
-						y = yv[0] = inds[i].y;
-						m = mv[0] = rootmix.at<int>(inds[i]);
-					} else {
-						int idx = part.parent().self();
-						x = xv[idx];
-						y = yv[idx];
-						m = mv[idx];
-						xv[p] = Ixnc[p][m].at<int>(y,x);
-						yv[p] = Iync[p][m].at<int>(y,x);
-						mv[p] = Iknc[p][m].at<int>(y,x);
-					}
-
-					// calculate the bounding rectangle and add it to the Candidate
-					Point pone = Point(1,1);
-					Point xy1 = (Point(xv[p],yv[p])-pone)*scale;
-					Point xy2 = xy1 + Point(part.xsize(mv[p]), part.ysize(mv[p]))*scale - pone;
-					if (part.isRoot()) 
-					  candidate.addPart(Rect(xy1, xy2), rootv[n][c].at<T>(inds[i]));
-					else
-					  candidate.addPart(Rect(xy1, xy2), 0.0);
-				}
-				#ifdef _OPENMP
-				#pragma omp critical(addcandidate)
-				#endif
-				{
-					candidates.push_back(candidate);
+	std::vector<Hit> hits;
+	for (size_t n = 0; n < scales.size(); ++n) {
+		for (size_t c = 0; c < plan_.ncomponents(); ++c) {
+			threshold(tables.rootv(n, c), n, c, scales[n], Point(), hits);
+		}
+	}
+	backtrack(tables, hits, candidates);
+}
+
+/*! @brief traverse down the tree of a single component at a single scale
+ *
+ * @param tables the tables filled by min()
+ * @param rootv the root scores to threshold: the tables' root scores of
+ * (n, c), or a copy of them with the locations to skip masked out
+ * @param n the scale of the tables
+ * @param c the component
+ * @param scale the scale factor (used to calculate bounding box size)
+ * @param candidates the vector of candidates to append to
+ * @param origin the level coordinates of the tables' origin, if they were
+ * filled over a window of the level. The boxes are computed from the level
+ * coordinates, so they match those of tables filled over the whole level
+ */
+template<typename T>
+void DynamicProgram<T>::argminComponent(const DPTensor<T>& tables, const Mat& rootv, size_t n, size_t c, T scale, vectorCandidate& candidates, const Point& origin) {
+	std::vector<Hit> hits;
+	threshold(rootv, n, c, scale, origin, hits);
+	backtrack(tables, hits, candidates);
+}
+
+/*! @brief append the root locations of (n, c) over threshold to a list of hits
+ *
+ * @param rootv the root scores to threshold
+ * @param n the scale of the tables
+ * @param c the component
+ * @param scale the scale factor
+ * @param origin the level coordinates of the tables' origin
+ * @param hits the list to append to, in row-major order of the locations
+ */
+template<typename T>
+void DynamicProgram<T>::threshold(const Mat& rootv, size_t n, size_t c, T scale, const Point& origin, std::vector<Hit>& hits) const {
+	Mat over_thresh = rootv > thresh_;
+	vectorPoint inds;
+	Math::find(over_thresh, inds);
+	hits.reserve(hits.size() + inds.size());
+	for (size_t i = 0; i < inds.size(); ++i) {
+		Hit hit;
+		hit.n = n;
+		hit.c = c;
+		hit.at = inds[i];
+		hit.origin = origin;
+		hit.score = rootv.at<T>(inds[i]);
+		hit.scale = scale;
+		hits.push_back(hit);
+	}
+}
+
+/*! @brief trace a list of hits back down their trees, in parallel
+ *
+ * @param tables the tables filled by min()
+ * @param hits the root locations to trace
+ * @param candidates the vector of candidates to append to, in the order of the hits
+ */
+template<typename T>
+void DynamicProgram<T>::backtrack(const DPTensor<T>& tables, const std::vector<Hit>& hits, vectorCandidate& candidates) {
+	if (hits.empty()) return;
+
+	// bands of at least kMinHits, so small lists are not worth the hand-off
+	static const size_t kMinHits = 16;
+	TaskScheduler& scheduler = TaskScheduler::global();
+	vector<size_t> bounds;
+	TaskScheduler::bands(hits.size(), kMinHits, scheduler.nthreads(), bounds);
+	vector<vectorCandidate> found(bounds.size()-1);
+	scheduler.parallelFor(bounds.size()-1, boost::bind(&DynamicProgram<T>::backtrackBand,
+			this, boost::cref(tables), boost::cref(hits), boost::cref(bounds), boost::ref(found), _1));
+
+	size_t total = candidates.size();
+	for (size_t b = 0; b < found.size(); ++b) total += found[b].size();
+	candidates.reserve(total);
+	for (size_t b = 0; b < found.size(); ++b) {
+		candidates.insert(candidates.end(), found[b].begin(), found[b].end());
+	}
+}
+
+/*! @brief trace a band of hits back down their trees
+ *
+ * Runs the component's parts of the plan forwards, from the root to the
+ * leaves. The hits of a (scale, component) are contiguous in the list, so
+ * the tables are resolved once per run of hits rather than once per hit
+ *
+ * @param tables the tables filled by min()
+ * @param hits the root locations to trace
+ * @param bounds the band boundaries, bounds[b] to bounds[b+1] is band b
+ * @param found the candidates of each band
+ * @param b the band
+ */
+template<typename T>
+void DynamicProgram<T>::backtrackBand(const DPTensor<T>& tables, const std::vector<Hit>& hits, const std::vector<size_t>& bounds, std::vector<vectorCandidate>& found, size_t b) const {
+
+	typedef typename DPTensor<T>::Index Index;
+	typedef typename DPTensor<T>::Mixture Mixture;
+	typedef typename DPPlan<T>::Part Part;
+
+	vectorCandidate& candidates = found[b];
+	candidates.reserve(bounds[b+1] - bounds[b]);
+
+	// the tables of each (part, parent mixture) of the current (scale, component)
+	size_t n = -1, c = -1, nparts = 0;
+	Mat rootmix;
+	vectorMat Ix, Iy, Ik;
+	vectori xv, yv, mv;
+	for (size_t i = bounds[b]; i < bounds[b+1]; ++i) {
+		const Hit& hit = hits[i];
+		if (hit.n != n || hit.c != c) {
+			n = hit.n;
+			c = hit.c;
+			const typename DPPlan<T>::Component& component = plan_.component(c);
+			nparts  = component.nparts;
+			rootmix = tables.rooti(n, c);
+			Ix.assign(component.nslots, Mat());
+			Iy.assign(component.nslots, Mat());
+			Ik.assign(component.nslots, Mat());
+			for (size_t p = 1; p < nparts; ++p) {
+				const Part& part = plan_.part(c, p);
+				for (size_t pm = 0; pm < part.pnmixtures; ++pm) {
+					Ix[part.slot + pm] = tables.Ix(n, c, p, pm);
+					Iy[part.slot + pm] = tables.Iy(n, c, p, pm);
+					Ik[part.slot + pm] = tables.Ik(n, c, p, pm);
 				}
 			}
+			xv.resize(nparts);
+			yv.resize(nparts);
+			mv.resize(nparts);
 		}
+
+		const T scale = hit.scale;
+		Candidate candidate;
+		candidate.setComponent(c);
+		for (size_t p = 0; p < nparts; ++p) {
+			const Part& part = plan_.part(c, p);
+			// calculate the child's points from the parent's points
+			if (p == 0) {
+				xv[0] = hit.at.x;
+				yv[0] = hit.at.y;
+				mv[0] = rootmix.at<Mixture>(hit.at);
+			} else {
+				const size_t idx = part.parent;
+				const int x = xv[idx];
+				const int y = yv[idx];
+				const size_t s = part.slot + mv[idx];
+				xv[p] = Ix[s].at<Index>(y,x);
+				yv[p] = Iy[s].at<Index>(y,x);
+				mv[p] = Ik[s].at<Mixture>(y,x);
+			}
+
+			// calculate the bounding rectangle and add it to the Candidate
+			const typename DPPlan<T>::Mixture& mixture = plan_.mixture(part, mv[p]);
+			Point pone = Point(1,1);
+			Point xy1 = (Point(xv[p],yv[p])+hit.origin-pone)*scale;
+			Point xy2 = xy1 + Point(mixture.xsize, mixture.ysize)*scale - pone;
+			if (p == 0)
+			  candidate.addPart(Rect(xy1, xy2), hit.score);
+			else
+			  candidate.addPart(Rect(xy1, xy2), 0.0);
+		}
+		candidates.push_back(candidate);
 	}
 }
 
@@ -259,4 +598,3 @@ void DynamicProgram<T>::argmin(Parts& parts, const vector2DMat& rootv, const vec
 // declare all specializations of the template (this must be the last declaration in the file)
 template class DynamicProgram<float>;
 template class DynamicProgram<double>;
-
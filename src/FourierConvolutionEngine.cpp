@@ -36,34 +36,58 @@
  *  Created: July 6, 2013 
  */
 
-#ifdef _OPENMP
-#include <omp.h>
-#endif
 #include <math.h>
 #include <assert.h>
 #include <opencv2/core/core.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
+#include <boost/bind.hpp>
 #include "FourierConvolutionEngine.hpp"
+#include "TaskScheduler.hpp"
 using namespace std;
 using namespace cv;
 
 FourierConvolutionEngine::FourierConvolutionEngine(const Size& size, int type, size_t flen) :
-	size_(Size(getOptimalDFTSize(size.width), getOptimalDFTSize(size.height))), type_(type), flen_(flen) {}
+	size_(Size(getOptimalDFTSize(size.width), getOptimalDFTSize(size.height))), type_(type), flen_(flen), bound_(NULL) {}
 
 FourierConvolutionEngine::~FourierConvolutionEngine() {
 	// TODO Auto-generated destructor stub
 }
 
+/*! @brief the preferred feature format
+ *
+ * The engine transforms each channel plane separately, so it prefers
+ * unpadded PLANAR features
+ */
+FeatureFormat FourierConvolutionEngine::preferredFormat(void) const {
+  return FeatureFormat(FeatureFormat::PLANAR);
+}
+
+/*! @brief set the format of the features
+ *
+ * The engine accepts INTERLEAVED features, and PLANAR features with any padding
+ *
+ * @param format the format of the features passed to pdf()
+ */
+void FourierConvolutionEngine::setFormat(const FeatureFormat& format) {
+  format_ = format;
+}
+
 void FourierConvolutionEngine::convolve(const Mat& feature, vectorMat& filter, Mat& pdf, const size_t channels) {
 
   // error checking
   assert(feature.depth() == type_);
 
-  // split the feature into separate channels
+  // split the feature into separate channels, unless it is already planar
   vectorMat featurevec;
-  split(feature.reshape(channels), featurevec);
-  Size size = featurevec[0].size();
+  const Size size = FeatureLayout::cells(feature, channels, format_);
   Rect valid(0, 0, size.width, size.height);
+  if (format_.layout == FeatureFormat::PLANAR) {
+    FeatureLayout::planes(feature, channels, featurevec);
+    const Rect interior(format_.pad.width, format_.pad.height, size.width, size.height);
+    for (size_t c = 0; c < channels; ++c) featurevec[c] = featurevec[c](interior);
+  } else {
+    split(feature.reshape(channels), featurevec);
+  }
 
   // for each channel, convolve
   Mat temp = Mat::zeros(size_, type_);
@@ -85,6 +109,9 @@ void FourierConvolutionEngine::convolve(const Mat& feature, vectorMat& filter, M
  * the feature map. Parts are support vector machines (SVMs) represented as filters.
  * The convolution of a filter with a feature produces a probability density function
  * (pdf) of part location
+ *
+ * Each (level, filter) pair is a task on the global TaskScheduler
+ *
  * @param features the input features (at different scales, and by extension, size)
  * @param responses the vector of responses (pdfs) to return
  */
@@ -95,17 +122,61 @@ void FourierConvolutionEngine::pdf(const vectorMat& features, vector2DMat& respo
   const size_t N = filters_.size();
   responses.resize(M, vectorMat(N));
 
-  // iterate
-#ifdef _OPENMP
-  #pragma omp parallel for
-#endif
-  for (size_t n = 0; n < N; ++n) {
-    for (size_t m = 0; m < M; ++m) {
-      Mat response;
-      convolve(features[m], filters_[n], response, flen_);
-      responses[m][n] = response;
-    }
-  }
+  // every transform is the same size, so the tasks have equal cost
+  TaskScheduler::global().parallelFor(M*N, boost::bind(&FourierConvolutionEngine::compute, this, boost::cref(features), boost::ref(responses), _1));
+}
+
+/*! @brief compute a single response of the pdf
+ *
+ * @param features the input features
+ * @param responses the responses to write into
+ * @param mn the index of the (level, filter) pair
+ */
+void FourierConvolutionEngine::compute(const vectorMat& features, vector2DMat& responses, size_t mn) {
+  const size_t N = filters_.size();
+  const size_t m = mn / N;
+  const size_t n = mn % N;
+  Mat response;
+  convolve(features[m], filters_[n], response, flen_);
+  responses[m][n] = response;
+}
+
+/*! @brief bind a pyramid of features for on-demand responses
+ *
+ * @param features the input features
+ */
+void FourierConvolutionEngine::bind(const vectorMat& features) {
+  bound_ = &features;
+}
+
+/*! @brief prepare a level of the bound pyramid
+ *
+ * Each channel is transformed along with its filter, so there is no
+ * per-level work
+ *
+ * @param m the level
+ */
+void FourierConvolutionEngine::prepare(size_t m) {
+}
+
+/*! @brief compute the response of a single filter at a prepared level
+ *
+ * @param m the level
+ * @param n the filter
+ * @param response the response to return
+ */
+void FourierConvolutionEngine::response(size_t m, size_t n, Mat& response) {
+  convolve((*bound_)[m], filters_[n], response, flen_);
+}
+
+//! the size of the responses at level m of the bound pyramid
+Size FourierConvolutionEngine::responseSize(size_t m) const {
+  return FeatureLayout::cells((*bound_)[m], flen_, format_);
+}
+
+//! release the bound pyramid
+void FourierConvolutionEngine::release(void) {
+  bound_ = NULL;
 }
 
 /*! @brief set the filters
@@ -135,5 +206,6 @@ void FourierConvolutionEngine::setFilters(const vectorMat& filters) {
       filtervec[c].copyTo(corner);
       dft(padded, filtervec[c], 0, filtervec[c].rows);
     }
+    filters_[n] = filtervec;
   }
 }
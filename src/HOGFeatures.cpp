@@ -43,10 +43,21 @@
 inline double round(double x) { return (x > 0.0) ? floor(x + 0.5) : ceil(x - 0.5); }
 #endif
 #include <cassert>
+#include <boost/bind.hpp>
+#include "CpuDispatch.hpp"
 #include "HOGFeatures.hpp"
+#include "TaskScheduler.hpp"
 using namespace std;
 using namespace cv;
 
+// the dispatched orientation snapping of a row of gradients
+static inline void orientations(const CpuDispatch::Kernels& k, const float* dx, const float* dy, const float* uu, const float* vv, int half, int n, float* best, int* orient) {
+	k.orientf(dx, dy, uu, vv, half, n, best, orient);
+}
+static inline void orientations(const CpuDispatch::Kernels& k, const double* dx, const double* dy, const double* uu, const double* vv, int half, int n, double* best, int* orient) {
+	k.orientd(dx, dy, uu, vv, half, n, best, orient);
+}
+
 // declare all possible types of specialization (this is kinda sacrilege, but it's all we'll ever need...)
 template class HOGFeatures<float>;
 template class HOGFeatures<double>;
@@ -54,6 +65,9 @@ template class HOGFeatures<double>;
 template<typename T>
 static inline T square(const T& x) { return x * x; }
 
+//! the target working set of a band of rows of features()
+static const size_t kBandBytes = 256 * 1024;
+
 /*! @brief add ones to the final padded pixel in each 3D feature map
  *
  * @param feature the feature map
@@ -85,7 +99,8 @@ void HOGFeatures<T>::boundaryOcclusionFeature(Mat& feature, const int flen, cons
  * then progressively downsampled to coarser spatial
  * resolutions
  *
- * This function supports multithreading via OpenMP
+ * This function is multithreaded via the global TaskScheduler. The
+ * largest levels are scheduled first
  *
  * @param im the input image at native resolution
  * @param pyrafeatures the pyramid of features, fine to coarse, each
@@ -93,61 +108,159 @@ void HOGFeatures<T>::boundaryOcclusionFeature(Mat& feature, const int flen, cons
  */
 template<typename T>
 void HOGFeatures<T>::pyramid(const Mat& im, vectorMat& pyrafeatures) {
+	const size_t nscales = scales(im.size()).size();
+	vectori levels(nscales);
+	for (size_t n = 0; n < nscales; ++n) levels[n] = n;
+	pyramid(im, levels, pyrafeatures);
+}
+
+/*! @brief Calculate features at a subset of the scales of the pyramid
+ *
+ * Each requested level is computed exactly as it would be by the full
+ * pyramid(), but levels which are not requested (and any power of two
+ * downsamplings beyond the coarsest requested level of each chain)
+ * are skipped
+ *
+ * @param im the input image at native resolution
+ * @param levels the indices of the levels to compute
+ * @param pyrafeatures the features of the requested levels, in the order requested
+ */
+template<typename T>
+void HOGFeatures<T>::pyramid(const Mat& im, const vectori& levels, vectorMat& pyrafeatures) {
+	PyramidChains chains;
+	pyramid(im, levels, pyrafeatures, chains);
+}
+
+/*! @brief Calculate features at a subset of the scales of the pyramid, continuing the chains of an earlier subset
+ *
+ * @param im the input image at native resolution
+ * @param levels the indices of the levels to compute
+ * @param pyrafeatures the features of the requested levels, in the order requested
+ * @param chains the last image of each chain, updated for the next subset
+ */
+template<typename T>
+void HOGFeatures<T>::pyramid(const Mat& im, const vectori& levels, vectorMat& pyrafeatures, PyramidChains& chains) {
 
 	// calculate the scaling factor
-	Size_<float> imsize = im.size();
-	nscales_  = 1 + floor(log(min(imsize.height, imsize.width)/(5.0f*(float)binsize_))/log(sfactor_));
+	scales_  = scales(im.size());
+	nscales_ = scales_.size();
+
+	// the output slot of each level, or -1 if it was not requested
+	const size_t L = levels.size();
+	vectori slot(nscales_, -1);
+	for (size_t l = 0; l < L; ++l) slot[levels[l]] = l;
 
-	vectorMat pyraimages;
-	pyraimages.resize(nscales_);
+	vectorMat pyraimages(L);
 	pyrafeatures.clear();
-	pyrafeatures.resize(nscales_);
-	pyraimages.resize(nscales_);
-	scales_.clear();
-	scales_.resize(nscales_);
+	pyrafeatures.resize(L);
 
 	// perform the non-power of two scaling
 	// TODO: is this the most intuitive way to represent scaling?
-	#ifdef _OPENMP
-	#pragma omp parallel for
-	#endif
-	for (size_t i = 0; i < interval_; ++i) {
-		Mat scaled;
-		resize(im, scaled, imsize * (1.0f/pow(sfactor_,(int)i)));
-		pyraimages[i] = scaled;
-		scales_[i] = pow(sfactor_,(int)i)*binsize_;
-		// perform subsequent power of two scaling
-		for (size_t j = i+interval_; j < nscales_; j+=interval_) {
-			Mat scaled2;
-			pyrDown(scaled, scaled2);
-			pyraimages[j] = scaled2;
-			scales_[j] = 2 * scales_[j-interval_];
-			scaled2.copyTo(scaled);
-		}
+	TaskScheduler& scheduler = TaskScheduler::global();
+	vector<double> costs(interval_);
+	for (size_t i = 0; i < interval_; ++i) costs[i] = 1.0 / pow(sfactor_, 2*(int)i);
+	if (chains.levels.size() != interval_) {
+		chains.images.assign(interval_, Mat());
+		chains.levels.assign(interval_, -1);
 	}
+	scheduler.parallelFor(interval_, boost::bind(&HOGFeatures<T>::scaleChain, this, boost::cref(im), _1, boost::cref(slot), boost::ref(pyraimages), &chains), costs);
 
 	// perform the actual feature computation, in parallel if possible
-	#ifdef _OPENMP
-	#pragma omp parallel for
-	#endif
-	for (size_t n = 0; n < nscales_; ++n) {
-		Mat feature;
-		Mat padded;
-		switch (im.depth()) {
-			case CV_32F: features<float>(pyraimages[n], feature); break;
-			case CV_64F: features<double>(pyraimages[n], feature); break;
-			case CV_8U:  features<uint8_t>(pyraimages[n], feature); break;
-			case CV_16U: features<uint16_t>(pyraimages[n], feature); break;
+	costs.resize(L);
+	for (size_t l = 0; l < L; ++l) costs[l] = pyraimages[l].total();
+	scheduler.parallelFor(L, boost::bind(&HOGFeatures<T>::levelFeatures, this, im.depth(), boost::cref(pyraimages), boost::ref(pyrafeatures), _1), costs);
+}
+
+/*! @brief the scales of the pyramid for an image of a given size
+ *
+ * @param imsize the size of the input image
+ * @return the scales (in pixels per cell) of each level, fine to coarse
+ */
+template<typename T>
+vectorf HOGFeatures<T>::scales(const Size& imsize) const {
+	const size_t nscales = 1 + floor(log(min(imsize.height, imsize.width)/(5.0f*(float)binsize_))/log(sfactor_));
+	vectorf scales(nscales);
+	for (size_t j = 0; j < nscales; ++j) {
+		scales[j] = (j < interval_) ? pow(sfactor_,(int)j)*binsize_ : 2 * scales[j-interval_];
+	}
+	return scales;
+}
+
+/*! @brief compute the images of one chain of the pyramid
+ *
+ * Chain i consists of the image resized by a non-power of two factor,
+ * followed by successive power of two downsamplings of that image. If
+ * the chain was left at a level above the requested levels by an earlier
+ * call, it continues from there instead
+ *
+ * @param im the input image at native resolution
+ * @param i the chain to compute, in [0, interval_)
+ * @param slot the output slot of each level, or -1 if the level is not required
+ * @param pyraimages the images of the requested levels
+ * @param chains the last image of each chain
+ */
+template<typename T>
+void HOGFeatures<T>::scaleChain(const Mat& im, size_t i, const vectori& slot, vectorMat& pyraimages, PyramidChains* chains) {
+
+	// find the finest and coarsest requested levels of the chain
+	int first = -1, last = -1;
+	for (size_t j = i; j < nscales_; j+=interval_) {
+		if (slot[j] < 0) continue;
+		if (first < 0) first = j;
+		last = j;
+	}
+	if (last < 0) return;
+
+	Mat scaled;
+	size_t j = i;
+	if (chains->levels[i] >= 0 && chains->levels[i] <= first) {
+		// continue down the chain
+		scaled = chains->images[i];
+		j = chains->levels[i];
+	} else if (i == 0) {
+		// the native scale reads the image in place, which may be a view into a larger frame
+		scaled = im;
+	} else {
+		Size_<float> imsize = im.size();
+		resize(im, scaled, imsize * (1.0f/pow(sfactor_,(int)i)));
+	}
+
+	// perform subsequent power of two scaling
+	for (; ; j+=interval_) {
+		if (slot[j] >= 0) pyraimages[slot[j]] = scaled;
+		if ((int)j == last) break;
+		Mat scaled2;
+		pyrDown(scaled, scaled2);
+		scaled = scaled2;
+	}
+	chains->images[i] = scaled;
+	chains->levels[i] = last;
+}
+
+/*! @brief compute the features of a single level of the pyramid
+ *
+ * @param depth the depth of the input image
+ * @param pyraimages the images of the pyramid
+ * @param pyrafeatures the features of the pyramid
+ * @param n the level to compute
+ */
+template<typename T>
+void HOGFeatures<T>::levelFeatures(int depth, const vectorMat& pyraimages, vectorMat& pyrafeatures, size_t n) const {
+	Mat feature;
+	switch (depth) {
+		case CV_32F: features<float>(pyraimages[n], feature); break;
+		case CV_64F: features<double>(pyraimages[n], feature); break;
+		case CV_8U:  features<uint8_t>(pyraimages[n], feature); break;
+		case CV_16U: features<uint16_t>(pyraimages[n], feature); break;
 #if (CV_MAJOR_VERSION < 3)
-			default: CV_Error(CV_StsUnsupportedFormat, "Unsupported image type"); break;
+		default: CV_Error(CV_StsUnsupportedFormat, "Unsupported image type"); break;
 #else
-			default: CV_Error(cv::Error::StsUnsupportedFormat, "Unsupported image type"); break;
+		default: CV_Error(cv::Error::StsUnsupportedFormat, "Unsupported image type"); break;
 #endif
-		}
-		//copyMakeBorder(feature, padded, 3, 3, 3*flen_, 3*flen_, BORDER_CONSTANT, 0);
-		//boundaryOcclusionFeature(padded, flen_, 3);
-		pyrafeatures[n] = feature;
 	}
+	//copyMakeBorder(feature, padded, 3, 3, 3*flen_, 3*flen_, BORDER_CONSTANT, 0);
+	//boundaryOcclusionFeature(padded, flen_, 3);
+	pyrafeatures[n] = feature;
 }
 
 /*! @brief compute the HOG features for an image
@@ -157,36 +270,118 @@ void HOGFeatures<T>::pyramid(const Mat& im, vectorMat& pyrafeatures) {
  * 3D matrix (i,j,k) that has been flattened to a 2D (i,j*k) matrix
  * for faster processing. The (i,j) dimensions represent the resultant
  * spatial size of the response (ie im.size() / binsize_) and the
- * (k) dimension represents the histogram weights (length flen_)
+ * (k) dimension represents the histogram weights (length flen_).
+ * If the format is PLANAR, the (k) dimension is instead stacked as
+ * padded (i,j) planes (see FeatureFormat)
  *
- * The function supports multithreading via OpenMP
+ * The standard configurations (binsize 4 or 8, 18 orientations and
+ * 32 features per cell) are computed by specializations with the
+ * configuration fixed at compile time
  *
  * @param imm the input image (must be color of type CV_8UC3)
  * @param featm the HOG features as a 2D matrix
  */
 template<typename T> template<typename IT>
 void HOGFeatures<T>::features(const Mat& imm, Mat& featm) const {
+	if (norient_ == 18 && flen_ == 32) {
+		if (binsize_ == 8) { features<IT, 8, 18>(imm, featm); return; }
+		if (binsize_ == 4) { features<IT, 4, 18>(imm, featm); return; }
+	}
+	features<IT, 0, 0>(imm, featm);
+}
+
+/*! @brief compute the HOG features for an image, for a given configuration
+ *
+ * SBIN and NORIENT fix the binsize and number of orientations at compile
+ * time, so the orientation loops can be unrolled and the strides folded.
+ * If they are zero, the runtime binsize_, norient_ and flen_ are used
+ *
+ * The image is processed in bands of block rows sized to stay in cache,
+ * in parallel on the global TaskScheduler. The first pass fuses the
+ * gradient histograms with the block energies, the second fuses the
+ * block normalization with the feature computation. The result is
+ * identical to processing the image as a single band
+ *
+ * @param imm the input image (must be color of type CV_8UC3)
+ * @param featm the HOG features as a 2D matrix
+ */
+template<typename T> template<typename IT, int SBIN, int NORIENT>
+void HOGFeatures<T>::features(const Mat& imm, Mat& featm) const {
+
+	// the configuration, constant if specialized
+	const size_t binsize = SBIN    ? SBIN : binsize_;
+	const size_t norient = NORIENT ? NORIENT : norient_;
+	const size_t flen    = NORIENT ? NORIENT + NORIENT/2 + 5 : flen_;
 
 	// compute the size of the output matrix
 	assert(imm.channels() == 1 || imm.channels() == 3);
-	bool color  = (imm.channels() == 3);
 	const Size imsize = imm.size();
-	const Size blocks = Size(round((float)imsize.width / (float)binsize_), round((float)imsize.height / (float)binsize_));
+	const Size blocks = Size(round((float)imsize.width / (float)binsize), round((float)imsize.height / (float)binsize));
 	const Size outsize = Size(max(blocks.width-2, 0), max(blocks.height-2, 0));
-	const Size visible = blocks*(int)binsize_;
 
-	Mat histm = Mat::zeros(Size(blocks.width*norient_, blocks.height),  DataType<T>::type);
+	Mat histm = Mat::zeros(Size(blocks.width*norient, blocks.height),  DataType<T>::type);
 	Mat normm = Mat::zeros(Size(blocks.width,          blocks.height),  DataType<T>::type);
-	featm     = Mat::zeros(Size(outsize.width*flen_,   outsize.height), DataType<T>::type);
+	if (format_.layout == FeatureFormat::PLANAR) {
+		// padded channel planes, with the occlusion channel padded with ones
+		const Size padded = outsize + format_.pad*2;
+		featm.create(flen*padded.height, padded.width, DataType<T>::type);
+		featm.setTo(Scalar::all(0));
+		featm.rowRange((flen-1)*padded.height, flen*padded.height).setTo(Scalar::all(1));
+	} else {
+		featm = Mat::zeros(Size(outsize.width*flen, outsize.height), DataType<T>::type);
+	}
+	if (blocks.height < 1 || blocks.width < 1) return;
+
+	// size the bands so the image rows and histograms of a band stay in cache
+	const size_t band_bytes = binsize*(size_t)imm.step + (size_t)histm.step + (size_t)normm.step;
+	const size_t band_rows  = max(kBandBytes / band_bytes, (size_t)1);
+	TaskScheduler& scheduler = TaskScheduler::global();
+	vector<size_t> bounds;
+
+	// histograms and block energies
+	TaskScheduler::bands(blocks.height, 1, (blocks.height + band_rows-1) / band_rows, bounds);
+	scheduler.parallelFor(bounds.size()-1, boost::bind(&HOGFeatures<T>::histogramBand<IT, SBIN, NORIENT>,
+			this, boost::cref(imm), boost::ref(histm), boost::ref(normm), boost::cref(bounds), _1));
+
+	// normalized features
+	if (outsize.height < 1 || outsize.width < 1) return;
+	TaskScheduler::bands(outsize.height, 1, (outsize.height + band_rows-1) / band_rows, bounds);
+	scheduler.parallelFor(bounds.size()-1, boost::bind(&HOGFeatures<T>::normalizeBand<NORIENT>,
+			this, boost::cref(histm), boost::cref(normm), boost::ref(featm), boost::cref(bounds), _1));
+}
+
+/*! @brief compute the gradient histograms and energies of a band of block rows
+ *
+ * Each pixel row is bilinearly interpolated into the two block rows around
+ * it, so the pixel rows on the edges of the band are visited by both of the
+ * bands they straddle, each keeping only the contributions to its own block
+ * rows. The contributions to each block are accumulated in the same order
+ * as a single band would accumulate them
+ *
+ * @param imm the input image
+ * @param histm the orientation histogram of each block
+ * @param normm the energy of each block
+ * @param bounds the bounds of the bands of block rows
+ * @param b the band to compute
+ */
+template<typename T> template<typename IT, int SBIN, int NORIENT>
+void HOGFeatures<T>::histogramBand(const Mat& imm, Mat& histm, Mat& normm, const vector<size_t>& bounds, size_t b) const {
+
+	// the configuration, constant if specialized
+	const size_t binsize = SBIN    ? SBIN : binsize_;
+	const size_t norient = NORIENT ? NORIENT : norient_;
+	const int half = norient/2;
+
+	const bool color = (imm.channels() == 3);
+	const Size blocks(histm.cols / norient, histm.rows);
+	const Size visible = blocks*(int)binsize;
+	const int b0 = bounds[b];
+	const int b1 = bounds[b+1];
 
 	// get the stride of each of the matrices
 	const size_t imstride   = imm.step1();
 	const size_t histstride = histm.step1();
 	const size_t normstride = normm.step1();
-	const size_t featstride = featm.step1();
-
-	// epsilon to avoid division by zero
-	const double eps = 0.0001;
 
 	// unit vectors to compute gradient orientation
 	const T uu[9] = {1.000, 0.9397, 0.7660, 0.5000, 0.1736, -0.1736, -0.5000, -0.7660, -0.9397};
@@ -196,16 +391,35 @@ void HOGFeatures<T>::features(const Mat& imm, Mat& featm) const {
 	const IT* im  = imm.ptr<IT>(0);
 	T* const hist = histm.ptr<T>(0);
 	T* const norm = normm.ptr<T>(0);
-	T* const feat = featm.ptr<T>(0);
 
-	// TODO: source image may not be continuous!
-	for (size_t y = 1; y < (size_t)visible.height-1; ++y) {
+	// per-row gradients and orientations. The gradients are gathered first,
+	// then snapped to orientations in one vectorized pass across the row
+	const CpuDispatch::Kernels& kernels = CpuDispatch::kernels();
+	const int width = max(visible.width-2, 0);
+	vector<T> dxr(width), dyr(width), vr(width), best(width);
+	vector<int> orient(width);
+
+	// the pixel rows which contribute to the block rows [b0, b1)
+	const int ystart = max((b0-1)*(int)binsize, 1);
+	const int ystop  = min((b1+1)*(int)binsize, visible.height-1);
+
+	// rows are addressed through the image stride, so the image need not be
+	// continuous (it may be a region of interest of a larger frame)
+	for (int y = ystart; y < ystop; ++y) {
+		T yp = ((T)y+0.5)/(T)binsize - 0.5;
+		int iyp = (int)floor(yp);
+		if (iyp+1 < b0 || iyp >= b1) continue;
+		T vy0 = yp-iyp;
+		T vy1 = 1.0-vy0;
+		const bool top    = iyp >= b0;
+		const bool bottom = iyp+1 < b1;
+
 		for (size_t x = 1; x < (size_t)visible.width-1; ++x) {
 			T dx, dy, v;
 
 			// grayscale image
 			if (!color) {
-				const IT* s = im + min(x, (size_t)imm.cols-2) + min(y, (size_t)imm.rows-2)*imstride;
+				const IT* s = im + min(x, (size_t)imm.cols-2) + min((size_t)y, (size_t)imm.rows-2)*imstride;
 				dy = *(s+imstride) - *(s-imstride);
 				dx = *(s+1) - *(s-1);
 				 v = dx*dx + dy*dy;
@@ -215,7 +429,7 @@ void HOGFeatures<T>::features(const Mat& imm, Mat& featm) const {
 			// OpenCV uses an interleaved format: BGR-BGR-BGR
 			// Matlab uses a planar format:       RRR-GGG-BBB
 			if (color) {
-				const IT* s = im + 3 * min(x, (size_t)imm.cols-2) + min(y, (size_t)imm.rows-2)*imstride;
+				const IT* s = im + 3 * min(x, (size_t)imm.cols-2) + min((size_t)y, (size_t)imm.rows-2)*imstride;
 
 				// blue image channel
 				T dyb = *(s+imstride) - *(s-imstride);
@@ -238,77 +452,110 @@ void HOGFeatures<T>::features(const Mat& imm, Mat& featm) const {
 				if (vg > v) { v = vg; dx = dxg; dy = dyg; }
 				if (vb > v) { v = vb; dx = dxb; dy = dyb; }
 			}
+			dxr[x-1] = dx;
+			dyr[x-1] = dy;
+			 vr[x-1] = v;
+		}
 
-			// snap to one of 18 orientations
-			T best_dot = 0;
-			size_t best_o = 0;
-			for (size_t o = 0; o < norient_/2; ++o) {
-				T dot = uu[o]*dx + vv[o]*dy;
-				if (dot > best_dot) { best_dot = dot; best_o = o; }
-				else if (-dot > best_dot) { best_dot = -dot; best_o = o+norient_/2; }
-			}
+		// snap to one of 18 orientations
+		if (width > 0) orientations(kernels, &dxr[0], &dyr[0], uu, vv, half, width, &best[0], &orient[0]);
+
+		for (size_t x = 1; x < (size_t)visible.width-1; ++x) {
+			const size_t best_o = orient[x-1];
 
 			// add to 4 histograms around pixel using linear interpolation
-			T yp = ((T)y+0.5)/(T)binsize_ - 0.5;
-			T xp = ((T)x+0.5)/(T)binsize_ - 0.5;
-			int iyp = (int)floor(yp);
+			T xp = ((T)x+0.5)/(T)binsize - 0.5;
 			int ixp = (int)floor(xp);
-			T vy0 = yp-iyp;
 			T vx0 = xp-ixp;
-			T vy1 = 1.0-vy0;
 			T vx1 = 1.0-vx0;
-			v = sqrt(v);
+			T v = sqrt(vr[x-1]);
 
-			if (iyp >= 0 && ixp >= 0) 							*(hist + iyp*histstride + ixp*norient_ + best_o) += vy1*vx1*v;
-			if (iyp >= 0 && ixp+1 < blocks.width) 				*(hist + iyp*histstride + (ixp+1)*norient_ + best_o) += vx0*vy1*v;
-			if (iyp+1 < blocks.height && ixp >= 0) 				*(hist + (iyp+1)*histstride + ixp*norient_ + best_o) += vy0*vx1*v;
-			if (iyp+1 < blocks.height && ixp+1 < blocks.width)	*(hist + (iyp+1)*histstride + (ixp+1)*norient_ + best_o) += vy0*vx0*v;
+			if (top && ixp >= 0) 							*(hist + iyp*histstride + ixp*norient + best_o) += vy1*vx1*v;
+			if (top && ixp+1 < blocks.width) 				*(hist + iyp*histstride + (ixp+1)*norient + best_o) += vx0*vy1*v;
+			if (bottom && ixp >= 0) 						*(hist + (iyp+1)*histstride + ixp*norient + best_o) += vy0*vx1*v;
+			if (bottom && ixp+1 < blocks.width)				*(hist + (iyp+1)*histstride + (ixp+1)*norient + best_o) += vy0*vx0*v;
 		}
 	}
 
 	// compute the energy in each block by summing over orientations
-	for (size_t y = 0; y < (size_t)blocks.height; ++y) {
+	for (int y = b0; y < b1; ++y) {
 		const T* src = hist + y*histstride;
 		T* dst = norm + y*normstride;
 		T const * const dst_end = dst + blocks.width;
 		while (dst < dst_end) {
 			*dst = 0;
-			for (size_t o = 0; o < norient_/2; ++o) {
-				*dst += square( *src + *(src+norient_/2) );
+			for (int o = 0; o < half; ++o) {
+				*dst += square( *src + *(src+half) );
 				src++;
 			}
 			dst++;
-			src += norient_/2;
+			src += half;
 		}
 	}
+}
 
-	// compute the features
-	for (size_t y = 0; y < (size_t)outsize.height; ++y) {
-		for (size_t x = 0; x < (size_t)outsize.width; ++x) {
-			T* dst = feat + y*featstride + x*flen_;
-			T* p, n1, n2, n3, n4;
-			const T* src;
+/*! @brief compute the normalized features of a band of output rows
+ *
+ * Each 2x2 block norm is shared by the four cells around it, so the norms
+ * are computed once per block row and rolled down the band
+ *
+ * @param histm the orientation histogram of each block
+ * @param normm the energy of each block
+ * @param featm the HOG features
+ * @param bounds the bounds of the bands of output rows
+ * @param b the band to compute
+ */
+template<typename T> template<int NORIENT>
+void HOGFeatures<T>::normalizeBand(const Mat& histm, const Mat& normm, Mat& featm, const vector<size_t>& bounds, size_t b) const {
+
+	// the configuration, constant if specialized
+	const size_t norient = NORIENT ? NORIENT : norient_;
+	const size_t flen    = NORIENT ? NORIENT + NORIENT/2 + 5 : flen_;
 
-			p  = norm + (y+1)*normstride + (x+1);
-			n1 = 1.0f / sqrt(*p + *(p+1) + *(p+normstride) + *(p+normstride+1) + eps);
-			p  = norm + y*normstride + (x+1);
-			n2 = 1.0f / sqrt(*p + *(p+1) + *(p+normstride) + *(p+normstride+1) + eps);
-			p  = norm + (y+1)*normstride + x;
-			n3 = 1.0f / sqrt(*p + *(p+1) + *(p+normstride) + *(p+normstride+1) + eps);
-			p  = norm + y*normstride + x;
-			n4 = 1.0f / sqrt(*p + *(p+1) + *(p+normstride) + *(p+normstride+1) + eps);
+	const size_t histstride = histm.step1();
+	const size_t normstride = normm.step1();
+	// the strides between rows, cells and channels of the output
+	const Size cells = FeatureLayout::cells(featm, flen, format_);
+	const bool planar = format_.layout == FeatureFormat::PLANAR;
+	const size_t width = cells.width;
+	const size_t featstride = featm.step1();
+	const size_t cellstride = planar ? 1 : flen;
+	const size_t chanstride = planar ? featstride * (cells.height + 2*format_.pad.height) : 1;
+
+	// epsilon to avoid division by zero
+	const double eps = 0.0001;
+
+	const T* const hist = histm.ptr<T>(0);
+	const T* const norm = normm.ptr<T>(0);
+	T* const feat = planar ? featm.ptr<T>(format_.pad.height) + format_.pad.width : featm.ptr<T>(0);
+
+	// the inverse 2x2 block norms of the current and next block rows
+	vector<T> above(width+1), below(width+1);
+	T* n0 = &above[0];
+	T* n1 = &below[0];
+	blockNorms(norm, normstride, bounds[b], width+1, eps, n0);
+
+	for (size_t y = bounds[b]; y < bounds[b+1]; ++y) {
+		blockNorms(norm, normstride, y+1, width+1, eps, n1);
+		for (size_t x = 0; x < width; ++x) {
+			T* dst = feat + y*featstride + x*cellstride;
+			const T* src;
+			const T nrm1 = n1[x+1];
+			const T nrm2 = n0[x+1];
+			const T nrm3 = n1[x];
+			const T nrm4 = n0[x];
 
 			T t1 = 0, t2 = 0, t3 = 0, t4 = 0;
 
 			// contrast-sensitive features
-			src = hist + (y+1)*histstride + (x+1)*norient_;
-			for (size_t o = 0; o < norient_; ++o) {
+			src = hist + (y+1)*histstride + (x+1)*norient;
+			for (size_t o = 0; o < norient; ++o) {
 				T val = *src;
-				T h1 = min(val * n1, (T)0.2);
-				T h2 = min(val * n2, (T)0.2);
-				T h3 = min(val * n3, (T)0.2);
-				T h4 = min(val * n4, (T)0.2);
-				*(dst++) = 0.5 * (h1 + h2 + h3 + h4);
+				T h1 = min(val * nrm1, (T)0.2);
+				T h2 = min(val * nrm2, (T)0.2);
+				T h3 = min(val * nrm3, (T)0.2);
+				T h4 = min(val * nrm4, (T)0.2);
+				*dst = 0.5 * (h1 + h2 + h3 + h4); dst += chanstride;
 				src++;
 				t1 += h1;
 				t2 += h2;
@@ -317,26 +564,43 @@ void HOGFeatures<T>::features(const Mat& imm, Mat& featm) const {
 			}
 
 			// contrast-insensitive features
-			src = hist + (y+1)*histstride + (x+1)*norient_;
-			for (size_t o = 0; o < norient_/2; ++o) {
-				T sum = *src + *(src+norient_/2);
-				T h1 = min(sum * n1, (T)0.2);
-				T h2 = min(sum * n2, (T)0.2);
-				T h3 = min(sum * n3, (T)0.2);
-				T h4 = min(sum * n4, (T)0.2);
-				*(dst++) = 0.5 * (h1 + h2 + h3 + h4);
+			src = hist + (y+1)*histstride + (x+1)*norient;
+			for (size_t o = 0; o < norient/2; ++o) {
+				T sum = *src + *(src+norient/2);
+				T h1 = min(sum * nrm1, (T)0.2);
+				T h2 = min(sum * nrm2, (T)0.2);
+				T h3 = min(sum * nrm3, (T)0.2);
+				T h4 = min(sum * nrm4, (T)0.2);
+				*dst = 0.5 * (h1 + h2 + h3 + h4); dst += chanstride;
 				src++;
 			}
 
 			//texture features
-			*(dst++) = 0.2357 * t1;
-			*(dst++) = 0.2357 * t2;
-			*(dst++) = 0.2357 * t3;
-			*(dst++) = 0.2357 * t4;
+			*dst = 0.2357 * t1; dst += chanstride;
+			*dst = 0.2357 * t2; dst += chanstride;
+			*dst = 0.2357 * t3; dst += chanstride;
+			*dst = 0.2357 * t4; dst += chanstride;
 
 			// truncation feature
 			*dst = 0;
 		}
+		swap(n0, n1);
 	}
 }
 
+/*! @brief compute the inverse norms of a row of 2x2 blocks
+ *
+ * @param norm the energy of each block
+ * @param normstride the stride of the energies
+ * @param y the top block row
+ * @param N the number of 2x2 blocks
+ * @param eps epsilon to avoid division by zero
+ * @param dst the inverse norms
+ */
+template<typename T>
+void HOGFeatures<T>::blockNorms(const T* norm, size_t normstride, size_t y, size_t N, double eps, T* dst) {
+	const T* p = norm + y*normstride;
+	for (size_t x = 0; x < N; ++x, ++p) {
+		dst[x] = 1.0f / sqrt(*p + *(p+1) + *(p+normstride) + *(p+normstride+1) + eps);
+	}
+}
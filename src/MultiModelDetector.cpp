@@ -0,0 +1,155 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    MultiModelDetector.cpp
+ *  Created: Oct 16, 2026
+ */
+
+#include "MultiModelDetector.hpp"
+#include "HOGFeatures.hpp"
+using namespace cv;
+using namespace std;
+
+/*! @brief add a model to the detector
+ *
+ * The model joins the feature group with a matching configuration, or starts
+ * a new one. Its filters are appended to the group's filters, which are given
+ * to the group's convolution engine before the next detection
+ *
+ * @param model the model. Its filters are converted to the detector precision
+ */
+template<typename T>
+void MultiModelDetector<T>::addModel(Model& model) {
+
+	// make sure the filters are of the correct precision
+	const size_t nfilters = model.filters().size();
+	for (size_t n = 0; n < nfilters; ++n) {
+		model.filters()[n].convertTo(model.filters()[n], DataType<T>::type);
+	}
+
+	// find (or create) the feature group of the model
+	size_t g = 0;
+	for (; g < groups_.size(); ++g) {
+		const FeatureGroup& group = groups_[g];
+		if (group.binsize == model.binsize() && group.nscales == model.nscales() &&
+			group.flen == model.flen() && group.norient == model.norient()) break;
+	}
+	if (g == groups_.size()) {
+		FeatureGroup group;
+		group.binsize = model.binsize();
+		group.nscales = model.nscales();
+		group.flen    = model.flen();
+		group.norient = model.norient();
+		group.features.reset(new HOGFeatures<T>(model.binsize(), model.nscales(), model.flen(), model.norient()));
+		group.ready   = false;
+		groups_.push_back(group);
+	}
+	FeatureGroup& group = groups_[g];
+
+	// append the model's filters to the group
+	ModelEntry entry;
+	entry.name     = model.name();
+	entry.group    = g;
+	entry.offset   = group.filters.size();
+	entry.nfilters = nfilters;
+	entry.parts    = Parts(model.filters(), model.filtersi(), model.def(), model.defi(), model.bias(), model.biasi(),
+			model.anchors(), model.biasid(), model.filterid(), model.defid(), model.parentid());
+	entry.dp       = DynamicProgram<T>(model.thresh(), entry.parts);
+	group.filters.insert(group.filters.end(), model.filters().begin(), model.filters().end());
+	group.ready = false;
+	group.models.push_back(models_.size());
+	models_.push_back(entry);
+}
+
+/*! @brief give a group's filters to a new convolution engine
+ *
+ * Called once per group before the first detection after its models change,
+ * rather than on every addModel(), which would redo the engine's setup (and
+ * relearn a sparselet dictionary) once per model
+ *
+ * @param group the feature group
+ */
+template<typename T>
+void MultiModelDetector<T>::prepare(FeatureGroup& group) {
+
+	if (group.ready) return;
+	group.engine.reset(PartsBasedDetector<T>::createEngine(convolution_type_, group.flen, separable_energy_, sparselet_dictionary_));
+	group.engine->setFilters(group.filters);
+	const FeatureFormat format = group.engine->preferredFormat();
+	group.features->setFormat(format);
+	group.engine->setFormat(format);
+	group.ready = true;
+}
+
+/*! @brief recreate the convolution engine of every group at the next detection
+ */
+template<typename T>
+void MultiModelDetector<T>::invalidate(void) {
+	for (size_t g = 0; g < groups_.size(); ++g) groups_[g].ready = false;
+}
+
+/*! @brief search an image for instances of every model
+ *
+ * @param im the input color or grayscale image
+ * @param candidates the candidates of each model above its threshold, keyed by
+ * model name (models of the same name share an entry)
+ */
+template<typename T>
+void MultiModelDetector<T>::detect(const Mat& im, map<string, vectorCandidate>& candidates) {
+
+	for (size_t g = 0; g < groups_.size(); ++g) {
+		FeatureGroup& group = groups_[g];
+		prepare(group);
+
+		// compute the pyramid once, and each response of the group at most once
+		vectorMat pyramid;
+		group.features->pyramid(im, pyramid);
+		ResponseCache pdf;
+		pdf.bind(*group.engine, pyramid);
+		const vectorf scales = group.features->scales();
+
+		for (size_t i = 0; i < group.models.size(); ++i) {
+			ModelEntry& entry = models_[group.models[i]];
+
+			// run the model's dynamic program over its window of the responses
+			pdf.setWindow(entry.offset, entry.nfilters);
+			entry.dp.min(pdf, entry.tables);
+			entry.dp.argmin(entry.tables, scales, candidates[entry.name]);
+		}
+		pdf.clear();
+	}
+}
+
+// declare all specializations of the template
+template class MultiModelDetector<float>;
+template class MultiModelDetector<double>;
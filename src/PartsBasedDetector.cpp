@@ -36,13 +36,26 @@
  *  Created: Jun 21, 2012
  */
 
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
 #include "PartsBasedDetector.hpp"
 #include "nms.hpp"
 #include "HOGFeatures.hpp"
 #include "SpatialConvolutionEngine.hpp"
+#include "QuantizedConvolutionEngine.hpp"
+#include "SeparableConvolutionEngine.hpp"
+#include "SparseletConvolutionEngine.hpp"
+#include "ConvolutionCalibration.hpp"
 using namespace cv;
 using namespace std;
 
+// the time per byte of working memory of a level assumed by the anytime search
+// before any level has been measured, on the slow side of a single core
+static const double kAnytimeSeedRate = 1e-9;
+
 /*! @brief search an image for potential candidates
  *
  * calls detect(const Mat& im, const Mat&depth=Mat(), vector<Candidate>& candidates);
@@ -61,6 +74,10 @@ void PartsBasedDetector<T>::detect(const cv::Mat& im, vectorCandidate& candidate
  * this method takes an input image, and attempts to find all instances of an object in that image.
  * The object, number of scales, detection confidence, etc are all defined through the Model.
  *
+ * If a memory budget has been set, the pyramid is processed in batches of consecutive levels,
+ * each carried through features, convolution, dynamic programming and backtracking before the
+ * next is started
+ *
  * @param im the input color or grayscale image
  * @param depth the image depth image, used for depth consistency and search space pruning
  * @param candidates the output vector of detection candidates above the threshold
@@ -68,30 +85,528 @@ void PartsBasedDetector<T>::detect(const cv::Mat& im, vectorCandidate& candidate
 template<typename T>
 void PartsBasedDetector<T>::detect(const Mat& im, const Mat& depth, vectorCandidate& candidates) {
 
+	profiler_.clear();
+
+	// group consecutive levels into batches which fit in the memory budget
+	const vectorf scales = features_->scales(im.size());
+	vector2Di batches;
+	size_t bytes = 0;
+	for (size_t n = 0; n < scales.size(); ++n) {
+		const size_t level = levelBytes(im, scales[n]);
+		if (batches.empty() || (memory_budget_ > 0 && bytes + level > memory_budget_)) {
+			batches.push_back(vectori());
+			bytes = 0;
+		}
+		batches.back().push_back(n);
+		bytes += level;
+	}
+
+	// run the pipeline over each batch, freeing its buffers before the next. Only
+	// the last image of each chain of the pyramid is kept, to continue from
+	PyramidChains chains;
+	for (size_t b = 0; b < batches.size(); ++b) {
+		detectLevels(im, batches[b], scales, chains, candidates);
+	}
+
+	if (!depth.empty()) {
+		//ssp_.filterCandidatesByDepth(parts_, candidates, depth, 0.03);
+	}
+
+}
+
+/*! @brief search an image for object candidates within a deadline
+ *
+ * An anytime variant of detect(). The cost of a level is predicted from its
+ * working memory (see levelBytes()) and a time per byte, seeded from the last
+ * anytime search (or kAnytimeSeedRate on the first) and refined by each level
+ * searched. Levels are selected in the order set by setScalePriority() while
+ * their predicted cost fits in the time left, then searched fine to coarse, so
+ * that each chain of the pyramid is resized from the image once rather than
+ * restarted whenever the priority order moves to a finer level. Before each
+ * level, the lowest priority levels still to search are dropped until the
+ * prediction of the rest fits. A level is never interrupted once started,
+ * so the deadline can be overrun by the error of the prediction
+ *
+ * @param im the input color or grayscale image
+ * @param deadline the time budget, in seconds from the call
+ * @param candidates the output vector of detection candidates above the threshold
+ * @param covered set for each level of scales(im.size()) that was searched
+ */
+template<typename T>
+void PartsBasedDetector<T>::detect(const Mat& im, double deadline, vectorCandidate& candidates, vector<bool>& covered) {
+
+	const int64_t start = getTickCount();
+	profiler_.clear();
+
+	// order the levels by distance to the nearest preferred scale
+	const vectorf scales = features_->scales(im.size());
+	const size_t nscales = scales.size();
+	vector<pair<float, int> > order(nscales);
+	for (size_t n = 0; n < nscales; ++n) {
+		float distance = -(float)n;
+		for (size_t p = 0; p < priority_.size(); ++p) {
+			const float d = fabs(log(scales[n] / priority_[p]));
+			if (p == 0 || d < distance) distance = d;
+		}
+		order[n] = make_pair(distance, (int)n);
+	}
+	stable_sort(order.begin(), order.end());
+
+	// the priority and working memory of each level
+	if (anytime_rate_ <= 0) anytime_rate_ = kAnytimeSeedRate;
+	vector<size_t> rank(nscales);
+	vector<double> bytes(nscales);
+	for (size_t o = 0; o < nscales; ++o) rank[order[o].second] = o;
+	for (size_t n = 0; n < nscales; ++n) bytes[n] = levelBytes(im, scales[n]);
+
+	// select the levels, by priority, whose predicted cost fits in the time left
+	covered.assign(nscales, false);
+	vector<bool> selected(nscales, false);
+	double planned = (double)(getTickCount() - start) / getTickFrequency();
+	for (size_t o = 0; o < nscales; ++o) {
+		const int n = order[o].second;
+		const double predicted = bytes[n] * anytime_rate_;
+		if (planned + predicted > deadline) continue;
+		selected[n] = true;
+		planned += predicted;
+	}
+
+	// search the selected levels fine to coarse, in the order of their chains
+	PyramidChains chains;
+	double searched_seconds = 0, searched_bytes = 0;
+	for (size_t n = 0; n < nscales; ++n) {
+		if (!selected[n]) continue;
+
+		// drop the lowest priority levels left until the prediction of the rest fits
+		const double elapsed = (double)(getTickCount() - start) / getTickFrequency();
+		for (;;) {
+			double predicted = 0;
+			size_t lowest = n;
+			for (size_t m = n; m < nscales; ++m) {
+				if (!selected[m]) continue;
+				predicted += bytes[m] * anytime_rate_;
+				if (rank[m] > rank[lowest]) lowest = m;
+			}
+			if (elapsed + predicted <= deadline) break;
+			selected[lowest] = false;
+			if (lowest == n) break;
+		}
+		if (!selected[n]) continue;
+
+		// search the level and refine the time per byte
+		const int64_t level_start = getTickCount();
+		detectLevels(im, vectori(1, n), scales, chains, candidates);
+		covered[n] = true;
+		searched_seconds += (double)(getTickCount() - level_start) / getTickFrequency();
+		searched_bytes   += bytes[n];
+		anytime_rate_ = searched_seconds / searched_bytes;
+	}
+}
+
+/*! @brief search regions of interest of an image for object candidates
+ *
+ * Each region is searched at every level of the pyramid of the full image,
+ * from features computed over the region grown by the support of the model:
+ * the reach of the parts from the root (filters included), their largest
+ * displacement (see setMaxDisplacement(), or a screening tile of slack if
+ * unbounded) and the border cell lost by the features. The pyramid of each
+ * region is built once, over the region grown by the margin of its coarsest
+ * level, read directly from the image without being copied. Each level is
+ * then cropped to the region grown by its own margin. Only candidates
+ * anchored within the region are kept, in full image coordinates
+ *
+ * @param im the input color or grayscale image
+ * @param rois the regions of interest, in image pixels
+ * @param candidates the output vector of detection candidates above the threshold
+ */
+template<typename T>
+void PartsBasedDetector<T>::detect(const Mat& im, const vector<Rect>& rois, vectorCandidate& candidates) {
+
+	profiler_.clear();
+	const vectorf scales = features_->scales(im.size());
+	const Rect frame(Point(0, 0), im.size());
+	const int margin = reach_ + ((displacement_ > 0) ? displacement_ : (int)screen_tile_) + 1;
+	const FeatureFormat format = convolution_engine_->preferredFormat();
+
+	for (size_t r = 0; r < rois.size(); ++r) {
+		const Rect roi = rois[r] & frame;
+		if (roi.area() == 0) continue;
+
+		// the region grown by the margin at each level which fits within it
+		vectori levels;
+		vector<Rect> regions;
+		for (size_t n = 0; n < scales.size(); ++n) {
+			const int grow = std::ceil(margin * scales[n]);
+			const Rect region = Rect(roi.x - grow, roi.y - grow, roi.width + 2*grow, roi.height + 2*grow) & frame;
+			if (features_->scales(region.size()).size() <= n) continue;
+			levels.push_back(n);
+			regions.push_back(region);
+		}
+		if (levels.empty()) continue;
+
+		// a single pyramid over the largest of the grown regions, which contains the others
+		const Rect outer = regions.back();
+		vectorMat levelfeatures;
+		profiler_.start();
+		features_->pyramid(im(outer), levels, levelfeatures);
+
+		// crop each level to the region grown by its own margin
+		vectorMat pyramid(levels.size());
+		vectorf lscales(levels.size());
+		vector<Point> offsets(levels.size());
+		for (size_t l = 0; l < levels.size(); ++l) {
+			const float scale = scales[levels[l]];
+			const Rect& region = regions[l];
+			const int x0 = std::floor((region.x - outer.x) / scale);
+			const int y0 = std::floor((region.y - outer.y) / scale);
+			const int x1 = std::ceil((region.x + region.width  - outer.x) / scale);
+			const int y1 = std::ceil((region.y + region.height - outer.y) / scale);
+			const Rect cells = Rect(x0, y0, x1 - x0, y1 - y0) & Rect(Point(0, 0), FeatureLayout::cells(levelfeatures[l], flen_, format));
+			FeatureLayout::crop(levelfeatures[l], flen_, format, cells, pyramid[l]);
+			levelfeatures[l].release();
+			lscales[l] = scale;
+			offsets[l] = Point(outer.x + cells.x * scale, outer.y + cells.y * scale);
+		}
+		profiler_.stop(DetectorStats::PYRAMID);
+
+		// keep the candidates whose root is anchored within the region
+		vectorCandidate found;
+		search(pyramid, lscales, offsets, found);
+		for (size_t i = 0; i < found.size(); ++i) {
+			if (roi.contains(found[i].parts()[0].tl())) candidates.push_back(found[i]);
+		}
+	}
+}
+
+/*! @brief run the detection pipeline over a subset of the levels of the pyramid
+ *
+ * @param im the input color or grayscale image
+ * @param levels the levels of the pyramid to search
+ * @param scales the scales of all levels of the pyramid
+ * @param chains the chains of the pyramid left by the previous levels
+ * @param candidates the vector of candidates to append to
+ */
+template<typename T>
+void PartsBasedDetector<T>::detectLevels(const Mat& im, const vectori& levels, const vectorf& scales, PyramidChains& chains, vectorCandidate& candidates) {
+
 	// calculate a feature pyramid for the new image
 	vectorMat pyramid;
-	features_->pyramid(im, pyramid);
+	profiler_.start();
+	features_->pyramid(im, levels, pyramid, chains);
+	profiler_.stop(DetectorStats::PYRAMID);
 
-	// convolve the feature pyramid with the Part experts
-	// to get probability density for each Part
-	vector2DMat pdf;
-	convolution_engine_->pdf(pyramid, pdf);
+	vectorf lscales(levels.size());
+	for (size_t l = 0; l < levels.size(); ++l) lscales[l] = scales[levels[l]];
+	search(pyramid, lscales, vector<Point>(), candidates);
+}
+
+/*! @brief run the part model over a feature pyramid
+ *
+ * @param pyramid the feature pyramid, released once the responses are computed
+ * @param scales the scale of each level of the pyramid
+ * @param offsets the offset (in image pixels) of each level within the image, if
+ * the levels are crops. Empty if they are not
+ * @param candidates the vector of candidates to append to
+ */
+template<typename T>
+void PartsBasedDetector<T>::search(vectorMat& pyramid, const vectorf& scales, const vector<Point>& offsets, vectorCandidate& candidates) {
 
-	// use dynamic programming to predict the best detection candidates from the part responses
-	vector4DMat Ix, Iy, Ik;
-	vector2DMat rootv, rooti;
-	dp_.min(parts_, pdf, Ix, Iy, Ik, rootv, rooti);
+	// bind the feature pyramid to the convolution engine. The probability
+	// density of each Part is computed the first time the dynamic program
+	// reads it, so the time the cache spent convolving is moved from DP_MIN
+	// to CONVOLUTION afterwards
+	ResponseCache pdf;
+	profiler_.start();
+	pdf.bind(*convolution_engine_, pyramid);
+	profiler_.stop(DetectorStats::CONVOLUTION);
+
+	// use dynamic programming to predict the best detection candidates from the part
+	// responses. The tables are kept between frames, so their arena is reused
+	profiler_.start();
+	dp_.min(pdf, tables_);
+	profiler_.stop(DetectorStats::DP_MIN);
+	profiler_.transfer(DetectorStats::DP_MIN, DetectorStats::CONVOLUTION, pdf.seconds());
+	pdf.clear();
+	pyramid.clear();
 
 	// suppress non-maximal candidates
 	//ssp_.nonMaxSuppression(rootv, features_->scales());
 
 	// walk back down the tree to find the part locations
-	dp_.argmin(parts_, rootv, rooti, features_->scales(), Ix, Iy, Ik, candidates);
+	profiler_.start();
+	if (offsets.empty()) {
+		dp_.argmin(tables_, scales, candidates);
+	} else {
+		// backtrack each crop separately, and move its candidates into the full level
+		for (size_t l = 0; l < scales.size(); ++l) {
+			vectorCandidate found;
+			for (size_t c = 0; c < parts_.ncomponents(); ++c) {
+				dp_.argminComponent(tables_, tables_.rootv(l, c), l, c, scales[l], found);
+			}
+			for (size_t i = 0; i < found.size(); ++i) found[i].translate(offsets[l]);
+			candidates.insert(candidates.end(), found.begin(), found.end());
+		}
+	}
+	profiler_.stop(DetectorStats::ARGMIN);
+}
 
-	if (!depth.empty()) {
-		//ssp_.filterCandidatesByDepth(parts_, candidates, depth, 0.03);
+/*! @brief search an image coarse to fine
+ *
+ * Every level of the pyramid is first screened with the root filters alone,
+ * on a grid of tiles (see setCoarseToFine()). The full part model is then
+ * only run over the bounding region of the promising tiles of each level,
+ * grown by the reach of the parts, and levels with no promising tile are
+ * skipped altogether. Since the responses are computed on demand, the part
+ * filters are never convolved outside the regions. A frame which is mostly
+ * background is searched at little more than the cost of its root filters
+ *
+ * @param im the input color or grayscale image
+ * @param candidates the output vector of detection candidates above the threshold
+ */
+template<typename T>
+void PartsBasedDetector<T>::detectCoarseToFine(const Mat& im, vectorCandidate& candidates) {
+
+	profiler_.clear();
+	const vectorf scales = features_->scales(im.size());
+	const size_t nscales = scales.size();
+	vectorMat pyramid;
+	profiler_.start();
+	features_->pyramid(im, pyramid);
+	profiler_.stop(DetectorStats::PYRAMID);
+
+	// screen each level with the root filters
+	vector<vector<Rect> > regions(nscales);
+	ResponseCache roots;
+	profiler_.start();
+	roots.bind(*convolution_engine_, pyramid);
+	TaskScheduler::global().parallelFor(nscales, boost::bind(&PartsBasedDetector<T>::screen, this, boost::ref(roots), _1, boost::ref(regions)));
+	roots.clear();
+	profiler_.stop(DetectorStats::CONVOLUTION);
+
+	// crop each region of each level which passed the screen
+	const FeatureFormat format = convolution_engine_->preferredFormat();
+	vectorMat cropped;
+	vectorf lscales;
+	vector<Point> offsets;
+	for (size_t n = 0; n < nscales; ++n) {
+		for (size_t r = 0; r < regions[n].size(); ++r) {
+			const Rect& region = regions[n][r];
+			cropped.push_back(Mat());
+			FeatureLayout::crop(pyramid[n], flen_, format, region, cropped.back());
+			lscales.push_back(scales[n]);
+			offsets.push_back(Point(region.x * scales[n], region.y * scales[n]));
+		}
+	}
+	pyramid.clear();
+
+	// run the full model within the regions
+	search(cropped, lscales, offsets, candidates);
+}
+
+/*! @brief find the K best detections of an image
+ *
+ * Rather than running the dynamic program densely over every level, a
+ * best-first branch and bound search over regions of root locations
+ * (see BranchAndBound) runs it only over the windows which can contain
+ * one of the K best detections. The result is the same as the K best
+ * candidates of detect(), before non-maximum suppression
+ *
+ * @param im the input color or grayscale image
+ * @param K the number of candidates to return
+ * @param candidates the output vector of (at most K) candidates above the threshold, best first
+ */
+template<typename T>
+void PartsBasedDetector<T>::detectTopK(const Mat& im, size_t K, vectorCandidate& candidates) {
+
+	profiler_.clear();
+	const vectorf scales = features_->scales(im.size());
+	vectorMat pyramid;
+	profiler_.start();
+	features_->pyramid(im, pyramid);
+	profiler_.stop(DetectorStats::PYRAMID);
+
+	ResponseCache pdf;
+	profiler_.start();
+	pdf.bind(*convolution_engine_, pyramid);
+	profiler_.stop(DetectorStats::CONVOLUTION);
+
+	profiler_.start();
+	bb_.search(parts_, dp_, pdf, scales, K, candidates);
+	profiler_.stop(DetectorStats::DP_MIN);
+	profiler_.transfer(DetectorStats::DP_MIN, DetectorStats::CONVOLUTION, pdf.seconds());
+	pdf.clear();
+}
+
+/*! @brief compute the dense root score maps of an image
+ *
+ * Runs the pyramid, convolutions and dynamic program as detect() does,
+ * but returns the root score of every location of every level and
+ * component rather than the candidates above the threshold. Neither the
+ * backtracking nor the construction of candidates is performed
+ *
+ * @param im the input color or grayscale image
+ * @param scores the score maps, packed into a single buffer (see DenseScores)
+ * @param projection if not NULL, the maximum of the maps over scales and
+ * components, projected into the image (see DenseScores::project())
+ */
+template<typename T>
+void PartsBasedDetector<T>::detectDense(const Mat& im, DenseScores& scores, Mat* projection) {
+
+	profiler_.clear();
+	const vectorf scales = features_->scales(im.size());
+	vectorMat pyramid;
+	profiler_.start();
+	features_->pyramid(im, pyramid);
+	profiler_.stop(DetectorStats::PYRAMID);
+
+	ResponseCache pdf;
+	profiler_.start();
+	pdf.bind(*convolution_engine_, pyramid);
+	profiler_.stop(DetectorStats::CONVOLUTION);
+
+	profiler_.start();
+	dp_.min(pdf, tables_);
+	profiler_.stop(DetectorStats::DP_MIN);
+	profiler_.transfer(DetectorStats::DP_MIN, DetectorStats::CONVOLUTION, pdf.seconds());
+	pdf.clear();
+	pyramid.clear();
+
+	// place each (level, component) map at the centre of the root box anchored at each cell
+	const DPPlan<T>& plan = dp_.plan();
+	const size_t ncomponents = plan.ncomponents();
+	vector<DenseScores::Map> maps;
+	for (size_t n = 0; n < tables_.nscales(); ++n) {
+		for (size_t c = 0; c < ncomponents; ++c) {
+			const typename DPPlan<T>::Mixture& root = plan.mixture(plan.part(c, 0), 0);
+			DenseScores::Map map;
+			map.level = n;
+			map.component = c;
+			map.scale = scales[n];
+			map.offset = Point2f((root.xsize*scales[n] - 1) / 2 - scales[n], (root.ysize*scales[n] - 1) / 2 - scales[n]);
+			map.size = tables_.size(n, c);
+			map.begin = 0;
+			maps.push_back(map);
+		}
+	}
+
+	// copy the root scores out of the tables, which are reused by the next frame
+	scores.allocate(maps, DataType<T>::type);
+	for (size_t i = 0; i < scores.size(); ++i) {
+		const DenseScores::Map& map = scores.map(i);
+		Mat dst = scores.scores(i);
+		tables_.rootv(map.level, map.component).copyTo(dst);
+	}
+	if (projection) scores.project(im.size(), *projection);
+}
+
+/*! @brief find the regions of a level worth searching with the full model
+ *
+ * Each tile which passes the screen is grown by the reach of the parts.
+ * Grown tiles which overlap or touch are merged, so separate objects give
+ * separate regions rather than one region spanning the space between them
+ *
+ * @param roots the responses of the pyramid (only the root responses are read)
+ * @param n the level
+ * @param regions the regions of each level, in cells. Left empty if no tile passes
+ */
+template<typename T>
+void PartsBasedDetector<T>::screen(ResponseCache& roots, size_t n, vector<vector<Rect> >& regions) {
+
+	// the best root score of any component and mixture at each cell
+	Mat best;
+	for (size_t c = 0; c < parts_.ncomponents(); ++c) {
+		ComponentPart root = parts_.component(c);
+		const T bias = root.bias(0)[0];
+		for (size_t m = 0; m < root.nmixtures(); ++m) {
+			Mat score = root.score(roots[n], m) + bias;
+			if (best.empty()) best = score;
+			else cv::max(best, score, best);
+		}
+	}
+
+	// grow each tile with a root score above the threshold by the reach of
+	// the parts, and a tile of slack for their deformation
+	const int tile = screen_tile_;
+	const int grow = reach_ + tile;
+	const Rect bounds(0, 0, best.cols, best.rows);
+	vector<Rect> grown;
+	for (int y = 0; y < best.rows; y += tile) {
+		for (int x = 0; x < best.cols; x += tile) {
+			const Rect block(x, y, std::min(tile, best.cols - x), std::min(tile, best.rows - y));
+			double maxv;
+			minMaxLoc(best(block), NULL, &maxv);
+			if (maxv <= root_thresh_) continue;
+			grown.push_back(Rect(block.x - grow, block.y - grow, block.width + 2*grow, block.height + 2*grow) & bounds);
+		}
 	}
 
+	// merge the grown tiles which overlap or touch, until no two do
+	bool merged = true;
+	while (merged) {
+		merged = false;
+		for (size_t i = 0; i < grown.size(); ++i) {
+			const Rect touch(grown[i].x - 1, grown[i].y - 1, grown[i].width + 2, grown[i].height + 2);
+			for (size_t j = i+1; j < grown.size(); ++j) {
+				if ((touch & grown[j]).area() == 0) continue;
+				grown[i] = grown[i] | grown[j];
+				grown.erase(grown.begin() + j);
+				merged = true;
+				break;
+			}
+			if (merged) break;
+		}
+	}
+	regions[n].swap(grown);
+}
+
+/*! @brief estimate the working memory of a single level of the pyramid
+ *
+ * @param im the input image
+ * @param scale the scale of the level
+ * @return the approximate number of bytes of the level's image, features,
+ * responses and dynamic program tables
+ */
+template<typename T>
+size_t PartsBasedDetector<T>::levelBytes(const Mat& im, float scale) const {
+	const double cells = ((double)im.rows / scale) * ((double)im.cols / scale);
+	const double pixels = cells * features_->binsize() * features_->binsize();
+	return cells * cell_bytes_ + pixels * im.elemSize();
+}
+
+/*! @brief create a convolution engine of the detector precision
+ *
+ * Shared with MultiModelDetector, so both create engines the same way
+ *
+ * @param type the convolution engine
+ * @param flen the length of the feature at each cell
+ * @param separable_energy the energy retained by the SEPARABLE engine
+ * @param sparselet_dictionary the dictionary of the SPARSELET engine, or
+ * empty to learn one from the filters
+ * @return the engine, owned by the caller. Throws if the sparselet
+ * dictionary was given but cannot be loaded
+ */
+template<typename T>
+IConvolutionEngine* PartsBasedDetector<T>::createEngine(ConvolutionType type, size_t flen, double separable_energy, const std::string& sparselet_dictionary) {
+	switch (type) {
+		case QUANTIZED_INT16: return new QuantizedConvolutionEngine(DataType<T>::type, flen, 16);
+		case QUANTIZED_INT8:  return new QuantizedConvolutionEngine(DataType<T>::type, flen, 8);
+		case SEPARABLE:       return new SeparableConvolutionEngine(DataType<T>::type, flen, separable_energy);
+		case SPARSELET: {
+			SparseletConvolutionEngine* sparselet = new SparseletConvolutionEngine(DataType<T>::type, flen);
+			if (!sparselet_dictionary.empty() && !sparselet->load(sparselet_dictionary)) {
+				// a configured dictionary must be shared, never silently replaced by a private one
+				delete sparselet;
+				const std::string error = "cannot load a sparselet dictionary of feature length " + boost::lexical_cast<std::string>(flen) + " from " + sparselet_dictionary;
+#if (CV_MAJOR_VERSION < 3)
+				CV_Error(CV_StsBadArg, error);
+#else
+				CV_Error(cv::Error::StsBadArg, error);
+#endif
+			}
+			return sparselet;
+		}
+		default: return new SpatialConvolutionEngine(DataType<T>::type, flen);
+	}
 }
 
 /*! @brief Distribute the model parameters to the PartsBasedDetector classes
@@ -108,7 +623,8 @@ void PartsBasedDetector<T>::distributeModel(Model& model) {
 	features_.reset(new HOGFeatures<T>(model.binsize(), model.nscales(), model.flen(), model.norient()));
 
 	//initialise the convolution engine
-	convolution_engine_.reset(new SpatialConvolutionEngine(DataType<T>::type, model.flen()));
+	flen_ = model.flen();
+	convolution_engine_.reset(createEngine(convolution_type_, flen_, separable_energy_, sparselet_dictionary_));
 
 	// make sure the filters are of the correct precision for the Feature engine
 	const size_t nfilters = model.filters().size();
@@ -117,16 +633,72 @@ void PartsBasedDetector<T>::distributeModel(Model& model) {
 	}
 	convolution_engine_->setFilters(model.filters());
 
+	// produce the features in the layout the convolution engine prefers
+	const FeatureFormat format = convolution_engine_->preferredFormat();
+	features_->setFormat(format);
+	convolution_engine_->setFormat(format);
+
 	// initialize the tree of Parts
 	parts_ = Parts(model.filters(), model.filtersi(), model.def(), model.defi(), model.bias(), model.biasi(),
 			model.anchors(), model.biasid(), model.filterid(), model.defid(), model.parentid());
 
 	// initialize the dynamic program
-	dp_ = DynamicProgram<T>(model.thresh());
+	dp_ = DynamicProgram<T>(model.thresh(), parts_);
+	dp_.setDisplacement(displacement_, displacement_margin_);
+	tables_.release();
+
+	// the per-cell working memory of a level: the features (and their padded
+	// planes), one response per filter, and the dynamic program tables
+	cell_bytes_ = sizeof(T) * (2*model.flen() + nfilters) + DPTensor<T>::cellBytes(dp_.plan());
+
+	// the furthest extent of any part from its root: the sum of the anchor
+	// offsets along its path to the root, plus the size of its filter
+	reach_ = 0;
+	for (size_t c = 0; c < parts_.ncomponents(); ++c) {
+		vectori offset(parts_.nparts(c), 0);
+		for (size_t p = 0; p < parts_.nparts(c); ++p) {
+			ComponentPart part = parts_.component(c, p);
+			int anchor = 0, extent = 0;
+			for (size_t m = 0; m < part.nmixtures(); ++m) {
+				const Mat& filter = part.filter(m);
+				extent = std::max(extent, std::max(filter.rows, (int)(filter.cols / flen_)));
+				if (part.isRoot()) continue;
+				const Point a = part.anchor(m);
+				anchor = std::max(anchor, std::max(std::abs(a.x), std::abs(a.y)));
+			}
+			if (!part.isRoot()) offset[p] = offset[part.parent().self()] + anchor;
+			reach_ = std::max(reach_, offset[p] + extent);
+		}
+	}
 
 }
 
 
+/*! @brief report the score error of the convolution engine on an image
+ *
+ * The responses of the selected convolution engine are compared, filter by
+ * filter, against those of the exact SpatialConvolutionEngine over the
+ * feature pyramid of the image. For the SEPARABLE engine, the rank chosen
+ * for each filter is also reported, and for the SPARSELET engine the size
+ * of the sparse codes
+ *
+ * @param im the calibration image
+ * @param os the stream to print the report to
+ */
+template<typename T>
+void PartsBasedDetector<T>::calibrate(const Mat& im, ostream& os) {
+	vectorMat pyramid;
+	features_->pyramid(im, pyramid);
+	SpatialConvolutionEngine reference(DataType<T>::type, flen_);
+	reference.setFilters(parts_.filters());
+	reference.setFormat(convolution_engine_->preferredFormat());
+	SeparableConvolutionEngine* separable = dynamic_cast<SeparableConvolutionEngine*>(convolution_engine_.get());
+	if (separable) separable->report(os);
+	SparseletConvolutionEngine* sparselet = dynamic_cast<SparseletConvolutionEngine*>(convolution_engine_.get());
+	if (sparselet) os << "sparselets: " << sparselet->dictionary().rows << " atoms, " << sparselet->termsPerFilter() << " terms per filter" << endl;
+	ConvolutionCalibration::report(reference, *convolution_engine_, pyramid, os);
+}
+
 
 // declare all specializations of the template
 template class PartsBasedDetector<float>;
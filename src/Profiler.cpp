@@ -0,0 +1,279 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    Profiler.cpp
+ *  Created: Oct 16, 2026
+ */
+
+#ifdef WITH_PERF_EVENTS
+#include <cstring>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+#include <algorithm>
+#include <iomanip>
+#include <opencv2/core/core.hpp>
+#include <boost/bind.hpp>
+#include "Profiler.hpp"
+#include "TaskScheduler.hpp"
+using namespace std;
+
+// ---------------------------------------------------------------------------
+// HARDWARE COUNTERS
+// ---------------------------------------------------------------------------
+
+HardwareCounters::HardwareCounters() {
+	for (int e = 0; e < NEVENTS; ++e) available_[e] = false;
+}
+
+HardwareCounters::~HardwareCounters() {
+	close();
+}
+
+/*! @brief open the counters for the calling thread
+ *
+ * The counters follow the calling thread across CPUs and count user space
+ * only, so they do not require elevated privileges under the default
+ * perf_event_paranoid setting. Each event is opened independently, so an
+ * unsupported event (LLC misses are commonly missing in VMs) does not
+ * prevent the others from being counted
+ */
+void HardwareCounters::attach(void) {
+
+	int fds[NEVENTS];
+	for (int e = 0; e < NEVENTS; ++e) fds[e] = -1;
+
+#ifdef WITH_PERF_EVENTS
+	static const uint32_t types[NEVENTS] = {
+		PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE };
+	static const uint64_t configs[NEVENTS] = {
+		PERF_COUNT_HW_CPU_CYCLES,
+		PERF_COUNT_HW_INSTRUCTIONS,
+		PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+		PERF_COUNT_HW_BRANCH_MISSES };
+
+	for (int e = 0; e < NEVENTS; ++e) {
+		struct perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size   = sizeof(attr);
+		attr.type   = types[e];
+		attr.config = configs[e];
+		attr.exclude_kernel = 1;
+		attr.exclude_hv     = 1;
+		// pid = 0, cpu = -1: the calling thread, on any cpu
+		fds[e] = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+	}
+#endif
+
+	boost::mutex::scoped_lock lock(mutex_);
+	for (int e = 0; e < NEVENTS; ++e) {
+		fds_.push_back(fds[e]);
+		if (fds[e] >= 0) available_[e] = true;
+	}
+}
+
+/*! @brief read the current value of the counters, summed over all threads
+ *
+ * @param values the output counter values. Unavailable counters read as zero
+ */
+void HardwareCounters::read(Values& values) const {
+
+	values = Values();
+#ifdef WITH_PERF_EVENTS
+	for (size_t n = 0; n < fds_.size(); ++n) {
+		if (fds_[n] < 0) continue;
+		uint64_t count = 0;
+		if (::read(fds_[n], &count, sizeof(count)) == sizeof(count)) {
+			values.count[n % NEVENTS] += count;
+		}
+	}
+#endif
+}
+
+/*! @brief close all counters on all threads */
+void HardwareCounters::close(void) {
+#ifdef WITH_PERF_EVENTS
+	for (size_t n = 0; n < fds_.size(); ++n) {
+		if (fds_[n] >= 0) ::close(fds_[n]);
+	}
+#endif
+	fds_.clear();
+	for (int e = 0; e < NEVENTS; ++e) available_[e] = false;
+}
+
+bool HardwareCounters::available(void) const {
+	for (int e = 0; e < NEVENTS; ++e) if (available_[e]) return true;
+	return false;
+}
+
+// ---------------------------------------------------------------------------
+// STATISTICS
+// ---------------------------------------------------------------------------
+
+double StageStats::ipc(void) const {
+	const uint64_t cycles = counters.count[HardwareCounters::CYCLES];
+	if (!valid[HardwareCounters::CYCLES] || !valid[HardwareCounters::INSTRUCTIONS] || cycles == 0) return 0;
+	return (double)counters.count[HardwareCounters::INSTRUCTIONS] / (double)cycles;
+}
+
+double StageStats::mpki(HardwareCounters::Event e) const {
+	const uint64_t instructions = counters.count[HardwareCounters::INSTRUCTIONS];
+	if (!valid[e] || !valid[HardwareCounters::INSTRUCTIONS] || instructions == 0) return 0;
+	return 1000.0 * (double)counters.count[e] / (double)instructions;
+}
+
+double DetectorStats::seconds(void) const {
+	double total = 0;
+	for (int s = 0; s < NSTAGES; ++s) total += stages[s].seconds;
+	return total;
+}
+
+const char* DetectorStats::name(Stage stage) {
+	static const char* names[NSTAGES] = { "pyramid", "convolution", "dp min", "argmin" };
+	return names[stage];
+}
+
+/*! @brief print a per-stage breakdown of the frame
+ *
+ * A low IPC with a high LLC MPKI indicates a memory-bound stage, a high IPC a
+ * compute-bound stage. Counters which could not be opened are printed as "-"
+ *
+ * @param os the output stream
+ */
+void DetectorStats::print(std::ostream& os) const {
+	os << setw(12) << left << "stage" << right
+	   << setw(10) << "ms"
+	   << setw(16) << "cycles"
+	   << setw(16) << "instructions"
+	   << setw(8)  << "IPC"
+	   << setw(10) << "LLC MPKI"
+	   << setw(10) << "BR MPKI" << endl;
+	for (int s = 0; s < NSTAGES; ++s) {
+		const StageStats& st = stages[s];
+		os << setw(12) << left << name((Stage)s) << right << fixed
+		   << setw(10) << setprecision(2) << st.seconds*1000.0;
+		if (st.valid[HardwareCounters::CYCLES]) os << setw(16) << st.counters.count[HardwareCounters::CYCLES];
+		else os << setw(16) << "-";
+		if (st.valid[HardwareCounters::INSTRUCTIONS]) os << setw(16) << st.counters.count[HardwareCounters::INSTRUCTIONS];
+		else os << setw(16) << "-";
+		if (st.ipc() > 0) os << setw(8) << setprecision(2) << st.ipc();
+		else os << setw(8) << "-";
+		if (st.valid[HardwareCounters::LLC_MISSES]) os << setw(10) << setprecision(2) << st.mpki(HardwareCounters::LLC_MISSES);
+		else os << setw(10) << "-";
+		if (st.valid[HardwareCounters::BRANCH_MISSES]) os << setw(10) << setprecision(2) << st.mpki(HardwareCounters::BRANCH_MISSES);
+		else os << setw(10) << "-";
+		os << endl;
+	}
+	os << setw(12) << left << "total" << right << setw(10) << setprecision(2) << seconds()*1000.0 << endl;
+}
+
+// ---------------------------------------------------------------------------
+// PROFILER
+// ---------------------------------------------------------------------------
+
+/*! @brief enable or disable profiling
+ *
+ * When hardware counters are requested, a counter group is opened on each
+ * thread of the global TaskScheduler, which are the threads that execute the
+ * parallel stages of the pipeline. If the scheduler is reconfigured, profiling
+ * must be enabled again
+ *
+ * @param enabled enable profiling
+ * @param hardware_counters also collect hardware counters (wall time is always collected)
+ */
+void Profiler::enable(bool enabled, bool hardware_counters) {
+
+	enabled_ = enabled;
+	hardware_counters_ = hardware_counters;
+	counters_.close();
+	stats_.clear();
+	if (!enabled || !hardware_counters) return;
+
+	TaskScheduler::global().onEachThread(boost::bind(&HardwareCounters::attach, &counters_));
+}
+
+/*! @brief start measuring a stage */
+void Profiler::start(void) {
+	if (!enabled_) return;
+	counters_.read(start_counters_);
+	start_ticks_ = cv::getTickCount();
+}
+
+/*! @brief stop measuring a stage and accumulate its cost
+ *
+ * @param stage the stage that was measured since the last call to start()
+ */
+void Profiler::stop(DetectorStats::Stage stage) {
+	if (!enabled_) return;
+	const int64_t ticks = cv::getTickCount();
+	HardwareCounters::Values now;
+	counters_.read(now);
+
+	StageStats& st = stats_.stages[stage];
+	st.seconds += (double)(ticks - start_ticks_) / cv::getTickFrequency();
+	for (int e = 0; e < HardwareCounters::NEVENTS; ++e) {
+		st.valid[e] = counters_.available((HardwareCounters::Event)e);
+		st.counters.count[e] += now.count[e] - start_counters_.count[e];
+	}
+}
+
+/*! @brief move work which ran inside the tasks of one stage to another stage
+ *
+ * The convolutions are computed on demand by the tasks of the dynamic
+ * program, so they cannot be bracketed by start() and stop(). Their thread
+ * time, measured by the ResponseCache, is converted to wall time assuming it
+ * was spread over the threads of the global TaskScheduler, and moved along
+ * with the same share of the hardware counters
+ *
+ * @param from the stage which was measured
+ * @param to the stage the work belongs to
+ * @param thread_seconds the thread time of the work, summed over threads
+ */
+void Profiler::transfer(DetectorStats::Stage from, DetectorStats::Stage to, double thread_seconds) {
+	if (!enabled_) return;
+	StageStats& src = stats_.stages[from];
+	StageStats& dst = stats_.stages[to];
+	if (src.seconds <= 0 || thread_seconds <= 0) return;
+
+	const double seconds = std::min(src.seconds, thread_seconds / TaskScheduler::global().nthreads());
+	const double share = seconds / src.seconds;
+	src.seconds -= seconds;
+	dst.seconds += seconds;
+	for (int e = 0; e < HardwareCounters::NEVENTS; ++e) {
+		const uint64_t count = (uint64_t)(share * src.counters.count[e]);
+		src.counters.count[e] -= count;
+		dst.counters.count[e] += count;
+		dst.valid[e] = src.valid[e];
+	}
+}
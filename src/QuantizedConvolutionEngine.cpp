@@ -0,0 +1,299 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    QuantizedConvolutionEngine.cpp
+ *  Created: Oct 16, 2026
+ */
+
+#include <cmath>
+#include <cassert>
+#include <stdint.h>
+#include <boost/bind.hpp>
+#include "CpuDispatch.hpp"
+#include "FeatureLayout.hpp"
+#include "QuantizedConvolutionEngine.hpp"
+#include "TaskScheduler.hpp"
+using namespace std;
+using namespace cv;
+
+//! filter rows are padded to a multiple of this many elements, so the dot products need no tail
+static const int kAlign = 32;
+
+//! the dispatched dot product of a 16-bit feature row and a 16-bit filter row
+static inline int32_t dot(const CpuDispatch::Kernels& k, const int16_t* a, const int16_t* b, int n) {
+	return k.dot16(a, b, n);
+}
+
+//! the dispatched dot product of an 8-bit feature row and an 8-bit filter row
+static inline int32_t dot(const CpuDispatch::Kernels& k, const uint8_t* a, const int8_t* b, int n) {
+	return k.dot8(a, b, n);
+}
+
+/*! @brief correlate a band of rows of a padded, quantized feature with a quantized filter
+ *
+ * @param feature the padded feature, with the filter anchor offset already applied
+ * @param filter the quantized filter
+ * @param acc the output accumulator of the band
+ * @param y0 the first row of the band
+ * @param flen the length of the feature at each cell
+ */
+template<typename FT, typename WT>
+static void correlate(const Mat& feature, const Mat& filter, Mat_<int32_t>& acc, int y0, int flen) {
+	const CpuDispatch::Kernels& kernels = CpuDispatch::kernels();
+	const int width = filter.cols;
+	for (int y = 0; y < acc.rows; ++y) {
+		int32_t* out = acc[y];
+		for (int x = 0; x < acc.cols; ++x) {
+			int32_t sum = 0;
+			for (int i = 0; i < filter.rows; ++i) {
+				sum += dot(kernels, feature.ptr<FT>(y0+y+i) + x*flen, filter.ptr<WT>(i), width);
+			}
+			out[x] = sum;
+		}
+	}
+}
+
+// ---------------------------------------------------------------------------
+// ENGINE
+// ---------------------------------------------------------------------------
+
+QuantizedConvolutionEngine::QuantizedConvolutionEngine(int type, size_t flen, int bits) :
+	type_(type), flen_(flen), bits_(bits), fmax_(0), wmax_(0), bound_(NULL) {
+	assert(bits_ == 8 || bits_ == 16);
+}
+
+QuantizedConvolutionEngine::~QuantizedConvolutionEngine() {
+}
+
+/*! @brief quantize and pad a single level of the feature pyramid
+ *
+ * The level is scaled so that its largest value (or the occlusion padding
+ * value of one, if larger) maps to fmax_. The padding is zero, except for
+ * the last channel which is one, as in the SpatialConvolutionEngine. Each
+ * row has kAlign elements of slack, so the dot products can overrun it
+ *
+ * @param features the feature pyramid
+ * @param quantized the quantized, padded levels
+ * @param fscale the quantization scale of each level
+ * @param m the level to quantize
+ */
+void QuantizedConvolutionEngine::quantize(const vectorMat& features, vectorMat& quantized, vector<double>& fscale, size_t m) {
+
+	// error checking
+	assert(features[m].depth() == type_);
+
+	const Mat& feature = features[m];
+	const int rows = feature.rows;
+	const int cols = feature.cols / flen_;
+	const int depth = (bits_ == 8) ? CV_8U : CV_16S;
+	fscale[m] = fmax_ / std::max(norm(feature, NORM_INF), 1.0);
+
+	const int pcols = cols + 2*pad_.width;
+	Mat padded = Mat::zeros(rows + 2*pad_.height, pcols*flen_ + kAlign, depth);
+	Mat interior = padded(Rect(pad_.width*flen_, pad_.height, cols*flen_, rows));
+	feature.convertTo(interior, depth, fscale[m]);
+
+	const Rect cells(pad_.width, pad_.height, cols, rows);
+	if (bits_ == 8) FeatureLayout::fillOcclusion<uint8_t>(padded, cells, pcols, flen_, saturate_cast<uint8_t>(fscale[m]));
+	else            FeatureLayout::fillOcclusion<int16_t>(padded, cells, pcols, flen_, saturate_cast<int16_t>(fscale[m]));
+	quantized[m] = padded;
+}
+
+/*! @brief convolve a band of rows of a quantized feature with a filter
+ *
+ * @param feature the quantized, padded feature
+ * @param fscale the quantization scale of the feature
+ * @param n the filter
+ * @param pdf the preallocated response to write into
+ * @param y0 the first row of the band
+ * @param y1 one past the last row of the band
+ */
+void QuantizedConvolutionEngine::convolve(const Mat& feature, double fscale, size_t n, Mat& pdf, size_t y0, size_t y1) {
+
+	// offset the padded feature by the filter anchor (the center, as in filter2D)
+	const Size& fsize = fsize_[n];
+	const Point anchor(fsize.width/2, fsize.height/2);
+	const int xoffset = (pad_.width - anchor.x) * flen_;
+	Mat shifted = feature(Rect(xoffset, pad_.height - anchor.y, feature.cols - xoffset, feature.rows - pad_.height + anchor.y));
+
+	Mat_<int32_t> acc(y1-y0, pdf.cols);
+	if (bits_ == 8) correlate<uint8_t, int8_t>(shifted, filters_[n], acc, y0, flen_);
+	else            correlate<int16_t, int16_t>(shifted, filters_[n], acc, y0, flen_);
+
+	// dequantize
+	Mat band = pdf.rowRange(y0, y1);
+	acc.convertTo(band, type_, 1.0 / (fscale * wscale_[n]));
+}
+
+/*! @brief Calculate the responses of a set of features to a set of filter experts
+ *
+ * The levels of the pyramid are quantized once, up front. The convolutions are
+ * then split into tasks by level, filter and (for the larger levels) bands of
+ * rows, and scheduled largest-first on the global TaskScheduler
+ *
+ * @param features the input features (at different scales, and by extension, size)
+ * @param responses the vector of responses (pdfs) to return
+ */
+void QuantizedConvolutionEngine::pdf(const vectorMat& features, vector2DMat& responses) {
+
+	// preallocate the output
+	const size_t M = features.size();
+	const size_t N = filters_.size();
+	responses.resize(M, vectorMat(N));
+	TaskScheduler& scheduler = TaskScheduler::global();
+
+	// quantize each level
+	vectorMat quantized(M);
+	vector<double> fscale(M);
+	vector<double> costs(M);
+	for (size_t m = 0; m < M; ++m) costs[m] = features[m].total();
+	scheduler.parallelFor(M, boost::bind(&QuantizedConvolutionEngine::quantize, this, boost::cref(features), boost::ref(quantized), boost::ref(fscale), _1), costs);
+
+	// estimate the cost of each convolution
+	double total = 0;
+	for (size_t m = 0; m < M; ++m) for (size_t n = 0; n < N; ++n) total += features[m].total() * filters_[n].total();
+
+	// split the convolutions which are larger than a fair share of the work into bands
+	const double share = total / (4 * scheduler.nthreads());
+	vector<Task> tasks;
+	costs.clear();
+	vector<size_t> bounds;
+	for (size_t m = 0; m < M; ++m) {
+		const int rows = features[m].rows;
+		const int cols = features[m].cols / flen_;
+		for (size_t n = 0; n < N; ++n) {
+			responses[m][n] = Mat(rows, cols, type_);
+			const double cost = features[m].total() * filters_[n].total();
+			TaskScheduler::bands(rows, 4, ceil(cost / share), bounds);
+			for (size_t b = 0; b < bounds.size()-1; ++b) {
+				tasks.push_back(boost::bind(&QuantizedConvolutionEngine::convolve, this, boost::cref(quantized[m]), fscale[m], n, boost::ref(responses[m][n]), bounds[b], bounds[b+1]));
+				costs.push_back(cost * (bounds[b+1] - bounds[b]) / rows);
+			}
+		}
+	}
+	TaskGroup group;
+	scheduler.run(group, tasks, costs);
+	scheduler.wait(group);
+}
+
+/*! @brief bind a pyramid of features for on-demand responses
+ *
+ * @param features the input features
+ */
+void QuantizedConvolutionEngine::bind(const vectorMat& features) {
+	bound_ = &features;
+	quantized_.clear();
+	quantized_.resize(features.size());
+	fscale_.resize(features.size());
+}
+
+/*! @brief quantize a level of the bound pyramid
+ *
+ * @param m the level
+ */
+void QuantizedConvolutionEngine::prepare(size_t m) {
+	quantize(*bound_, quantized_, fscale_, m);
+}
+
+/*! @brief compute the response of a single filter at a prepared level
+ *
+ * @param m the level
+ * @param n the filter
+ * @param response the response to return
+ */
+void QuantizedConvolutionEngine::response(size_t m, size_t n, Mat& response) {
+	const Mat& feature = (*bound_)[m];
+	response = Mat(feature.rows, feature.cols / flen_, type_);
+	convolve(quantized_[m], fscale_[m], n, response, 0, feature.rows);
+}
+
+//! the size of the responses at level m of the bound pyramid
+Size QuantizedConvolutionEngine::responseSize(size_t m) const {
+	return Size((*bound_)[m].cols / flen_, (*bound_)[m].rows);
+}
+
+//! release the bound pyramid and its quantized levels
+void QuantizedConvolutionEngine::release(void) {
+	bound_ = NULL;
+	quantized_.clear();
+	fscale_.clear();
+}
+
+/*! @brief set the filters
+ *
+ * quantize each filter with its own scale, and pad each of its rows to a
+ * multiple of the vector width. With 16-bit quantization, the feature and
+ * filter magnitudes are limited so that no response of the largest filter
+ * can overflow a 32-bit accumulator
+ *
+ * @param filters the filters
+ */
+void QuantizedConvolutionEngine::setFilters(const vectorMat& filters) {
+
+	const size_t N = filters.size();
+	filters_.clear();
+	filters_.resize(N);
+	fsize_.resize(N);
+	wscale_.resize(N);
+	pad_ = Size(0,0);
+
+	// find the largest filter
+	size_t nterms = 1;
+	for (size_t n = 0; n < N; ++n) {
+		fsize_[n] = Size(filters[n].cols / flen_, filters[n].rows);
+		pad_.width  = std::max(pad_.width,  fsize_[n].width);
+		pad_.height = std::max(pad_.height, fsize_[n].height);
+		nterms = std::max(nterms, (size_t)filters[n].total());
+	}
+
+	// choose the quantization range
+	if (bits_ == 8) {
+		fmax_ = 127;
+		wmax_ = 127;
+	} else {
+		fmax_ = std::min(32767.0, floor(sqrt(2147483647.0 / nterms)));
+		wmax_ = fmax_;
+	}
+
+	// quantize each filter
+	const int depth = (bits_ == 8) ? CV_8S : CV_16S;
+	for (size_t n = 0; n < N; ++n) {
+		const int width = filters[n].cols;
+		const int padded = (width + kAlign-1) / kAlign * kAlign;
+		const double maxabs = norm(filters[n], NORM_INF);
+		wscale_[n] = maxabs > 0 ? wmax_ / maxabs : 1;
+		filters_[n] = Mat::zeros(filters[n].rows, padded, depth);
+		Mat interior = filters_[n].colRange(0, width);
+		filters[n].convertTo(interior, depth, wscale_[n]);
+	}
+}
@@ -0,0 +1,205 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    ResponseCache.cpp
+ *  Created: Oct 16, 2026
+ */
+
+#include <cassert>
+#include "ResponseCache.hpp"
+using namespace cv;
+using namespace std;
+
+/*! @brief fill a cache with precomputed responses
+ *
+ * @param responses the responses, by level then filter
+ */
+ResponseCache::ResponseCache(const vector2DMat& responses) :
+	engine_(NULL), features_(NULL), nfilters_(0), offset_(0), window_(0), ticks_(0) {
+	assign(responses);
+}
+
+/*! @brief bind the cache to an engine and a pyramid of features
+ *
+ * No responses are computed here. The engine must have its filters set,
+ * and both the engine and the features must outlive the binding
+ *
+ * @param engine the engine which computes the responses
+ * @param features the pyramid of features
+ */
+void ResponseCache::bind(IConvolutionEngine& engine, const vectorMat& features) {
+
+	clear();
+	const size_t M = features.size();
+	const size_t N = engine.nfilters();
+	engine_   = &engine;
+	features_ = &features;
+	nfilters_ = N;
+	offset_   = 0;
+	window_   = N;
+	responses_.resize(M, vectorMat(N));
+	prepared_.resize(M, false);
+	computed_.resize(M*N, false);
+	level_mutex_.reset(new boost::mutex[M]);
+	response_mutex_.reset(new boost::mutex[M*N]);
+	engine_->bind(features);
+}
+
+/*! @brief fill the cache with precomputed responses
+ *
+ * @param responses the responses, by level then filter
+ */
+void ResponseCache::assign(const vector2DMat& responses) {
+	clear();
+	responses_ = responses;
+	nfilters_  = responses.empty() ? 0 : responses[0].size();
+	offset_    = 0;
+	window_    = nfilters_;
+}
+
+/*! @brief release the responses, and the engine's per-level state
+ */
+void ResponseCache::clear(void) {
+	if (engine_) engine_->release();
+	engine_   = NULL;
+	features_ = NULL;
+	nfilters_ = 0;
+	offset_   = 0;
+	window_   = 0;
+	ticks_    = 0;
+	responses_.clear();
+	prepared_.clear();
+	computed_.clear();
+	level_mutex_.reset();
+	response_mutex_.reset();
+}
+
+/*! @brief prepare a level of the bound pyramid, once
+ *
+ * @param m the level
+ */
+void ResponseCache::prepare(size_t m) {
+	boost::unique_lock<boost::mutex> lock(level_mutex_[m]);
+	if (prepared_[m]) return;
+	engine_->prepare(m);
+	prepared_[m] = true;
+}
+
+/*! @brief the response of a filter at a level
+ *
+ * If the cache is bound to an engine and the response has not yet been
+ * read, the level is prepared if necessary and the response computed.
+ * Safe to call from concurrent tasks
+ *
+ * @param m the level
+ * @param n the filter, within the window
+ * @return the response
+ */
+const Mat& ResponseCache::at(size_t m, size_t n) {
+
+	n += offset_;
+	if (!engine_) return responses_[m][n];
+	const size_t mn = m*nfilters_ + n;
+	boost::unique_lock<boost::mutex> lock(response_mutex_[mn]);
+	if (!computed_[mn]) {
+		const int64_t start = getTickCount();
+		prepare(m);
+		engine_->response(m, n, responses_[m][n]);
+		computed_[mn] = true;
+		__sync_fetch_and_add(&ticks_, getTickCount() - start);
+	}
+	return responses_[m][n];
+}
+
+/*! @brief restrict reads to a window of consecutive filters
+ *
+ * Filter n of the window is filter offset+n of the cache. Responses
+ * already computed are kept, whichever window they were read through.
+ * The window must not be changed while other tasks read the cache
+ *
+ * @param offset the first filter of the window
+ * @param nfilters the number of filters in the window
+ */
+void ResponseCache::setWindow(size_t offset, size_t nfilters) {
+	assert(offset + nfilters <= nfilters_);
+	offset_ = offset;
+	window_ = nfilters;
+}
+
+/*! @brief the relative cost of processing a level
+ *
+ * Proportional to the area of the level, without computing any response
+ *
+ * @param m the level
+ * @return the relative cost
+ */
+double ResponseCache::cost(size_t m) const {
+	if (features_) return (*features_)[m].total();
+	return (responses_[m].empty()) ? 0 : responses_[m][0].total();
+}
+
+/*! @brief the size of the responses at a level
+ *
+ * Known without computing any response, so storage which depends on it
+ * can be allocated before the responses are read
+ *
+ * @param m the level
+ * @return the size of each response at level m
+ */
+Size ResponseCache::levelSize(size_t m) const {
+	if (engine_) return engine_->responseSize(m);
+	return (responses_[m].empty()) ? Size() : responses_[m][0].size();
+}
+
+/*! @brief the time spent computing responses so far
+ *
+ * Measured on the threads which computed them and summed, so responses
+ * computed concurrently count once each. Levels prepared in parallel bands
+ * are counted once, on the thread which waited for them
+ *
+ * @return the thread time (seconds)
+ */
+double ResponseCache::seconds(void) const {
+	return (double)ticks_ / getTickFrequency();
+}
+
+/*! @brief the number of responses computed (or given) so far
+ *
+ * @return the number of responses
+ */
+size_t ResponseCache::ncomputed(void) const {
+	if (!engine_) return responses_.size() * nfilters_;
+	size_t count = 0;
+	for (size_t mn = 0; mn < computed_.size(); ++mn) count += computed_[mn];
+	return count;
+}
@@ -0,0 +1,362 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    SeparableConvolutionEngine.cpp
+ *  Created: Oct 16, 2026
+ */
+
+#include <cmath>
+#include <cassert>
+#include <iomanip>
+#include <boost/bind.hpp>
+#include "CpuDispatch.hpp"
+#include "FeatureLayout.hpp"
+#include "SeparableConvolutionEngine.hpp"
+#include "TaskScheduler.hpp"
+using namespace std;
+using namespace cv;
+
+// the dispatched dot products and scaled accumulations of the two passes
+static inline float  dot(const CpuDispatch::Kernels& k, const float* a,  const float* b,  int n) { return k.dotf(a, b, n); }
+static inline double dot(const CpuDispatch::Kernels& k, const double* a, const double* b, int n) { return k.dotd(a, b, n); }
+static inline void axpy(const CpuDispatch::Kernels& k, float alpha,  const float* src,  float* dst,  int n) { k.axpyf(alpha, src, dst, n); }
+static inline void axpy(const CpuDispatch::Kernels& k, double alpha, const double* src, double* dst, int n) { k.axpyd(alpha, src, dst, n); }
+
+/*! @brief apply the row and column passes of a separable filter to a band of rows
+ *
+ * @param feature the padded feature, offset so that row 0 and cell 0 align
+ * with the top left tap of the filter for the first output of the band
+ * @param rowf the row filters (rank x fw*flen)
+ * @param colf the column filters (fh x rank)
+ * @param out the output band
+ * @param flen the length of the feature at each cell
+ */
+template<typename T>
+static void separable(const Mat& feature, const Mat& rowf, const Mat& colf, Mat& out, int flen) {
+
+	const CpuDispatch::Kernels& kernels = CpuDispatch::kernels();
+	const int rank  = rowf.rows;
+	const int width = rowf.cols;
+	const int fh    = colf.rows;
+	const int rows  = out.rows + fh - 1;
+	const int cols  = out.cols;
+
+	// row pass: the response of each row filter at each cell of each input row
+	vectorMat rowpass(rank);
+	for (int k = 0; k < rank; ++k) rowpass[k].create(rows, cols, DataType<T>::type);
+	for (int y = 0; y < rows; ++y) {
+		const T* src = feature.ptr<T>(y);
+		for (int k = 0; k < rank; ++k) {
+			const T* w = rowf.ptr<T>(k);
+			T* dst = rowpass[k].ptr<T>(y);
+			for (int x = 0; x < cols; ++x) dst[x] = dot(kernels, src + x*flen, w, width);
+		}
+	}
+
+	// column pass: accumulate the row responses down each column
+	out.setTo(Scalar::all(0));
+	for (int y = 0; y < out.rows; ++y) {
+		T* dst = out.ptr<T>(y);
+		for (int k = 0; k < rank; ++k) {
+			for (int i = 0; i < fh; ++i) {
+				axpy(kernels, colf.at<T>(i,k), rowpass[k].ptr<T>(y+i), dst, cols);
+			}
+		}
+	}
+}
+
+/*! @brief apply a filter directly to a band of rows, one filter row at a time
+ *
+ * @param feature the padded feature, offset as for separable()
+ * @param filter the filter (fh x fw*flen)
+ * @param out the output band
+ * @param flen the length of the feature at each cell
+ */
+template<typename T>
+static void direct(const Mat& feature, const Mat& filter, Mat& out, int flen) {
+
+	const CpuDispatch::Kernels& kernels = CpuDispatch::kernels();
+	const int width = filter.cols;
+	const int fh    = filter.rows;
+	for (int y = 0; y < out.rows; ++y) {
+		T* dst = out.ptr<T>(y);
+		for (int x = 0; x < out.cols; ++x) {
+			T sum = 0;
+			for (int i = 0; i < fh; ++i) sum += dot(kernels, feature.ptr<T>(y+i) + x*flen, filter.ptr<T>(i), width);
+			dst[x] = sum;
+		}
+	}
+}
+
+SeparableConvolutionEngine::SeparableConvolutionEngine(int type, size_t flen, double energy) :
+	type_(type), flen_(flen), energy_(energy), bound_(NULL) {}
+
+SeparableConvolutionEngine::~SeparableConvolutionEngine() {
+}
+
+/*! @brief pad a single level of the feature pyramid
+ *
+ * The padding is zero, except for the last channel which is one, as in
+ * the SpatialConvolutionEngine
+ *
+ * @param features the feature pyramid
+ * @param padded the padded levels
+ * @param m the level to pad
+ */
+void SeparableConvolutionEngine::pad(const vectorMat& features, vectorMat& padded, size_t m) {
+
+	// error checking
+	assert(features[m].depth() == type_);
+
+	const int rows = features[m].rows;
+	const int cols = features[m].cols / flen_;
+	Mat& out = padded[m];
+	copyMakeBorder(features[m], out, pad_.height, pad_.height, pad_.width*flen_, pad_.width*flen_, BORDER_CONSTANT, Scalar::all(0));
+
+	// one-pad the occlusion channel
+	const Rect cells(pad_.width, pad_.height, cols, rows);
+	if (type_ == CV_32F) FeatureLayout::fillOcclusion<float>(out, cells, cols + 2*pad_.width, flen_, 1);
+	else                 FeatureLayout::fillOcclusion<double>(out, cells, cols + 2*pad_.width, flen_, 1);
+}
+
+/*! @brief the multiply-adds per response of a filter, as it is applied
+ *
+ * @param n the filter
+ * @return the cost of the separable passes, or of the filter if it is applied directly
+ */
+double SeparableConvolutionEngine::cost(size_t n) const {
+	const double width = fsize_[n].width * flen_;
+	if (ranks_[n] == 0) return fsize_[n].height * width;
+	return ranks_[n] * (width + fsize_[n].height);
+}
+
+/*! @brief convolve a band of rows of a padded feature with a separable filter
+ *
+ * @param feature the padded feature
+ * @param n the filter
+ * @param pdf the preallocated response to write into
+ * @param y0 the first row of the band
+ * @param y1 one past the last row of the band
+ */
+void SeparableConvolutionEngine::convolve(const Mat& feature, size_t n, Mat& pdf, size_t y0, size_t y1) {
+
+	// offset the padded feature by the filter anchor (the center, as in filter2D)
+	const Size& fsize = fsize_[n];
+	const Point anchor(fsize.width/2, fsize.height/2);
+	const int x0 = (pad_.width - anchor.x) * flen_;
+	const int ys = pad_.height - anchor.y + y0;
+	Mat window = feature(Rect(x0, ys, feature.cols - x0, (y1 - y0) + fsize.height - 1));
+	Mat band = pdf.rowRange(y0, y1);
+	if (!fullf_[n].empty()) {
+		if (type_ == CV_32F) direct<float>(window, fullf_[n], band, flen_);
+		else                 direct<double>(window, fullf_[n], band, flen_);
+	} else {
+		if (type_ == CV_32F) separable<float>(window, rowf_[n], colf_[n], band, flen_);
+		else                 separable<double>(window, rowf_[n], colf_[n], band, flen_);
+	}
+}
+
+/*! @brief Calculate the responses of a set of features to a set of filter experts
+ *
+ * The levels of the pyramid are padded once, up front. The convolutions are
+ * then split into tasks by level, filter and (for the larger levels) bands of
+ * rows, and scheduled largest-first on the global TaskScheduler
+ *
+ * @param features the input features (at different scales, and by extension, size)
+ * @param responses the vector of responses (pdfs) to return
+ */
+void SeparableConvolutionEngine::pdf(const vectorMat& features, vector2DMat& responses) {
+
+	// preallocate the output
+	const size_t M = features.size();
+	const size_t N = rowf_.size();
+	responses.resize(M, vectorMat(N));
+	TaskScheduler& scheduler = TaskScheduler::global();
+
+	// pad each level
+	vectorMat padded(M);
+	vector<double> costs(M);
+	for (size_t m = 0; m < M; ++m) costs[m] = features[m].total();
+	scheduler.parallelFor(M, boost::bind(&SeparableConvolutionEngine::pad, this, boost::cref(features), boost::ref(padded), _1), costs);
+
+	// estimate the cost of each convolution
+	vector<double> fcosts(N);
+	double total = 0;
+	for (size_t n = 0; n < N; ++n) fcosts[n] = cost(n);
+	for (size_t m = 0; m < M; ++m) for (size_t n = 0; n < N; ++n) total += features[m].total() * fcosts[n];
+
+	// split the convolutions which are larger than a fair share of the work into bands
+	const double share = total / (4 * scheduler.nthreads());
+	vector<Task> tasks;
+	costs.clear();
+	vector<size_t> bounds;
+	for (size_t m = 0; m < M; ++m) {
+		const int rows = features[m].rows;
+		const int cols = features[m].cols / flen_;
+		for (size_t n = 0; n < N; ++n) {
+			responses[m][n] = Mat(rows, cols, type_);
+			const double cost = features[m].total() * fcosts[n];
+			TaskScheduler::bands(rows, 4, ceil(cost / share), bounds);
+			for (size_t b = 0; b < bounds.size()-1; ++b) {
+				tasks.push_back(boost::bind(&SeparableConvolutionEngine::convolve, this, boost::cref(padded[m]), n, boost::ref(responses[m][n]), bounds[b], bounds[b+1]));
+				costs.push_back(cost * (bounds[b+1] - bounds[b]) / rows);
+			}
+		}
+	}
+	TaskGroup group;
+	scheduler.run(group, tasks, costs);
+	scheduler.wait(group);
+}
+
+/*! @brief bind a pyramid of features for on-demand responses
+ *
+ * @param features the input features
+ */
+void SeparableConvolutionEngine::bind(const vectorMat& features) {
+	bound_ = &features;
+	padded_.clear();
+	padded_.resize(features.size());
+}
+
+/*! @brief pad a level of the bound pyramid
+ *
+ * @param m the level
+ */
+void SeparableConvolutionEngine::prepare(size_t m) {
+	pad(*bound_, padded_, m);
+}
+
+/*! @brief compute the response of a single filter at a prepared level
+ *
+ * @param m the level
+ * @param n the filter
+ * @param response the response to return
+ */
+void SeparableConvolutionEngine::response(size_t m, size_t n, Mat& response) {
+	const Mat& feature = (*bound_)[m];
+	response = Mat(feature.rows, feature.cols / flen_, type_);
+	convolve(padded_[m], n, response, 0, feature.rows);
+}
+
+//! the size of the responses at level m of the bound pyramid
+Size SeparableConvolutionEngine::responseSize(size_t m) const {
+	return Size((*bound_)[m].cols / flen_, (*bound_)[m].rows);
+}
+
+//! release the bound pyramid and its padded levels
+void SeparableConvolutionEngine::release(void) {
+	bound_ = NULL;
+	padded_.clear();
+}
+
+/*! @brief set the filters
+ *
+ * factor each filter into the smallest sum of separable terms which
+ * retains energy_ of its energy. A filter which needs so many terms that
+ * r*(fw*flen + fh) >= fh*fw*flen is kept whole and applied directly
+ *
+ * @param filters the filters
+ */
+void SeparableConvolutionEngine::setFilters(const vectorMat& filters) {
+
+	const size_t N = filters.size();
+	rowf_.clear();
+	colf_.clear();
+	fullf_.clear();
+	rowf_.resize(N);
+	colf_.resize(N);
+	fullf_.resize(N);
+	fsize_.resize(N);
+	ranks_.resize(N);
+	residual_.resize(N);
+	pad_ = Size(0,0);
+
+	for (size_t n = 0; n < N; ++n) {
+		fsize_[n] = Size(filters[n].cols / flen_, filters[n].rows);
+		pad_.width  = std::max(pad_.width,  fsize_[n].width);
+		pad_.height = std::max(pad_.height, fsize_[n].height);
+
+		// W = U * diag(s) * Vt, with W of size fh x (fw*flen)
+		Mat W, s, U, Vt;
+		filters[n].convertTo(W, CV_64F);
+		SVD::compute(W, s, U, Vt);
+
+		// choose the smallest rank which retains the requested energy
+		double total = 0;
+		for (int k = 0; k < s.rows; ++k) total += s.at<double>(k) * s.at<double>(k);
+		double kept = 0;
+		int rank = 0;
+		while (rank < s.rows && (rank == 0 || kept < energy_ * total)) {
+			kept += s.at<double>(rank) * s.at<double>(rank);
+			rank++;
+		}
+		ranks_[n] = rank;
+		residual_[n] = total > 0 ? sqrt(std::max(total - kept, 0.0) / total) : 0;
+
+		// the approximation only saves work while its passes are shorter than the filter
+		if (rank * (W.cols + W.rows) >= W.rows * W.cols) {
+			filters[n].convertTo(fullf_[n], type_);
+			ranks_[n] = 0;
+			residual_[n] = 0;
+			continue;
+		}
+
+		// fold the singular values into the row filters
+		Mat rowf = Vt.rowRange(0, rank).clone();
+		for (int k = 0; k < rank; ++k) {
+			Mat row = rowf.row(k);
+			row *= s.at<double>(k);
+		}
+		rowf.convertTo(rowf_[n], type_);
+		U.colRange(0, rank).convertTo(colf_[n], type_);
+	}
+}
+
+/*! @brief print the rank chosen for each filter, and the resulting saving
+ *
+ * @param os the stream to print to
+ */
+void SeparableConvolutionEngine::report(ostream& os) const {
+	double full = 0, separable = 0;
+	os << setw(8) << "filter" << setw(8) << "size" << setw(8) << "rank" << setw(12) << "residual" << endl;
+	for (size_t n = 0; n < ranks_.size(); ++n) {
+		full      += fsize_[n].area() * flen_;
+		separable += cost(n);
+		ostringstream size, rank;
+		size << fsize_[n].height << "x" << fsize_[n].width;
+		if (ranks_[n]) rank << ranks_[n];
+		else rank << "full";
+		os << setw(8) << n << setw(8) << size.str() << setw(8) << rank.str() << setw(12) << setprecision(4) << residual_[n] << endl;
+	}
+	if (full > 0) os << "multiply-adds per response: " << separable / full << " of full convolution" << endl;
+}
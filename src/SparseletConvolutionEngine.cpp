@@ -0,0 +1,521 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    SparseletConvolutionEngine.cpp
+ *  Created: Oct 16, 2026
+ */
+
+#include <cmath>
+#include <cstring>
+#include <cassert>
+#include <algorithm>
+#include <boost/bind.hpp>
+#include "FeatureLayout.hpp"
+#include "SparseletConvolutionEngine.hpp"
+#include "TaskScheduler.hpp"
+using namespace std;
+using namespace cv;
+
+/*! @brief normalize each row of a matrix to unit length
+ *
+ * @param dictionary the matrix to normalize in place
+ */
+static void normalizeRows(Mat& dictionary) {
+	for (int k = 0; k < dictionary.rows; ++k) {
+		Mat atom = dictionary.row(k);
+		const double len = norm(atom);
+		if (len > 0) atom /= len;
+	}
+}
+
+SparseletConvolutionEngine::SparseletConvolutionEngine(int type, size_t flen, size_t block, size_t sparsity) :
+	type_(type), flen_(flen), block_(block), sparsity_(sparsity), bound_(NULL) {}
+
+SparseletConvolutionEngine::~SparseletConvolutionEngine() {
+}
+
+/*! @brief sparse code a sample by orthogonal matching pursuit
+ *
+ * @param dictionary the dictionary, one unit-norm atom per row (CV_64F)
+ * @param sample the sample to code, a single row (CV_64F)
+ * @param sparsity the maximum number of atoms
+ * @param support the atoms chosen
+ * @param coefficients the least squares weights of the chosen atoms (a column)
+ */
+void SparseletConvolutionEngine::code(const Mat& dictionary, const Mat& sample, size_t sparsity, vectori& support, Mat& coefficients) {
+
+	support.clear();
+	coefficients = Mat();
+	const double tolerance = 1e-9 * norm(sample);
+	Mat residual = sample.clone();
+	vector<bool> used(dictionary.rows, false);
+
+	while (support.size() < sparsity && norm(residual) > tolerance) {
+		// choose the atom most correlated with the residual
+		Mat correlation = dictionary * residual.t();
+		int best = -1;
+		double best_value = 0;
+		for (int k = 0; k < dictionary.rows; ++k) {
+			const double value = fabs(correlation.at<double>(k));
+			if (!used[k] && value > best_value) { best = k; best_value = value; }
+		}
+		if (best < 0) break;
+		used[best] = true;
+		support.push_back(best);
+
+		// refit the weights of all chosen atoms
+		Mat atoms(support.size(), dictionary.cols, CV_64F);
+		for (size_t s = 0; s < support.size(); ++s) dictionary.row(support[s]).copyTo(atoms.row(s));
+		solve(atoms.t(), sample.t(), coefficients, DECOMP_SVD);
+		residual = sample - (atoms.t() * coefficients).t();
+	}
+}
+
+/*! @brief divide a filter into blocks
+ *
+ * The filter is zero-padded on the bottom and right to a multiple of the
+ * block size. Blocks which are entirely zero are skipped
+ *
+ * @param filter the filter (fh x fw*flen)
+ * @param samples the blocks, one per row (CV_64F)
+ * @param offsets the offset (in cells) of each block within the filter
+ */
+void SparseletConvolutionEngine::blocks(const Mat& filter, Mat& samples, vector<Point>& offsets) const {
+
+	const int b  = block_;
+	const int fw = filter.cols / flen_;
+	const int by = (filter.rows + b-1) / b;
+	const int bx = (fw + b-1) / b;
+	Mat padded = Mat::zeros(by*b, bx*b*flen_, CV_64F);
+	filter.convertTo(padded(Rect(0, 0, filter.cols, filter.rows)), CV_64F);
+
+	samples = Mat();
+	offsets.clear();
+	for (int y = 0; y < by; ++y) {
+		for (int x = 0; x < bx; ++x) {
+			Mat sample = padded(Rect(x*b*flen_, y*b, b*flen_, b)).clone().reshape(1, 1);
+			if (countNonZero(sample) == 0) continue;
+			samples.push_back(sample);
+			offsets.push_back(Point(x*b, y*b));
+		}
+	}
+}
+
+/*! @brief learn a dictionary from a bank of filters
+ *
+ * Alternates sparse coding of every block of every filter by orthogonal
+ * matching pursuit with the method of optimal directions (the least squares
+ * dictionary for the current codes). Atoms which fall out of use are replaced
+ * by the worst represented block
+ *
+ * @param filters the filters, typically of several models
+ * @param natoms the number of atoms
+ * @param iterations the number of iterations
+ */
+void SparseletConvolutionEngine::learn(const vectorMat& filters, size_t natoms, size_t iterations) {
+
+	// gather the blocks
+	Mat samples;
+	for (size_t n = 0; n < filters.size(); ++n) {
+		Mat s;
+		vector<Point> offsets;
+		blocks(filters[n], s, offsets);
+		if (!s.empty()) samples.push_back(s);
+	}
+	if (samples.empty()) return;
+	const int S = samples.rows;
+	natoms = std::min(natoms, (size_t)S);
+
+	// initialize with evenly spaced samples
+	Mat dictionary(natoms, samples.cols, CV_64F);
+	for (size_t k = 0; k < natoms; ++k) samples.row(k * S / natoms).copyTo(dictionary.row(k));
+	normalizeRows(dictionary);
+
+	for (size_t it = 0; it < iterations; ++it) {
+
+		// sparse code every sample
+		Mat C = Mat::zeros(natoms, S, CV_64F);
+		vector<double> error(S);
+		for (int s = 0; s < S; ++s) {
+			vectori support;
+			Mat coefficients;
+			code(dictionary, samples.row(s), sparsity_, support, coefficients);
+			Mat approx = Mat::zeros(1, samples.cols, CV_64F);
+			for (size_t a = 0; a < support.size(); ++a) {
+				C.at<double>(support[a], s) = coefficients.at<double>(a);
+				approx += coefficients.at<double>(a) * dictionary.row(support[a]);
+			}
+			error[s] = norm(samples.row(s) - approx);
+		}
+
+		// method of optimal directions: D = argmin ||C' D - X||
+		Mat updated;
+		solve(C * C.t(), C * samples, updated, DECOMP_SVD);
+
+		// replace unused atoms with the worst represented samples
+		for (size_t k = 0; k < natoms; ++k) {
+			if (countNonZero(C.row(k)) > 0) continue;
+			const int worst = max_element(error.begin(), error.end()) - error.begin();
+			samples.row(worst).copyTo(updated.row(k));
+			error[worst] = 0;
+		}
+		normalizeRows(updated);
+		dictionary = updated;
+	}
+	dictionary_ = dictionary;
+}
+
+/*! @brief set the dictionary
+ *
+ * @param dictionary the dictionary, one atom of block*block*flen per row
+ */
+void SparseletConvolutionEngine::setDictionary(const Mat& dictionary) {
+	assert(dictionary.cols == (int)(block_*block_*flen_));
+	dictionary.convertTo(dictionary_, CV_64F);
+	normalizeRows(dictionary_);
+	dictionary_.convertTo(typed_, type_);
+}
+
+/*! @brief save the dictionary
+ *
+ * @param filename the file to write
+ * @return true if the dictionary was written
+ */
+bool SparseletConvolutionEngine::save(const std::string& filename) const {
+	FileStorage fs;
+	if (!fs.open(filename, FileStorage::WRITE)) return false;
+	fs << "block" << (int)block_;
+	fs << "flen" << (int)flen_;
+	fs << "dictionary" << dictionary_;
+	fs.release();
+	return true;
+}
+
+/*! @brief load a dictionary
+ *
+ * @param filename the file to read
+ * @return true if a dictionary of the engine's feature length was read, with
+ * atoms of block x block cells. Otherwise the engine is left unchanged
+ */
+bool SparseletConvolutionEngine::load(const std::string& filename) {
+	FileStorage fs;
+	if (!fs.open(filename, FileStorage::READ)) return false;
+	int block, flen;
+	Mat dictionary;
+	fs["block"] >> block;
+	fs["flen"] >> flen;
+	fs["dictionary"] >> dictionary;
+	if (flen != (int)flen_ || block <= 0 || dictionary.empty()) return false;
+	if (dictionary.cols != block*block*(int)flen_) return false;
+	block_ = block;
+	setDictionary(dictionary);
+	return true;
+}
+
+/*! @brief set the filters
+ *
+ * sparse code each block of each filter against the dictionary. If no
+ * dictionary has been set, one is learned from the filters themselves
+ *
+ * @param filters the filters
+ */
+void SparseletConvolutionEngine::setFilters(const vectorMat& filters) {
+
+	const size_t N = filters.size();
+	if (dictionary_.empty()) learn(filters, 128);
+	dictionary_.convertTo(typed_, type_);
+	codes_.clear();
+	codes_.resize(N);
+	fsize_.resize(N);
+	residual_.resize(N);
+	pad_ = Size(0,0);
+
+	for (size_t n = 0; n < N; ++n) {
+		fsize_[n] = Size(filters[n].cols / flen_, filters[n].rows);
+		pad_.width  = std::max(pad_.width,  (int)((fsize_[n].width  + block_-1) / block_ * block_));
+		pad_.height = std::max(pad_.height, (int)((fsize_[n].height + block_-1) / block_ * block_));
+
+		Mat samples;
+		vector<Point> offsets;
+		blocks(filters[n], samples, offsets);
+		double error = 0, energy = 0;
+		for (int s = 0; s < samples.rows; ++s) {
+			vectori support;
+			Mat coefficients;
+			code(dictionary_, samples.row(s), sparsity_, support, coefficients);
+			Mat approx = Mat::zeros(1, samples.cols, CV_64F);
+			for (size_t a = 0; a < support.size(); ++a) {
+				const double alpha = coefficients.at<double>(a);
+				codes_[n].push_back(Term(support[a], offsets[s].y, offsets[s].x, alpha));
+				approx += alpha * dictionary_.row(support[a]);
+			}
+			const double e = norm(samples.row(s) - approx);
+			const double x = norm(samples.row(s));
+			error  += e*e;
+			energy += x*x;
+		}
+		residual_[n] = energy > 0 ? sqrt(error / energy) : 0;
+	}
+}
+
+//! the average number of terms per filter
+double SparseletConvolutionEngine::termsPerFilter(void) const {
+	double terms = 0;
+	for (size_t n = 0; n < codes_.size(); ++n) terms += codes_[n].size();
+	return codes_.empty() ? 0 : terms / codes_.size();
+}
+
+/*! @brief pad a feature
+ *
+ * The padding is zero, except for the last channel which is one, as in
+ * the SpatialConvolutionEngine
+ *
+ * @param feature the feature of a level
+ * @param padded the padded feature
+ */
+void SparseletConvolutionEngine::pad(const Mat& feature, Mat& padded) const {
+
+	// error checking
+	assert(feature.depth() == type_);
+
+	const int rows = feature.rows;
+	const int cols = feature.cols / flen_;
+	copyMakeBorder(feature, padded, pad_.height, pad_.height, pad_.width*flen_, pad_.width*flen_, BORDER_CONSTANT, Scalar::all(0));
+	const Rect cells(pad_.width, pad_.height, cols, rows);
+	if (type_ == CV_32F) FeatureLayout::fillOcclusion<float>(padded, cells, cols + 2*pad_.width, flen_, 1);
+	else                 FeatureLayout::fillOcclusion<double>(padded, cells, cols + 2*pad_.width, flen_, 1);
+}
+
+/*! @brief pad a single level of the feature pyramid
+ *
+ * @param features the feature pyramid
+ * @param padded the padded levels
+ * @param m the level to pad
+ */
+void SparseletConvolutionEngine::padLevel(const vectorMat& features, vectorMat& padded, size_t m) const {
+	pad(features[m], padded[m]);
+}
+
+/*! @brief correlate a band of rows of a padded feature with every atom
+ *
+ * The patches under each output row are gathered into a matrix and
+ * multiplied with the whole dictionary at once
+ *
+ * @param feature the padded feature
+ * @param responses the preallocated response of each atom
+ * @param y0 the first row of the band
+ * @param y1 one past the last row of the band
+ */
+void SparseletConvolutionEngine::atoms(const Mat& feature, vectorMat& responses, size_t y0, size_t y1) const {
+
+	const int b = block_;
+	const int K = typed_.rows;
+	const int cols = responses[0].cols;
+	const size_t rowlen = b * flen_ * feature.elemSize();
+	Mat patches(cols, typed_.cols, type_);
+	Mat out;
+	for (size_t y = y0; y < y1; ++y) {
+		for (int x = 0; x < cols; ++x) {
+			uchar* dst = patches.ptr(x);
+			for (int i = 0; i < b; ++i) {
+				memcpy(dst + i*rowlen, feature.ptr(y+i) + x*flen_*feature.elemSize(), rowlen);
+			}
+		}
+		gemm(typed_, patches, 1, Mat(), 0, out, GEMM_2_T);
+		for (int k = 0; k < K; ++k) out.row(k).copyTo(responses[k].row(y));
+	}
+}
+
+/*! @brief correlate a single band of rows of a padded feature with every atom
+ *
+ * @param feature the padded feature
+ * @param responses the preallocated response of each atom
+ * @param bounds the band boundaries, bounds[b] to bounds[b+1] is band b
+ * @param b the band
+ */
+void SparseletConvolutionEngine::atomsBand(const Mat& feature, vectorMat& responses, const vector<size_t>& bounds, size_t b) const {
+	atoms(feature, responses, bounds[b], bounds[b+1]);
+}
+
+/*! @brief combine the atom responses of a level into the response of a single filter
+ *
+ * @param atoms the atom responses of the level
+ * @param feature the (unpadded) feature of the level
+ * @param n the filter
+ * @param response the response to return
+ */
+void SparseletConvolutionEngine::combine(const vectorMat& atoms, const Mat& feature, size_t n, Mat& response) {
+
+	const int rows = feature.rows;
+	const int cols = feature.cols / flen_;
+	const Point anchor(fsize_[n].width/2, fsize_[n].height/2);
+
+	response = Mat::zeros(rows, cols, type_);
+	const vector<Term>& terms = codes_[n];
+	for (size_t t = 0; t < terms.size(); ++t) {
+		const Term& term = terms[t];
+		const Rect roi(pad_.width - anchor.x + term.dx, pad_.height - anchor.y + term.dy, cols, rows);
+		scaleAdd(atoms[term.atom](roi), term.alpha, response, response);
+	}
+}
+
+/*! @brief reconstruct the response of a single filter at a single level
+ *
+ * @param atoms the atom responses of each level
+ * @param responses the responses to write into
+ * @param features the feature pyramid
+ * @param mn the index of the (level, filter) pair
+ */
+void SparseletConvolutionEngine::reconstruct(const vector2DMat& atoms, vector2DMat& responses, const vectorMat& features, size_t mn) {
+	const size_t N = codes_.size();
+	const size_t m = mn / N;
+	const size_t n = mn % N;
+	combine(atoms[m], features[m], n, responses[m][n]);
+}
+
+/*! @brief Calculate the responses of a set of features to a set of filter experts
+ *
+ * Each level is convolved with every atom of the dictionary (in bands of
+ * rows), and the response of each filter is then reconstructed from its
+ * sparse code, with all work scheduled on the global TaskScheduler
+ *
+ * @param features the input features (at different scales, and by extension, size)
+ * @param responses the vector of responses (pdfs) to return
+ */
+void SparseletConvolutionEngine::pdf(const vectorMat& features, vector2DMat& responses) {
+
+	// preallocate the output
+	const size_t M = features.size();
+	const size_t N = codes_.size();
+	const size_t K = typed_.rows;
+	const int b = block_;
+	responses.resize(M, vectorMat(N));
+	TaskScheduler& scheduler = TaskScheduler::global();
+
+	// pad each level
+	vectorMat padded(M);
+	vector<double> costs(M);
+	for (size_t m = 0; m < M; ++m) costs[m] = features[m].total();
+	scheduler.parallelFor(M, boost::bind(&SparseletConvolutionEngine::padLevel, this, boost::cref(features), boost::ref(padded), _1), costs);
+
+	// convolve each level with each atom, in bands of rows
+	vector2DMat atomr(M, vectorMat(K));
+	double total = 0;
+	for (size_t m = 0; m < M; ++m) total += padded[m].total();
+	const double share = total / (4 * scheduler.nthreads());
+	vector<Task> tasks;
+	vector<size_t> bounds;
+	costs.clear();
+	for (size_t m = 0; m < M; ++m) {
+		const int rows = padded[m].rows - b + 1;
+		const int cols = padded[m].cols / flen_ - b + 1;
+		for (size_t k = 0; k < K; ++k) atomr[m][k].create(rows, cols, type_);
+		TaskScheduler::bands(rows, 4, ceil(padded[m].total() / share), bounds);
+		for (size_t i = 0; i < bounds.size()-1; ++i) {
+			tasks.push_back(boost::bind(&SparseletConvolutionEngine::atoms, this, boost::cref(padded[m]), boost::ref(atomr[m]), bounds[i], bounds[i+1]));
+			costs.push_back((double)padded[m].total() * (bounds[i+1] - bounds[i]) / rows);
+		}
+	}
+	TaskGroup group;
+	scheduler.run(group, tasks, costs);
+	scheduler.wait(group);
+	padded.clear();
+
+	// reconstruct each response from the sparse codes
+	costs.resize(M*N);
+	for (size_t mn = 0; mn < M*N; ++mn) costs[mn] = features[mn / N].total() * codes_[mn % N].size();
+	scheduler.parallelFor(M*N, boost::bind(&SparseletConvolutionEngine::reconstruct, this, boost::cref(atomr), boost::ref(responses), boost::cref(features), _1), costs);
+}
+
+/*! @brief bind a pyramid of features for on-demand responses
+ *
+ * @param features the input features
+ */
+void SparseletConvolutionEngine::bind(const vectorMat& features) {
+	bound_ = &features;
+	atomr_.clear();
+	atomr_.resize(features.size());
+}
+
+/*! @brief pad a level of the bound pyramid and convolve it with every atom
+ *
+ * The caller holds the level's lock, and every response of the level
+ * waits on it, so the atoms are convolved in bands of rows across the
+ * scheduler, as pdf() does. The calling thread only helps with its own
+ * bands while it waits
+ *
+ * @param m the level
+ */
+void SparseletConvolutionEngine::prepare(size_t m) {
+	Mat padded;
+	pad((*bound_)[m], padded);
+	const int b = block_;
+	const int rows = padded.rows - b + 1;
+	const int cols = padded.cols / flen_ - b + 1;
+	atomr_[m].resize(typed_.rows);
+	for (size_t k = 0; k < atomr_[m].size(); ++k) atomr_[m][k].create(rows, cols, type_);
+
+	TaskScheduler& scheduler = TaskScheduler::global();
+	vector<size_t> bounds;
+	TaskScheduler::bands(rows, 4, 4 * scheduler.nthreads(), bounds);
+	vector<Task> tasks;
+	vector<double> costs;
+	for (size_t i = 0; i+1 < bounds.size(); ++i) {
+		tasks.push_back(boost::bind(&SparseletConvolutionEngine::atomsBand, this, boost::cref(padded), boost::ref(atomr_[m]), boost::cref(bounds), i));
+		costs.push_back(bounds[i+1] - bounds[i]);
+	}
+	TaskGroup group;
+	scheduler.run(group, tasks, costs);
+	scheduler.waitIsolated(group);
+}
+
+/*! @brief reconstruct the response of a single filter at a prepared level
+ *
+ * @param m the level
+ * @param n the filter
+ * @param response the response to return
+ */
+void SparseletConvolutionEngine::response(size_t m, size_t n, Mat& response) {
+	combine(atomr_[m], (*bound_)[m], n, response);
+}
+
+//! the size of the responses at level m of the bound pyramid
+Size SparseletConvolutionEngine::responseSize(size_t m) const {
+	return Size((*bound_)[m].cols / flen_, (*bound_)[m].rows);
+}
+
+//! release the bound pyramid and its atom responses
+void SparseletConvolutionEngine::release(void) {
+	bound_ = NULL;
+	atomr_.clear();
+}
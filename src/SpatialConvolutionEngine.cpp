@@ -36,22 +36,79 @@
  *  Created: Oct 9, 2012 
  */
 
-#ifdef _OPENMP
-#include <omp.h>
-#endif
 #include <cassert>
+#include <boost/bind.hpp>
+#include "FeatureLayout.hpp"
 #include "SpatialConvolutionEngine.hpp"
+#include "TaskScheduler.hpp"
 using namespace std;
 using namespace cv;
 
 SpatialConvolutionEngine::SpatialConvolutionEngine(int type, size_t flen) :
-	type_(type), flen_(flen) {}
+	type_(type), flen_(flen), bound_(NULL) {}
+
+/*! @brief the preferred feature format
+ *
+ * The engine convolves channel planes, so it prefers PLANAR features,
+ * padded by the size of the largest filter. Valid after setFilters()
+ */
+FeatureFormat SpatialConvolutionEngine::preferredFormat(void) const {
+	return FeatureFormat(FeatureFormat::PLANAR, pad_);
+}
+
+/*! @brief set the format of the features
+ *
+ * The engine accepts INTERLEAVED features, and PLANAR features with any padding
+ *
+ * @param format the format of the features passed to pdf()
+ */
+void SpatialConvolutionEngine::setFormat(const FeatureFormat& format) {
+	format_ = format;
+}
 
 SpatialConvolutionEngine::~SpatialConvolutionEngine() {
 	// TODO Auto-generated destructor stub
 }
 
-/*! @brief Convolve two matrices, with a stride of greater than one
+/*! @brief Split and pad a feature into separate channel planes
+ *
+ * Each plane is padded by the size of the largest filter, so that
+ * convolutions over any band of rows can be computed without reference
+ * to the rest of the plane. The first flen_-1 channels are zero-padded,
+ * the last channel is one-padded.
+ *
+ * PLANAR features padded as preferredFormat() requests are used in place.
+ * INTERLEAVED features are de-interleaved and padded in a single pass,
+ * unrolled for the standard feature length
+ *
+ * @param features the feature pyramid
+ * @param planes the padded planes of each level of the pyramid
+ * @param m the level to split
+ */
+void SpatialConvolutionEngine::split(const vectorMat& features, vector2DMat& planes, size_t m) {
+
+	// error checking
+	assert(features[m].depth() == type_);
+
+	if (format_.layout == FeatureFormat::PLANAR) {
+		FeatureLayout::planes(features[m], flen_, planes[m]);
+		if (format_.pad == pad_) return;
+
+		// planes padded for another engine must be padded again
+		const Size cells = FeatureLayout::cells(features[m], flen_, format_);
+		const Rect interior(format_.pad.width, format_.pad.height, cells.width, cells.height);
+		for (size_t c = 0; c < flen_; ++c) {
+			const double value = (c == flen_-1) ? 1 : 0;
+			Mat plane = planes[m][c](interior);
+			copyMakeBorder(plane, planes[m][c], pad_.height, pad_.height, pad_.width, pad_.width, BORDER_CONSTANT | BORDER_ISOLATED, Scalar::all(value));
+		}
+		return;
+	}
+	if (type_ == CV_32F) FeatureLayout::splitPadded<float>(features[m], flen_, pad_, planes[m]);
+	else                 FeatureLayout::splitPadded<double>(features[m], flen_, pad_, planes[m]);
+}
+
+/*! @brief Convolve a band of rows of a feature with a filter
  *
  * This is a specialized 2D convolution algorithm with a stride of greater
  * than one. It is designed to convolve a filter with a feature, where at
@@ -60,32 +117,25 @@ SpatialConvolutionEngine::~SpatialConvolutionEngine() {
  * (i,j) dimension is the spatial plane and the (k) dimension is the SVM weights
  * of the pixels.
  *
- * The function supports multithreading via OpenMP
+ * Only rows [y0, y1) of the response are computed, so a single large
+ * convolution can be spread across several threads
  *
- * @param feature the feature matrix
- * @param filter the filter (SVM)
- * @param pdf the response to return
- * @param stride the SVM weight length
+ * @param planes the padded channel planes of the feature
+ * @param n the filter (SVM)
+ * @param pdf the preallocated response to write into
+ * @param y0 the first row of the band
+ * @param y1 one past the last row of the band
  */
-void SpatialConvolutionEngine::convolve(const Mat& feature, vectorFilterEngine& filter, Mat& pdf, const size_t stride) {
+void SpatialConvolutionEngine::convolve(const vectorMat& planes, size_t n, Mat& pdf, size_t y0, size_t y1) {
 
-	// error checking
-	assert(feature.depth() == type_);
-
-	// split the feature into separate channels
-	vectorMat featurev;
-	split(feature.reshape(stride), featurev);
-
-	// calculate the output
-	Rect roi(0,0,-1,-1); // full image
-	Point offset(0,0);
-	Size fsize = featurev[0].size();
-	pdf = Mat::zeros(fsize, type_);
-
-	for (size_t c = 0; c < stride; ++c) {
-		Mat pdfc(fsize, type_);
-		filter[c]->apply(featurev[c], pdfc, roi, offset, true);
-		pdf += pdfc;
+	// the band, plus a halo of padding above and below
+	Mat band = pdf.rowRange(y0, y1);
+	Rect roi(pad_.width, pad_.height, pdf.cols, y1-y0);
+	Mat pdfc;
+	for (size_t c = 0; c < flen_; ++c) {
+		Mat src = planes[c].rowRange(y0, y1 + 2*pad_.height);
+		filter2D(src, pdfc, type_, filters_[n][c], Point(-1,-1), 0, BORDER_CONSTANT | BORDER_ISOLATED);
+		band += pdfc(roi);
 	}
 }
 
@@ -96,6 +146,10 @@ void SpatialConvolutionEngine::convolve(const Mat& feature, vectorFilterEngine&
  * the feature map. Parts are support vector machines (SVMs) represented as filters.
  * The convolution of a filter with a feature produces a probability density function
  * (pdf) of part location
+ *
+ * The work is split into tasks by level, filter and (for the larger levels)
+ * bands of rows, and scheduled largest-first on the global TaskScheduler
+ *
  * @param features the input features (at different scales, and by extension, size)
  * @param responses the vector of responses (pdfs) to return
  */
@@ -105,18 +159,100 @@ void SpatialConvolutionEngine::pdf(const vectorMat& features, vector2DMat& respo
 	const size_t M = features.size();
 	const size_t N = filters_.size();
 	responses.resize(M, vectorMat(N));
+	TaskScheduler& scheduler = TaskScheduler::global();
 
-	// iterate
-#ifdef _OPENMP
-	#pragma omp parallel for
-#endif
-	for (size_t n = 0; n < N; ++n) {
-		for (size_t m = 0; m < M; ++m) {
-			Mat response;
-			convolve(features[m], filters_[n], response, flen_);
-			responses[m][n] = response;
+	// split each level into padded planes once, up front
+	vector2DMat planes(M);
+	vector<double> costs(M);
+	for (size_t m = 0; m < M; ++m) costs[m] = features[m].total();
+	scheduler.parallelFor(M, boost::bind(&SpatialConvolutionEngine::split, this, boost::cref(features), boost::ref(planes), _1), costs);
+
+	// estimate the cost of each convolution
+	double total = 0;
+	vector<double> fcosts(N);
+	for (size_t n = 0; n < N; ++n) fcosts[n] = filters_[n][0].total();
+	for (size_t m = 0; m < M; ++m) for (size_t n = 0; n < N; ++n) total += features[m].total() * fcosts[n];
+
+	// split the convolutions which are larger than a fair share of the work into bands
+	const double share = total / (4 * scheduler.nthreads());
+	vector<Task> tasks;
+	costs.clear();
+	vector<size_t> bounds;
+	for (size_t m = 0; m < M; ++m) {
+		const Size cells = FeatureLayout::cells(features[m], flen_, format_);
+		const int rows = cells.height;
+		const int cols = cells.width;
+		for (size_t n = 0; n < N; ++n) {
+			responses[m][n] = Mat::zeros(rows, cols, type_);
+			const double cost = features[m].total() * fcosts[n];
+			TaskScheduler::bands(rows, 4, ceil(cost / share), bounds);
+			for (size_t b = 0; b < bounds.size()-1; ++b) {
+				tasks.push_back(boost::bind(&SpatialConvolutionEngine::convolve, this, boost::cref(planes[m]), n, boost::ref(responses[m][n]), bounds[b], bounds[b+1]));
+				costs.push_back(cost * (bounds[b+1] - bounds[b]) / rows);
+			}
 		}
 	}
+	TaskGroup group;
+	scheduler.run(group, tasks, costs);
+	scheduler.wait(group);
+}
+
+/*! @brief bind a pyramid of features for on-demand responses
+ *
+ * @param features the input features
+ */
+void SpatialConvolutionEngine::bind(const vectorMat& features) {
+	bound_ = &features;
+	planes_.clear();
+	planes_.resize(features.size());
+}
+
+/*! @brief split a level of the bound pyramid into padded planes
+ *
+ * @param m the level
+ */
+void SpatialConvolutionEngine::prepare(size_t m) {
+	split(*bound_, planes_, m);
+}
+
+/*! @brief compute the response of a single filter at a prepared level
+ *
+ * The caller holds the response's lock, and the dynamic program may wait
+ * on it, so the filter is convolved in bands of rows across the scheduler,
+ * as pdf() does. The calling thread only helps with its own bands while it
+ * waits
+ *
+ * @param m the level
+ * @param n the filter
+ * @param response the response to return
+ */
+void SpatialConvolutionEngine::response(size_t m, size_t n, Mat& response) {
+	const Size cells = FeatureLayout::cells((*bound_)[m], flen_, format_);
+	response = Mat::zeros(cells.height, cells.width, type_);
+
+	TaskScheduler& scheduler = TaskScheduler::global();
+	vector<size_t> bounds;
+	TaskScheduler::bands(cells.height, 4, 4 * scheduler.nthreads(), bounds);
+	vector<Task> tasks;
+	vector<double> costs;
+	for (size_t b = 0; b+1 < bounds.size(); ++b) {
+		tasks.push_back(boost::bind(&SpatialConvolutionEngine::convolve, this, boost::cref(planes_[m]), n, boost::ref(response), bounds[b], bounds[b+1]));
+		costs.push_back(bounds[b+1] - bounds[b]);
+	}
+	TaskGroup group;
+	scheduler.run(group, tasks, costs);
+	scheduler.waitIsolated(group);
+}
+
+//! the size of the responses at level m of the bound pyramid
+Size SpatialConvolutionEngine::responseSize(size_t m) const {
+	return FeatureLayout::cells((*bound_)[m], flen_, format_);
+}
+
+//! release the bound pyramid and its planes
+void SpatialConvolutionEngine::release(void) {
+	bound_ = NULL;
+	planes_.clear();
 }
 
 /*! @brief set the filters
@@ -131,25 +267,12 @@ void SpatialConvolutionEngine::setFilters(const vectorMat& filters) {
 	const size_t N = filters.size();
 	filters_.clear();
 	filters_.resize(N);
+	pad_ = Size(0,0);
 
-	// split each filter into separate channels, and create a filter engine
-	const size_t C = flen_;
+	// split each filter into separate channels
 	for (size_t n = 0; n < N; ++n) {
-		vectorMat filtervec;
-		std::vector<Ptr<FilterEngine> > filter_engines(C);
-		split(filters[n].reshape(C), filtervec);
-
-		// the first N-1 filters have zero-padding
-		for (size_t m = 0; m < C-1; ++m) {
-			Ptr<FilterEngine> fe = createLinearFilter(type_, type_,
-					filtervec[m], Point(-1,-1), 0, BORDER_CONSTANT, -1, Scalar(0,0,0,0));
-			filter_engines[m] = fe;
-		}
-
-		// the last filter has one-padding
-		Ptr<FilterEngine> fe = createLinearFilter(type_, type_,
-				filtervec[C-1], Point(-1,-1), 0, BORDER_CONSTANT, -1, Scalar(1,1,1,1));
-		filter_engines[C-1] = fe;
-		filters_[n] = filter_engines;
+		cv::split(filters[n].reshape(flen_), filters_[n]);
+		pad_.width  = max(pad_.width,  filters_[n][0].cols);
+		pad_.height = max(pad_.height, filters_[n][0].rows);
 	}
 }
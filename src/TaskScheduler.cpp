@@ -0,0 +1,412 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    TaskScheduler.cpp
+ *  Created: Oct 16, 2026
+ */
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+#include <boost/bind.hpp>
+#include "TaskScheduler.hpp"
+using namespace std;
+
+// the scheduler and worker index of the calling thread, if it is a worker
+static __thread TaskScheduler* tls_scheduler = NULL;
+static __thread size_t tls_worker = 0;
+
+// order indices by decreasing cost
+struct DescendingCost {
+	const vector<double>& costs;
+	DescendingCost(const vector<double>& c) : costs(c) {}
+	bool operator()(size_t a, size_t b) const { return costs[a] > costs[b]; }
+};
+
+TaskScheduler::TaskScheduler(size_t nthreads, bool affinity) :
+	queued_(0), next_(0), stop_(false), affinity_(false) {
+	start(nthreads, affinity);
+}
+
+TaskScheduler::~TaskScheduler() {
+	shutdown();
+}
+
+/*! @brief the scheduler shared by the detector stages
+ *
+ * The global scheduler is created on first use with one thread per
+ * hardware thread, and no affinity
+ */
+TaskScheduler& TaskScheduler::global(void) {
+	static TaskScheduler scheduler;
+	return scheduler;
+}
+
+/*! @brief change the number of threads and the affinity of the scheduler
+ *
+ * This joins and recreates the workers, so it must not be called while
+ * tasks are in flight
+ *
+ * @param nthreads the total number of threads, including the calling
+ * thread. 0 selects the number of hardware threads
+ * @param affinity pin each worker to its own core
+ */
+void TaskScheduler::configure(size_t nthreads, bool affinity) {
+	if (nthreads == 0) nthreads = max(boost::thread::hardware_concurrency(), 1u);
+	if (nthreads == this->nthreads() && affinity == affinity_) return;
+	shutdown();
+	start(nthreads, affinity);
+}
+
+void TaskScheduler::start(size_t nthreads, bool affinity) {
+	if (nthreads == 0) nthreads = max(boost::thread::hardware_concurrency(), 1u);
+	stop_ = false;
+	queued_ = 0;
+	affinity_ = affinity;
+	for (size_t n = 0; n < nthreads-1; ++n) workers_.push_back(new Worker);
+	for (size_t n = 0; n < nthreads-1; ++n) {
+		threads_.push_back(new boost::thread(boost::bind(&TaskScheduler::workerLoop, this, n)));
+	}
+}
+
+void TaskScheduler::shutdown(void) {
+	{
+		boost::unique_lock<boost::mutex> lock(sleep_mutex_);
+		stop_ = true;
+		wakeup_.notify_all();
+	}
+	for (size_t n = 0; n < threads_.size(); ++n) {
+		threads_[n]->join();
+		delete threads_[n];
+	}
+	for (size_t n = 0; n < workers_.size(); ++n) delete workers_[n];
+	threads_.clear();
+	workers_.clear();
+}
+
+/*! @brief the main loop of a worker thread
+ *
+ * @param self the index of the worker
+ */
+void TaskScheduler::workerLoop(size_t self) {
+
+	tls_scheduler = this;
+	tls_worker    = self;
+
+#ifdef __linux__
+	// pin the worker to a core, leaving the first core to the calling thread
+	if (affinity_) {
+		const long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+		if (ncpus > 0) {
+			cpu_set_t cpuset;
+			CPU_ZERO(&cpuset);
+			CPU_SET((self+1) % ncpus, &cpuset);
+			pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+		}
+	}
+#endif
+
+	while (true) {
+		Job job;
+		if (pop(self, job) || steal(self, job)) {
+			execute(job);
+			continue;
+		}
+		boost::unique_lock<boost::mutex> lock(sleep_mutex_);
+		if (stop_) break;
+		if (queued_ <= 0) wakeup_.wait(lock);
+	}
+}
+
+/*! @brief push a job onto a worker's deque
+ *
+ * The caller is responsible for waking the workers
+ */
+void TaskScheduler::push(size_t worker, const Job& job, bool front) {
+	__sync_add_and_fetch(&queued_, 1);
+	boost::unique_lock<boost::mutex> lock(workers_[worker]->mutex);
+	if (front) workers_[worker]->jobs.push_front(job);
+	else       workers_[worker]->jobs.push_back(job);
+}
+
+//! pop the next job from the front of the worker's own deque
+bool TaskScheduler::pop(size_t self, Job& job) {
+	Worker& worker = *workers_[self];
+	boost::unique_lock<boost::mutex> lock(worker.mutex);
+	if (worker.jobs.empty()) return false;
+	job = worker.jobs.front();
+	worker.jobs.pop_front();
+	__sync_sub_and_fetch(&queued_, 1);
+	return true;
+}
+
+//! steal a job from the back of another worker's deque
+bool TaskScheduler::steal(size_t self, Job& job) {
+	const size_t W = workers_.size();
+	const size_t start = (self < W) ? self+1 : (size_t)next_;
+	for (size_t k = 0; k < W; ++k) {
+		const size_t victim = (start + k) % W;
+		if (victim == self) continue;
+		Worker& worker = *workers_[victim];
+		boost::unique_lock<boost::mutex> lock(worker.mutex);
+		if (worker.jobs.empty() || worker.jobs.back().pinned) continue;
+		job = worker.jobs.back();
+		worker.jobs.pop_back();
+		__sync_sub_and_fetch(&queued_, 1);
+		return true;
+	}
+	return false;
+}
+
+//! acquire a job on behalf of the calling thread, which may not be a worker
+bool TaskScheduler::acquire(Job& job) {
+	if (tls_scheduler == this) return pop(tls_worker, job) || steal(tls_worker, job);
+	return steal(workers_.size(), job);
+}
+
+//! run a job and signal its group
+void TaskScheduler::execute(Job& job) {
+	TaskGroup& group = *job.group;
+	std::string error;
+	try {
+		job.task();
+	} catch (const std::exception& e) {
+		error = e.what();
+	} catch (...) {
+		error = "unknown exception in task";
+	}
+	boost::unique_lock<boost::mutex> lock(group.mutex_);
+	if (!error.empty() && group.error_.empty()) group.error_ = error;
+	if (--group.pending_ == 0) group.finished_.notify_all();
+}
+
+/*! @brief run a task asynchronously as part of a group
+ *
+ * Tasks spawned from a worker go to the front of that worker's deque, so
+ * nested work is executed depth-first and stolen breadth-first
+ *
+ * @param group the group the task belongs to
+ * @param task the task
+ */
+void TaskScheduler::run(TaskGroup& group, const Task& task) {
+	{
+		boost::unique_lock<boost::mutex> lock(group.mutex_);
+		group.pending_++;
+	}
+	Job job(task, &group);
+	if (workers_.empty()) {
+		execute(job);
+		return;
+	}
+	if (tls_scheduler == this) push(tls_worker, job, true);
+	else push(__sync_fetch_and_add(&next_, 1) % workers_.size(), job, false);
+	boost::unique_lock<boost::mutex> lock(sleep_mutex_);
+	wakeup_.notify_one();
+}
+
+/*! @brief run a batch of tasks asynchronously, largest first
+ *
+ * The tasks are sorted by decreasing cost and dealt round-robin across the
+ * workers, so that each worker starts on the largest task of its share
+ *
+ * @param group the group the tasks belong to
+ * @param tasks the tasks
+ * @param costs an estimate of the relative cost of each task
+ */
+void TaskScheduler::run(TaskGroup& group, const vector<Task>& tasks, const vector<double>& costs) {
+
+	const size_t N = tasks.size();
+	assert(costs.size() == N);
+	vector<size_t> order(N);
+	for (size_t n = 0; n < N; ++n) order[n] = n;
+	std::stable_sort(order.begin(), order.end(), DescendingCost(costs));
+
+	{
+		boost::unique_lock<boost::mutex> lock(group.mutex_);
+		group.pending_ += N;
+	}
+	if (workers_.empty()) {
+		for (size_t n = 0; n < N; ++n) {
+			Job job(tasks[order[n]], &group);
+			execute(job);
+		}
+		return;
+	}
+
+	const size_t W = workers_.size();
+	const size_t first = __sync_fetch_and_add(&next_, N);
+	for (size_t n = 0; n < N; ++n) {
+		push((first + n) % W, Job(tasks[order[n]], &group), false);
+	}
+	boost::unique_lock<boost::mutex> lock(sleep_mutex_);
+	wakeup_.notify_all();
+}
+
+/*! @brief wait for all tasks of a group to finish
+ *
+ * The calling thread executes queued tasks while it waits. If any task
+ * threw, the first error is rethrown once the group has finished
+ *
+ * @param group the group to wait on
+ */
+void TaskScheduler::wait(TaskGroup& group) {
+	join(group, false);
+}
+
+/*! @brief wait for all tasks of a group to finish, helping with that group only
+ *
+ * Unlike wait(), the calling thread only executes tasks of the group
+ * itself while it waits. It may therefore hold a lock which other queued
+ * tasks need (such as a level lock of a ResponseCache), since it never
+ * runs them. The other threads still take the group's tasks as usual
+ *
+ * @param group the group to wait on
+ */
+void TaskScheduler::waitIsolated(TaskGroup& group) {
+	join(group, true);
+}
+
+//! wait for a group, executing queued tasks (of the group only, if isolated) meanwhile
+void TaskScheduler::join(TaskGroup& group, bool isolated) {
+	while (true) {
+		{
+			boost::unique_lock<boost::mutex> lock(group.mutex_);
+			if (group.pending_ == 0) break;
+		}
+		Job job;
+		if (!workers_.empty() && (isolated ? claim(group, job) : acquire(job))) {
+			execute(job);
+			continue;
+		}
+		// nothing to help with: sleep until the group finishes, but wake
+		// periodically in case a running task spawns more work
+		boost::unique_lock<boost::mutex> lock(group.mutex_);
+		if (group.pending_ > 0) group.finished_.timed_wait(lock, boost::posix_time::milliseconds(1));
+	}
+
+	boost::unique_lock<boost::mutex> lock(group.mutex_);
+	if (!group.error_.empty()) {
+		const std::string error = group.error_;
+		group.error_.clear();
+		throw std::runtime_error(error);
+	}
+}
+
+//! take a queued (unpinned) job of the given group from any worker's deque
+bool TaskScheduler::claim(TaskGroup& group, Job& job) {
+	for (size_t w = 0; w < workers_.size(); ++w) {
+		Worker& worker = *workers_[w];
+		boost::unique_lock<boost::mutex> lock(worker.mutex);
+		for (std::deque<Job>::iterator it = worker.jobs.begin(); it != worker.jobs.end(); ++it) {
+			if (it->group != &group || it->pinned) continue;
+			job = *it;
+			worker.jobs.erase(it);
+			__sync_sub_and_fetch(&queued_, 1);
+			return true;
+		}
+	}
+	return false;
+}
+
+/*! @brief execute body(n) for n in [0, N) in parallel
+ *
+ * @param N the number of iterations
+ * @param body the loop body
+ */
+void TaskScheduler::parallelFor(size_t N, const LoopBody& body) {
+	parallelFor(N, body, vector<double>(N, 1.0));
+}
+
+/*! @brief execute body(n) for n in [0, N) in parallel, largest iterations first
+ *
+ * @param N the number of iterations
+ * @param body the loop body
+ * @param costs an estimate of the relative cost of each iteration
+ */
+void TaskScheduler::parallelFor(size_t N, const LoopBody& body, const vector<double>& costs) {
+	if (N == 0) return;
+	if (N == 1 || workers_.empty()) {
+		vector<size_t> order(N);
+		for (size_t n = 0; n < N; ++n) order[n] = n;
+		std::stable_sort(order.begin(), order.end(), DescendingCost(costs));
+		for (size_t n = 0; n < N; ++n) body(order[n]);
+		return;
+	}
+	vector<Task> tasks(N);
+	for (size_t n = 0; n < N; ++n) tasks[n] = boost::bind(body, n);
+	TaskGroup group;
+	run(group, tasks, costs);
+	wait(group);
+}
+
+/*! @brief run a task once on every thread of the scheduler
+ *
+ * This is used to set up per-thread state, such as hardware counters.
+ * It must not be called while other tasks are in flight
+ *
+ * @param task the task to run on each thread
+ */
+void TaskScheduler::onEachThread(const Task& task) {
+	TaskGroup group;
+	{
+		boost::unique_lock<boost::mutex> lock(group.mutex_);
+		group.pending_ += workers_.size();
+	}
+	for (size_t n = 0; n < workers_.size(); ++n) push(n, Job(task, &group, true), true);
+	{
+		boost::unique_lock<boost::mutex> lock(sleep_mutex_);
+		wakeup_.notify_all();
+	}
+	task();
+	// pinned jobs cannot be stolen, so just wait for the workers
+	boost::unique_lock<boost::mutex> lock(group.mutex_);
+	while (group.pending_ > 0) group.finished_.wait(lock);
+}
+
+/*! @brief split a range of rows into bands for parallel processing
+ *
+ * @param rows the number of rows
+ * @param min_rows the minimum number of rows in a band
+ * @param nbands the maximum number of bands
+ * @param bounds the output band boundaries, bounds[b] to bounds[b+1] is band b
+ */
+void TaskScheduler::bands(size_t rows, size_t min_rows, size_t nbands, vector<size_t>& bounds) {
+	min_rows = max(min_rows, (size_t)1);
+	nbands = max(min(nbands, rows / min_rows), (size_t)1);
+	bounds.resize(nbands+1);
+	for (size_t b = 0; b <= nbands; ++b) bounds[b] = b * rows / nbands;
+}
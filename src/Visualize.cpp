@@ -113,6 +113,61 @@ void Visualize::candidates(const Mat& im, const Candidate& candidate, Mat& canva
 	candidates(im, vec, canvas, display_confidence);
 }
 
+/*! @brief visualize the part locations of a set of candidates overlaid on an image
+ *
+ * @param im the image
+ * @param candidates the set of candidates
+ * @param N the number of candidates to render. If the set has been sorted,
+ * this is equivalent to displaying only the 'N best' candidates
+ * @param display_confidence display the detection confidence above each bounding box
+ * for each part
+ */
+void Visualize::candidates(const Mat& im, const CandidateSet& candidates, size_t N, Mat& canvas, bool display_confidence) const {
+
+	// create a new canvas that we can modify
+	cvtColor(im, canvas, COLOR_RGB2BGR);
+	if (candidates.empty()) return;
+
+	// generate a set of colors to display. Do this in HSV then convert it
+	const size_t ncolors = candidates.stride();
+	vector<Scalar> colors;
+	for (size_t n = 0; n < ncolors; ++n) {
+		Mat color(Size(1,1), CV_32FC3);
+		color.at<float>(0) = (360) / ncolors * n;
+		color.at<float>(1) = 1.0;
+		color.at<float>(2) = 0.7;
+		cvtColor(color, color, COLOR_HSV2BGR);
+		color = color * 255;
+		colors.push_back(Scalar(color.at<float>(0), color.at<float>(1), color.at<float>(2)));
+	}
+
+	// draw each candidate to the canvas, straight from the set's arrays
+	const int LINE_THICKNESS = 4;
+	Scalar black(0,0,0);
+	N = (candidates.size() < N) ? candidates.size() : N;
+	for (size_t n = 0; n < N; ++n) {
+		const Rect* parts = candidates.parts(n);
+		for (size_t p = 0; p < candidates.nparts(n); ++p) {
+			rectangle(canvas, parts[p], colors[p], LINE_THICKNESS);
+			if (display_confidence && p == 0) {
+				string confidence = boost::lexical_cast<string>(candidates.confidence(n)[p]);
+				putText(canvas, confidence, Point(parts[p].x, parts[p].y-5), FONT_HERSHEY_SIMPLEX, 0.5f, black, 2);
+			}
+		}
+	}
+}
+
+/*! @brief visualize all of the part locations of a set of candidates overlaid on an image
+ *
+ * @param im the image
+ * @param candidates the set of candidates
+ * @param display_confidence display the detection confidence above each bounding box
+ * for each part
+ */
+void Visualize::candidates(const Mat& im, const CandidateSet& candidates, Mat& canvas, bool display_confidence) const {
+	Visualize::candidates(im, candidates, candidates.size(), canvas, display_confidence);
+}
+
 /*! @brief display the raw image with no overlay
  *
  * @param im the input image frame
@@ -54,9 +54,17 @@ using namespace std;
 
 int main(int argc, char** argv) {
 
-	// check arguments
+	// check arguments. --profile may appear anywhere, and prints per-stage statistics
+	bool profile = false;
+	vector<char*> args;
+	for (int i = 0; i < argc; ++i) {
+		if (string(argv[i]) == "--profile") profile = true;
+		else args.push_back(argv[i]);
+	}
+	argc = args.size();
+	argv = &args[0];
 	if (argc != 3 && argc != 4) {
-		printf("Usage: PartsBasedDetector model_file image_file [depth_file]\n");
+		printf("Usage: PartsBasedDetector [--profile] model_file image_file [depth_file]\n");
 		exit(-1);
 	}
 
@@ -84,6 +92,7 @@ int main(int argc, char** argv) {
 	// create the PartsBasedDetector and distribute the model parameters
 	PartsBasedDetector<float> pbd;
 	pbd.distributeModel(*model);
+	if (profile) pbd.enableProfiling(true);
 
 	// load the image from file
 	Mat_<float> depth;
@@ -102,6 +111,7 @@ int main(int argc, char** argv) {
 	vector<Candidate> candidates;
 	pbd.detect(im, depth, candidates);
 	printf("Number of candidates: %ld\n", candidates.size());
+	if (profile) pbd.stats().print(cout);
 
 	// display the best candidates
 	Visualize visualize(model->name());
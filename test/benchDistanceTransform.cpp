@@ -0,0 +1,96 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    benchDistanceTransform.cpp
+ *  Created: Oct 16, 2026
+ */
+
+/*! @file benchDistanceTransform.cpp
+ *  @brief the 1D distance transforms of each supported tier, by sequence length
+ *
+ *  Compares the envelope transform of contiguous rows (dtf/dtd) with the
+ *  exhaustive transform of contiguous columns in place (dtbrutef/dtbruted),
+ *  which DistanceTransform uses for columns of up to Kernels::brutef (or
+ *  bruted) cells. Reports nanoseconds per sequence
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <opencv2/core/core.hpp>
+#include "CpuDispatch.hpp"
+
+//! the time per sequence of each transform, of sequences of length n
+template<typename T>
+void bench(const CpuDispatch::Kernels& k, int n, void (*dt)(const T*, T*, int*, int*, T*, int, double, double, int),
+		void (*brute)(const T*, T*, int*, int, int, int, double, double, int)) {
+
+	const int L = k.lanes;
+	const int cols = 64*L;
+	const int reps = 256;
+	std::vector<T> src(n*cols), dst(n*cols), z(n+1);
+	std::vector<int> ptr(n*cols), v(n);
+	for (size_t i = 0; i < src.size(); ++i) src[i] = -(T)(rand() % 1000) / 100;
+	const double a = -0.05, b = 0.01;
+
+	// the envelope, over cols rows of length n
+	int64_t start = cv::getTickCount();
+	for (int r = 0; r < reps; ++r) {
+		for (int c = 0; c < cols; ++c) dt(&src[c*n], &dst[c*n], &ptr[c*n], &v[0], &z[0], n, a, b, -1);
+	}
+	const double envelope = (double)(cv::getTickCount() - start) / cv::getTickFrequency();
+
+	// exhaustive search, over cols columns of length n, L at a time
+	start = cv::getTickCount();
+	for (int r = 0; r < reps; ++r) {
+		for (int c = 0; c < cols; c += L) brute(&src[c], &dst[c], &ptr[c], n, L, cols, a, b, -1);
+	}
+	const double exhaustive = (double)(cv::getTickCount() - start) / cv::getTickFrequency();
+
+	const double scale = 1e9 / ((double)reps * cols);
+	printf("  n = %3d   dt %8.1f ns   brute %8.1f ns\n", n, envelope*scale, exhaustive*scale);
+}
+
+int main() {
+	typedef bool (*Filler)(CpuDispatch::Kernels&);
+	const Filler fillers[] = { CpuDispatch::fillGeneric, CpuDispatch::fillSSE41, CpuDispatch::fillAVX2, CpuDispatch::fillAVX512 };
+	for (int t = CpuDispatch::GENERIC; t <= CpuDispatch::supported(); ++t) {
+		CpuDispatch::Kernels k;
+		if (!fillers[t](k)) continue;
+		printf("%s (%d lanes), float\n", CpuDispatch::name((CpuDispatch::Tier)t), k.lanes);
+		for (int n = 4; n <= 64; n *= 2) bench<float>(k, n, k.dtf, k.dtbrutef);
+		printf("%s (%d lanes), double\n", CpuDispatch::name((CpuDispatch::Tier)t), k.lanes);
+		for (int n = 4; n <= 64; n *= 2) bench<double>(k, n, k.dtd, k.dtbruted);
+	}
+	return 0;
+}
@@ -0,0 +1,167 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    testArgminOrder.cpp
+ *  Created: Oct 16, 2026
+ */
+
+/*! @file testArgminOrder.cpp
+ *  @brief the candidates of DynamicProgram::argmin do not depend on the number of threads
+ *
+ *  argmin() splits the hits of every scale and component into bands which
+ *  are backtracked in parallel, then concatenates the bands in order. This
+ *  runs the dynamic program over random responses of a random model once,
+ *  then backtracks the same tables with 1 and with several scheduler
+ *  threads, and compares the candidate vectors element-wise. Returns the
+ *  number of failed cases
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <opencv2/core/core.hpp>
+#include "DynamicProgram.hpp"
+#include "Parts.hpp"
+#include "TaskScheduler.hpp"
+#include "types.hpp"
+
+//! a uniformly distributed random number in [lo, hi)
+static float uniform(float lo, float hi) {
+	return lo + (hi - lo) * (float)rand() / ((float)RAND_MAX + 1);
+}
+
+/*! @brief a random model of C components, each a tree of P parts with K mixtures
+ *
+ * Part p > 0 of each component hangs off a random earlier part. The filters
+ * are blank, since the responses are made up, but their size sets the boxes
+ */
+static Parts randomParts(size_t C, size_t P, size_t K) {
+	vectorMat filtersw;
+	vectori filtersi, defi, biasi;
+	vector2Df defw;
+	vectorf biasw;
+	vectorPoint anchors;
+	vector3Di biasid(C, vector2Di(P, vectori(K))), filterid(C, vector2Di(P, vectori(K))), defid(C, vector2Di(P, vectori(K)));
+	vector2Di parentid(C, vectori(P, 0));
+
+	for (size_t c = 0; c < C; ++c) {
+		for (size_t p = 0; p < P; ++p) {
+			if (p > 0) parentid[c][p] = rand() % p;
+			for (size_t k = 0; k < K; ++k) {
+				const int size = (p == 0) ? 8 : 5;
+				filterid[c][p][k] = filtersw.size();
+				filtersi.push_back(filtersw.size());
+				filtersw.push_back(cv::Mat::zeros(size, size*32, cv::DataType<float>::type));
+
+				// a bias for each mixture of the parent
+				biasid[c][p][k] = biasw.size();
+				for (size_t pk = 0; pk < K; ++pk) {
+					biasi.push_back(biasw.size());
+					biasw.push_back(uniform(-0.5, 0.5));
+				}
+
+				defid[c][p][k] = defw.size();
+				defi.push_back(defw.size());
+				vectorf w(4);
+				w[0] = uniform(0.01, 0.1);
+				w[1] = uniform(-0.05, 0.05);
+				w[2] = uniform(0.01, 0.1);
+				w[3] = uniform(-0.05, 0.05);
+				defw.push_back(w);
+				anchors.push_back(cv::Point(rand() % 7, rand() % 7));
+			}
+		}
+	}
+	return Parts(filtersw, filtersi, defw, defi, biasw, biasi, anchors, biasid, filterid, defid, parentid);
+}
+
+//! whether two candidates are identical, part by part
+static bool equal(const Candidate& a, const Candidate& b) {
+	if (a.component() != b.component()) return false;
+	if (a.parts() != b.parts() || a.confidence() != b.confidence()) return false;
+	return true;
+}
+
+//! run one random case with the given number of threads, and return whether it passed
+static bool check(int trial, size_t nthreads) {
+
+	const size_t C = 1 + rand() % 3;
+	const size_t P = 2 + rand() % 6;
+	const size_t K = 1 + rand() % 3;
+	Parts parts = randomParts(C, P, K);
+
+	// random responses over a pyramid of levels
+	const size_t L = 2 + rand() % 5;
+	vector2DMat scores(L, vectorMat(parts.filters().size()));
+	vectorf scales(L);
+	for (size_t l = 0; l < L; ++l) {
+		const int rows = 64 >> (l / 2), cols = 80 >> (l / 2);
+		scales[l] = (float)(1 << (l / 2));
+		for (size_t f = 0; f < scores[l].size(); ++f) {
+			cv::Mat_<float> response(rows, cols);
+			for (int m = 0; m < rows; ++m) for (int n = 0; n < cols; ++n) response(m, n) = uniform(-1, 1);
+			scores[l][f] = response;
+		}
+	}
+
+	// a threshold low enough that the hits of each scale span several bands
+	DynamicProgram<float> dp(P * 0.5, parts);
+	DPTensor<float> tables;
+	dp.min(scores, tables);
+
+	TaskScheduler& scheduler = TaskScheduler::global();
+	vectorCandidate serial, parallel;
+	scheduler.configure(1);
+	dp.argmin(tables, scales, serial);
+	scheduler.configure(nthreads);
+	dp.argmin(tables, scales, parallel);
+
+	bool ok = !serial.empty() && serial.size() == parallel.size();
+	for (size_t i = 0; ok && i < serial.size(); ++i) ok = equal(serial[i], parallel[i]);
+	if (!ok) {
+		printf("  trial %d: %lu components, %lu parts, %lu mixtures, %lu threads: %lu serial and %lu parallel candidates differ\n",
+				trial, C, P, K, nthreads, serial.size(), parallel.size());
+	}
+	return ok;
+}
+
+int main() {
+	srand(0);
+	int failed = 0;
+	const size_t threads[] = { 2, 3, 4, 8 };
+	for (int trial = 0; trial < 20; ++trial) {
+		failed += !check(trial, threads[trial % 4]);
+	}
+	TaskScheduler::global().configure(0);
+	printf("argmin: %d failed\n", failed);
+	return failed;
+}
@@ -0,0 +1,141 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    testDistanceTransform.cpp
+ *  Created: Oct 16, 2026
+ */
+
+/*! @file testDistanceTransform.cpp
+ *  @brief the bounded distance transform against the unbounded transform
+ *
+ *  Both transforms are checked against an exhaustive reference on random
+ *  levels with random concave penalties. The radius is often larger than
+ *  the level, so rows and columns shorter than the radius are covered.
+ *  Half of the cases draw their scores from a handful of values, so most
+ *  maxima are tied. Their scores and penalty coefficients are multiples
+ *  of 1/8, so every sum is exact and the values are compared exactly. The
+ *  other half draw continuous scores, and where every source lies within
+ *  the radius, the argmaxes must also agree. Returns the number of failed
+ *  cases
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <opencv2/core/core.hpp>
+#include "DistanceTransform.hpp"
+
+//! the sources considered for output q of a sequence of n: within R of q+os, or the nearest if none is
+static void sources(int q, int n, int os, int R, int& v0, int& v1) {
+	const int c = q + os;
+	v0 = std::max(0, c - R);
+	v1 = std::min(n-1, c + R);
+	if (v0 > v1) v0 = v1 = std::max(0, std::min(n-1, c));
+}
+
+//! the exhaustive transform of a level over the given sources
+template<typename T>
+static T reference(const cv::Mat_<T>& in, const Quadratic& fx, const Quadratic& fy, cv::Point os, cv::Size radius, int m, int n) {
+	int x0, x1, y0, y1;
+	sources(n, in.cols, os.x, radius.width, x0, x1);
+	sources(m, in.rows, os.y, radius.height, y0, y1);
+	T best = -std::numeric_limits<T>::infinity();
+	for (int y = y0; y <= y1; ++y) {
+		for (int x = x0; x <= x1; ++x) {
+			const int dx = n + os.x - x;
+			const int dy = m + os.y - y;
+			best = std::max(best, (T)(in(y, x) + fx(dx, 0.0) + fy(dy, 0.0)));
+		}
+	}
+	return best;
+}
+
+//! run one random case, and return whether it passed
+template<typename T>
+static bool check(int trial, bool ties) {
+
+	const int M = 1 + rand() % 24;
+	const int N = 1 + rand() % 24;
+	const cv::Size radius(1 + rand() % 16, 1 + rand() % 16);
+	const cv::Point os(rand() % 9 - 4, rand() % 9 - 4);
+	const Quadratic fx(-(1 + rand() % 8) / 8.0, (rand() % 9 - 4) / 8.0);
+	const Quadratic fy(-(1 + rand() % 8) / 8.0, (rand() % 9 - 4) / 8.0);
+
+	cv::Mat_<T> in(M, N);
+	for (int m = 0; m < M; ++m) {
+		for (int n = 0; n < N; ++n) in(m, n) = ties ? -(T)(rand() % 3) : -(T)rand() / RAND_MAX * 64;
+	}
+
+	DistanceTransform<T> dt;
+	cv::Mat_<T> full, bounded;
+	cv::Mat_<int> Ix, Iy, Ixb, Iyb;
+	dt.compute(in, fx, fy, os, full, Ix, Iy);
+	dt.compute(in, fx, fy, os, radius, bounded, Ixb, Iyb);
+
+	const cv::Size unbounded(M + N + 16, M + N + 16);
+	const bool within = radius.width >= N + std::abs(os.x) && radius.height >= M + std::abs(os.y);
+	int errors = 0;
+	for (int m = 0; m < M; ++m) {
+		for (int n = 0; n < N; ++n) {
+			const T expect_full = reference(in, fx, fy, os, unbounded, m, n);
+			const T expect_bounded = reference(in, fx, fy, os, radius, m, n);
+			const T tolerance = ties ? 0 : 1e-4 * (1 + std::abs(expect_full));
+			bool ok = std::abs(full(m, n) - expect_full) <= tolerance && std::abs(bounded(m, n) - expect_bounded) <= tolerance;
+			if (within && !ties) ok = ok && Ix(m, n) == Ixb(m, n) && Iy(m, n) == Iyb(m, n);
+			if (!ok && errors++ == 0) {
+				printf("  trial %d: %dx%d, radius %dx%d, offset (%d,%d), at (%d,%d): full %g (expected %g), bounded %g (expected %g)\n",
+						trial, M, N, radius.height, radius.width, os.y, os.x, m, n,
+						(double)full(m, n), (double)expect_full, (double)bounded(m, n), (double)expect_bounded);
+			}
+		}
+	}
+	return errors == 0;
+}
+
+template<typename T>
+static int run(const char* name) {
+	int failed = 0;
+	for (int trial = 0; trial < 500; ++trial) {
+		failed += !check<T>(trial, true);
+		failed += !check<T>(trial, false);
+	}
+	printf("%s: %d failed\n", name, failed);
+	return failed;
+}
+
+int main() {
+	srand(0);
+	return run<float>("float") + run<double>("double");
+}